@@ -50,7 +50,7 @@ int main(int argc, char **argv) {
         filename = Platform::Path::From(args[2]);
     } else {
         fprintf(stderr, "Usage: %s [mode] [filename]\n", args[0].c_str());
-        fprintf(stderr, "Mode can be one of: load.\n");
+        fprintf(stderr, "Mode can be one of: load, parse.\n");
         return 1;
     }
 
@@ -70,6 +70,19 @@ int main(int argc, char **argv) {
                 SK.Clear();
                 SS.Clear();
             });
+    } else if(mode == "parse") {
+        // Only reading the file and the files it links, without regenerating.
+        result = RunBenchmark(
+            [] {
+                SS.Init();
+            },
+            [&] {
+                return SS.LoadFromFile(filename);
+            },
+            [] {
+                SK.Clear();
+                SS.Clear();
+            });
     } else {
         fprintf(stderr, "Unknown mode \"%s\"\n", mode.c_str());
     }
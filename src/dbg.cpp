@@ -121,12 +121,14 @@ void SDump::_DoubleList(const char *name, List<double> *list) {
 void SDump::_Entity(const char *name, const Entity *e) {
     std::string s;
     if (e->h.isFromRequest()) {
-        Request *r = SK.GetRequest(e->h.request());
-        s = r->DescriptionString();
+        // A linked file's entities may come from requests and groups that
+        // this sketch doesn't have.
+        Request *r = SK.request.FindByIdNoOops(e->h.request());
+        if(r) s = r->DescriptionString();
     }
     else {
-        Group *g = SK.GetGroup(e->h.group());
-        s = ssprintf("g%03x-%s", g->h.v, g->TypeToString().c_str());
+        Group *g = SK.group.FindByIdNoOops(e->h.group());
+        if(g) s = ssprintf("g%03x-%s", g->h.v, g->TypeToString().c_str());
     }
     dbp("%s=%08x %s type=%s", name, e->h.v, s.c_str(), e->TypeToString().c_str());
     s = _Int("  construction", e->construction);
@@ -398,6 +398,310 @@ GraphicsWindow::Selection GraphicsWindow::ChooseFromHoverToDrag() {
     return sel;
 }
 
+//-----------------------------------------------------------------------------
+// A bounding volume hierarchy, split at the median along the longest axis of
+// the item centers. The nodes are stored in depth-first order, so that every
+// child comes after its parent.
+//-----------------------------------------------------------------------------
+void GraphicsWindow::PickIndex::Clear() {
+    items.clear();
+    nodes.clear();
+    unbounded.clear();
+    source.clear();
+    dirty = true;
+}
+
+static const int PICK_INDEX_LEAF_SIZE = 4;
+
+static int BuildPickIndexNode(std::vector<GraphicsWindow::PickIndex::Item> *items,
+                              std::vector<GraphicsWindow::PickIndex::Node> *nodes,
+                              int first, int count) {
+    int index = (int)nodes->size();
+    nodes->emplace_back();
+
+    GraphicsWindow::PickIndex::Node node = {};
+    node.bbox = (*items)[first].bbox;
+    BBox centers = BBox::From((*items)[first].bbox.GetOrigin(),
+                              (*items)[first].bbox.GetOrigin());
+    for(int i = first; i < first + count; i++) {
+        const GraphicsWindow::PickIndex::Item &item = (*items)[i];
+        node.bbox.Include(item.bbox.minp);
+        node.bbox.Include(item.bbox.maxp);
+        node.margin = std::max(node.margin, item.margin);
+        centers.Include(item.bbox.GetOrigin());
+    }
+
+    if(count <= PICK_INDEX_LEAF_SIZE) {
+        node.first = first;
+        node.count = count;
+    } else {
+        Vector extent = centers.maxp.Minus(centers.minp);
+        int axis = 0;
+        if(extent.y > extent.Element(axis)) axis = 1;
+        if(extent.z > extent.Element(axis)) axis = 2;
+
+        int half = count / 2;
+        auto begin = items->begin() + first;
+        std::nth_element(begin, begin + half, begin + count,
+            [&](const GraphicsWindow::PickIndex::Item &a,
+                const GraphicsWindow::PickIndex::Item &b) {
+                return a.bbox.GetOrigin().Element(axis) < b.bbox.GetOrigin().Element(axis);
+            });
+
+        BuildPickIndexNode(items, nodes, first, half);
+        node.first = BuildPickIndexNode(items, nodes, first + half, count - half);
+        node.count = 0;
+    }
+    (*nodes)[index] = node;
+    return index;
+}
+
+void GraphicsWindow::PickIndex::Build() {
+    nodes.clear();
+    if(!items.empty()) {
+        nodes.reserve(2 * items.size() / PICK_INDEX_LEAF_SIZE + 1);
+        BuildPickIndexNode(&items, &nodes, 0, (int)items.size());
+    }
+    dirty = false;
+}
+
+// The items keep their place in the tree and only their boxes have changed,
+// so recompute the node boxes from the bottom up.
+void GraphicsWindow::PickIndex::Refit() {
+    for(int i = (int)nodes.size() - 1; i >= 0; i--) {
+        Node *node = &nodes[i];
+        if(node->count > 0) {
+            node->bbox   = items[node->first].bbox;
+            node->margin = 0.0;
+            for(int j = node->first; j < node->first + node->count; j++) {
+                node->bbox.Include(items[j].bbox.minp);
+                node->bbox.Include(items[j].bbox.maxp);
+                node->margin = std::max(node->margin, items[j].margin);
+            }
+        } else {
+            const Node &left  = nodes[i + 1],
+                       &right = nodes[node->first];
+            node->bbox = left.bbox;
+            node->bbox.Include(right.bbox.minp);
+            node->bbox.Include(right.bbox.maxp);
+            node->margin = std::max(left.margin, right.margin);
+        }
+    }
+    dirty = false;
+}
+
+void GraphicsWindow::PickIndex::Query(const std::function<bool(const BBox &, double)> &isNear,
+                                      std::vector<uint32_t> *found) const {
+    found->insert(found->end(), unbounded.begin(), unbounded.end());
+    if(nodes.empty()) return;
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()) {
+        const Node &node = nodes[stack.back()];
+        int index = stack.back();
+        stack.pop_back();
+        if(!isNear(node.bbox, node.margin)) continue;
+
+        if(node.count > 0) {
+            for(int i = node.first; i < node.first + node.count; i++) {
+                if(isNear(items[i].bbox, items[i].margin)) {
+                    found->push_back(items[i].v);
+                }
+            }
+        } else {
+            stack.push_back(node.first);
+            stack.push_back(index + 1);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Find a box in model space around everything that Entity::Draw could pick,
+// plus a margin in pixels for the parts that are drawn at a fixed size on the
+// screen, not counting the stroke width. Returns false for the entities that
+// don't have useful bounds, like workplanes, whose size depends on the view.
+//-----------------------------------------------------------------------------
+static bool GetEntityPickBounds(Entity *e, BBox *bbox, double *margin) {
+    if(e->IsPoint()) {
+        Vector p = e->PointGetNum();
+        *bbox   = BBox::From(p, p);
+        // The big square that's drawn over free points, in analyze mode.
+        *margin = 7.0;
+        return true;
+    } else if(e->IsNormal()) {
+        // The reference axes are drawn in the corner of the screen.
+        if(e->h.request().IsFromReferences()) return false;
+        Vector p = SK.GetEntity(e->point[0])->PointGetNum();
+        *bbox   = BBox::From(p, p);
+        // The arrow, plus a pixel for the alignment to the pixel grid.
+        *margin = 51.0;
+        return true;
+    } else if(e->type == Entity::Type::IMAGE || e->type == Entity::Type::WORKPLANE) {
+        return false;
+    }
+
+    SBezierList *sbl = e->GetOrGenerateBezierCurves();
+    if(sbl->l.IsEmpty()) return false;
+    // The curves lie within the hull of their control points.
+    *bbox = BBox::From(sbl->l[0].ctrl[0], sbl->l[0].ctrl[0]);
+    for(const SBezier &sb : sbl->l) {
+        for(int i = 0; i <= sb.deg; i++) {
+            bbox->Include(sb.ctrl[i]);
+        }
+    }
+    *margin = 0.0;
+    // Make sure the style exists before we rely on its width.
+    Style::Get(Style::ForEntity(e->h));
+    return true;
+}
+
+// The farthest that a stroke may reach past the geometry it's drawn along.
+static double GetStrokeMargin() {
+    double strokeMargin = 0.0;
+    for(const Style &s : SK.style) {
+        strokeMargin = std::max(strokeMargin, Style::Width(s.h) / 2.0);
+    }
+    return strokeMargin;
+}
+
+// Project a box in model space onto the screen. Returns false if a part of it
+// is behind the eye, since then its projection isn't bounded.
+static bool ProjectBBox(const Camera &camera, const BBox &bbox, BBox *screen) {
+    for(int i = 0; i < 8; i++) {
+        Vector p = Vector::From((i & 1) ? bbox.maxp.x : bbox.minp.x,
+                                (i & 2) ? bbox.maxp.y : bbox.minp.y,
+                                (i & 4) ? bbox.maxp.z : bbox.minp.z);
+        double w;
+        p = camera.ProjectPoint4(p, &w);
+        if(w <= 0.0) return false;
+        p = p.ScaledBy(camera.scale / w);
+        if(i == 0) {
+            *screen = BBox::From(p, p);
+        } else {
+            screen->Include(p);
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Whether whatever is drawn within a box in model space, plus a margin in
+// pixels, can be left out of the frame: because it's entirely off the screen,
+// or because it's all within a pixel and nothing in it is drawn at a fixed
+// size on the screen.
+//-----------------------------------------------------------------------------
+static bool IsCulled(const Camera &camera, const BBox &bbox, double margin,
+                     double strokeMargin) {
+    BBox screen;
+    if(!ProjectBBox(camera, bbox, &screen)) return false;
+
+    double r = margin + strokeMargin;
+    if(screen.maxp.x + r < -camera.width / 2.0  || screen.minp.x - r > camera.width / 2.0 ||
+       screen.maxp.y + r < -camera.height / 2.0 || screen.minp.y - r > camera.height / 2.0) {
+        return true;
+    }
+
+    double pixel = 1.0 / camera.pixelRatio;
+    return margin == 0.0 &&
+           screen.maxp.x - screen.minp.x < pixel &&
+           screen.maxp.y - screen.minp.y < pixel;
+}
+
+// The normals and workplanes are drawn at a size that depends on the view.
+static bool IsPersistentEntity(const Entity &e) {
+    return !(e.IsNormal() || e.IsWorkplane());
+}
+
+void GraphicsWindow::UpdateEntityIndex() {
+    if(!entityIndex.dirty) return;
+
+    // If the entities are the same ones as before, then the shape of the tree
+    // is still good, and only the boxes need updating.
+    bool canRefit = (entityIndex.source.size() == (size_t)SK.entity.n) &&
+                    !entityIndex.nodes.empty();
+    if(canRefit) {
+        size_t i = 0;
+        for(Entity &e : SK.entity) {
+            if(entityIndex.source[i++] != e.h.v) {
+                canRefit = false;
+                break;
+            }
+        }
+    }
+    for(PickIndex *index : { &entityIndex, &viewEntityIndex }) {
+        if(!canRefit) break;
+        for(PickIndex::Item &item : index->items) {
+            Entity *e = SK.GetEntity({ item.v });
+            if(!GetEntityPickBounds(e, &item.bbox, &item.margin)) {
+                canRefit = false;
+                break;
+            }
+        }
+    }
+    if(canRefit) {
+        entityIndex.Refit();
+        viewEntityIndex.Refit();
+        return;
+    }
+
+    entityIndex.Clear();
+    viewEntityIndex.Clear();
+    for(Entity &e : SK.entity) {
+        entityIndex.source.push_back(e.h.v);
+        // These are never drawn; faces are picked from the mesh.
+        if(e.IsFace() || e.IsDistance()) continue;
+
+        PickIndex *index = IsPersistentEntity(e) ? &entityIndex : &viewEntityIndex;
+        PickIndex::Item item = {};
+        item.v = e.h.v;
+        if(GetEntityPickBounds(&e, &item.bbox, &item.margin)) {
+            index->items.push_back(item);
+        } else {
+            index->unbounded.push_back(e.h.v);
+        }
+    }
+    entityIndex.Build();
+    viewEntityIndex.Build();
+}
+
+// The labels are drawn the same wherever the view is panned to, except for
+// their alignment to the pixel grid.
+bool GraphicsWindow::ConstraintIndexIsCurrent(const Camera &camera) {
+    if(!camera.projRight.EqualsExactly(constraintIndexView.projRight) ||
+           !camera.projUp.EqualsExactly(constraintIndexView.projUp) ||
+           EXACT(camera.scale != constraintIndexView.scale)) {
+        constraintIndex.dirty = true;
+    }
+    return !constraintIndex.dirty;
+}
+
+void GraphicsWindow::UpdateConstraintIndex(const Camera &camera) {
+    if(ConstraintIndexIsCurrent(camera)) return;
+
+    constraintIndex.Clear();
+    constraintIndexView.projRight = camera.projRight;
+    constraintIndexView.projUp    = camera.projUp;
+    constraintIndexView.scale     = camera.scale;
+    ObjectPicker canvas = {};
+    canvas.camera = camera;
+    for(Constraint &c : SK.constraint) {
+        canvas.Pick([&]{ c.Draw(Constraint::DrawAs::DEFAULT, &canvas); });
+        if(canvas.hasExtents) {
+            PickIndex::Item item = {};
+            item.bbox   = canvas.extents;
+            item.margin = canvas.extentsMargin + 1.0;
+            item.v      = c.h.v;
+            constraintIndex.items.push_back(item);
+        } else {
+            // Not drawn right now, but that's not cached with the layout.
+            constraintIndex.unbounded.push_back(c.h.v);
+        }
+    }
+    canvas.Clear();
+    constraintIndex.Build();
+}
+
 void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
     hoverList = {};
     Selection sel = {};
@@ -422,9 +726,26 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
     canvas.point     = mp;
     canvas.maxZIndex = -1;
 
+    // Anything drawn with a stroke may be picked up to half its width away
+    // from where it really is.
+    double strokeMargin = GetStrokeMargin();
+
     // Always do the entities; we might be dragging something that should
     // be auto-constrained, and we need the hover for that.
-    for(Entity &e : SK.entity) {
+    UpdateEntityIndex();
+    std::vector<uint32_t> candidates;
+    auto isNearEntity = [&](const BBox &bbox, double margin) {
+        BBox screen;
+        if(!ProjectBBox(canvas.camera, bbox, &screen)) return true;
+        return screen.Contains(mp, canvas.selRadius + strokeMargin + margin);
+    };
+    entityIndex.Query(isNearEntity, &candidates);
+    viewEntityIndex.Query(isNearEntity, &candidates);
+    // Visit them in the same order as the list, for the same tie-breaking.
+    std::sort(candidates.begin(), candidates.end());
+
+    for(uint32_t v : candidates) {
+        Entity &e = *SK.GetEntity({ v });
         if(!e.IsVisible()) continue;
 
         // If faces aren't selectable, image entities aren't either.
@@ -456,7 +777,17 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
     // The constraints and faces happen only when nothing's in progress.
     if(pending.operation == Pending::NONE) {
         // Constraints
-        for(Constraint &c : SK.constraint) {
+        UpdateConstraintIndex(canvas.camera);
+        candidates.clear();
+        constraintIndex.Query([&](const BBox &bbox, double margin) {
+            BBox screen;
+            if(!ProjectBBox(canvas.camera, bbox, &screen)) return true;
+            return screen.Contains(mp, canvas.selRadius + margin);
+        }, &candidates);
+        std::sort(candidates.begin(), candidates.end());
+
+        for(uint32_t v : candidates) {
+            Constraint &c = *SK.GetConstraint({ v });
             if(canvas.Pick([&]{ c.Draw(Constraint::DrawAs::DEFAULT, &canvas); })) {
                 Hover hov = {};
                 hov.distance = canvas.minDistance;
@@ -465,6 +796,9 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
                 hoverList.Add(&hov);
             }
         }
+    } else {
+        // Whatever's in progress may move the labels around.
+        constraintIndex.dirty = true;
     }
 
     std::sort(hoverList.begin(), hoverList.end(),
@@ -478,9 +812,7 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
         // Faces, from the triangle mesh; these are lowest priority
         if(sel.constraint.v == 0 && sel.entity.v == 0 && showShaded && showFaces) {
             Group *g = SK.GetGroup(activeGroup);
-            SMesh *m = &(g->displayMesh);
-
-            uint32_t v = m->FirstIntersectionWith(mp);
+            uint32_t v = g->FirstFaceIntersectionWith(mp);
             if(v) {
                 sel.entity.v = v;
             }
@@ -656,22 +988,42 @@ void GraphicsWindow::DrawSnapGrid(Canvas *canvas) {
     }
 }
 
+static void DrawEntityForView(Entity *e, Canvas *canvas) {
+    switch(SS.GW.drawOccludedAs) {
+        case GraphicsWindow::DrawOccludedAs::VISIBLE:
+            e->Draw(Entity::DrawAs::OVERLAY, canvas);
+            break;
+
+        case GraphicsWindow::DrawOccludedAs::STIPPLED:
+            e->Draw(Entity::DrawAs::HIDDEN, canvas);
+            /* fallthrough */
+        case GraphicsWindow::DrawOccludedAs::INVISIBLE:
+            e->Draw(Entity::DrawAs::DEFAULT, canvas);
+            break;
+    }
+}
+
 void GraphicsWindow::DrawEntities(Canvas *canvas, bool persistent) {
-    for(Entity &e : SK.entity) {
-        if(persistent == (e.IsNormal() || e.IsWorkplane())) continue;
-        switch(SS.GW.drawOccludedAs) {
-            case DrawOccludedAs::VISIBLE:
-                e.Draw(Entity::DrawAs::OVERLAY, canvas);
-                break;
+    const Camera &camera = canvas->GetCamera();
 
-            case DrawOccludedAs::STIPPLED:
-                e.Draw(Entity::DrawAs::HIDDEN, canvas);
-                /* fallthrough */
-            case DrawOccludedAs::INVISIBLE:
-                e.Draw(Entity::DrawAs::DEFAULT, canvas);
-                break;
-        }
+    UpdateEntityIndex();
+    const PickIndex &index = persistent ? entityIndex : viewEntityIndex;
+    double strokeMargin = GetStrokeMargin();
+    std::vector<uint32_t> visible;
+    index.Query([&](const BBox &bbox, double margin) {
+        return !IsCulled(camera, bbox, margin, strokeMargin);
+    }, &visible);
+    // Draw them in the same order as the list.
+    std::sort(visible.begin(), visible.end());
+
+    for(uint32_t v : visible) {
+        DrawEntityForView(SK.GetEntity({ v }), canvas);
     }
+
+    // Everything that's ever drawn is indexed, with a box or without.
+    int entities = (int)(index.items.size() + index.unbounded.size());
+    cullStats.entities       += entities;
+    cullStats.entitiesCulled += entities - (int)visible.size();
 }
 
 void GraphicsWindow::DrawPersistent(Canvas *canvas) {
@@ -692,6 +1044,221 @@ void GraphicsWindow::DrawPersistent(Canvas *canvas) {
     }
 }
 
+//-----------------------------------------------------------------------------
+// The fingerprints of the persistent batches. Each one covers everything that
+// the drawing of its batch reads and that a regeneration may change; changes
+// to the styles or to most view settings redraw all batches anyway.
+//-----------------------------------------------------------------------------
+class BatchKey {
+public:
+    uint64_t h = 14695981039346656037ULL;
+
+    void Add(uint64_t v) {
+        h = (h ^ v) * 1099511628211ULL;
+        h ^= h >> 29;
+    }
+    void Add(double v) {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        Add(bits);
+    }
+    void Add(const Vector &v) {
+        Add(v.x);
+        Add(v.y);
+        Add(v.z);
+    }
+    void Add(const std::string &str) {
+        Add((uint64_t)str.size());
+        for(char c : str) Add((uint64_t)(unsigned char)c);
+    }
+};
+
+static void AddViewSettings(BatchKey *key) {
+    GraphicsWindow *gw = &SS.GW;
+    key->Add((uint64_t)gw->drawOccludedAs);
+    key->Add((uint64_t)(gw->showShaded | gw->showEdges << 1 | gw->showOutlines << 2 |
+                        gw->showMesh << 3 | gw->dimSolidModel << 4 | gw->showPoints << 5 |
+                        gw->showConstruction << 6 | SS.drawBackFaces << 7 |
+                        SS.checkClosedContour << 8));
+}
+
+uint64_t GraphicsWindow::PersistentSolidKey() {
+    Group *g = SK.GetGroup(activeGroup);
+    g->GenerateDisplayItems();
+
+    BatchKey key;
+    AddViewSettings(&key);
+    key.Add((uint64_t)g->h.v);
+    key.Add((uint64_t)meshLod);
+    key.Add(g->displayGeneration);
+    return key.h;
+}
+
+void GraphicsWindow::PersistentEntityKeys(std::map<uint32_t, uint64_t> *keys) {
+    std::map<uint32_t, BatchKey> groupKeys;
+    for(Entity &e : SK.entity) {
+        if(!IsPersistentEntity(e)) continue;
+
+        auto it = groupKeys.find(e.group.v);
+        if(it == groupKeys.end()) {
+            it = groupKeys.emplace(e.group.v, BatchKey()).first;
+            AddViewSettings(&it->second);
+            it->second.Add((uint64_t)(e.group == activeGroup));
+        }
+        BatchKey *key = &it->second;
+
+        key->Add((uint64_t)e.h.v);
+        key->Add((uint64_t)e.type);
+        key->Add((uint64_t)e.style.v);
+        key->Add((uint64_t)(e.construction | e.IsVisible() << 1));
+        // The degrees of freedom are shown on the points and circles.
+        for(hParam hp : e.param) {
+            if(hp.v == 0) continue;
+            key->Add((uint64_t)SK.GetParam(hp)->free);
+        }
+
+        if(e.IsPoint()) {
+            key->Add(e.PointGetNum());
+        } else if(e.type == Entity::Type::IMAGE) {
+            key->Add(e.file.raw);
+        } else {
+            bool isCurved = false;
+            for(const SBezier &sb : e.GetOrGenerateBezierCurves()->l) {
+                for(int i = 0; i <= sb.deg; i++) {
+                    key->Add(sb.ctrl[i]);
+                    key->Add(sb.weight[i]);
+                }
+                if(sb.deg > 1) isCurved = true;
+            }
+            // Curves are drawn as piecewise linear edges.
+            if(isCurved) key->Add(SS.ChordTolMm());
+        }
+    }
+
+    keys->clear();
+    for(auto &it : groupKeys) {
+        (*keys)[it.first] = it.second.h;
+    }
+}
+
+uint64_t GraphicsWindow::PersistentFillsKey() {
+    BatchKey key;
+    AddViewSettings(&key);
+    key.Add((uint64_t)activeGroup.v);
+    for(hGroup hg : SK.groupOrder) {
+        Group *g = SK.GetGroup(hg);
+        if(!(g->IsVisible())) continue;
+
+        key.Add((uint64_t)hg.v);
+        key.Add((uint64_t)g->polyError.how);
+        for(const SBezierLoopSet &sbls : g->bezierLoops.l) {
+            for(const SBezierLoop &sbl : sbls.l) {
+                for(const SBezier &sb : sbl.l) {
+                    key.Add((uint64_t)sb.auxA);
+                    for(int i = 0; i <= sb.deg; i++) {
+                        key.Add(sb.ctrl[i]);
+                        key.Add(sb.weight[i]);
+                    }
+                }
+            }
+        }
+    }
+    return key.h;
+}
+
+static void UpdatePersistentBatch(GraphicsWindow::PersistentBatch *batch, uint64_t key,
+                                  bool force, const std::function<void(Canvas *)> &drawFn) {
+    if(batch->canvas == NULL) {
+        batch->canvas = SS.GW.canvas->CreateBatch();
+    } else if(!force && batch->key == key) {
+        return;
+    }
+    batch->canvas->Clear();
+    drawFn(&*batch->canvas);
+    batch->canvas->Finalize();
+    batch->key = key;
+}
+
+// Find the bounds of a batch of entities from their bounds for picking.
+static void FindBatchBounds(const std::vector<Entity *> &entities,
+                            GraphicsWindow::PersistentBatch *batch) {
+    batch->bounded = false;
+    batch->margin  = 0.0;
+    for(Entity *e : entities) {
+        if(e->IsFace() || e->IsDistance()) continue;
+
+        BBox bbox;
+        double margin;
+        if(!GetEntityPickBounds(e, &bbox, &margin)) {
+            batch->bounded = false;
+            return;
+        }
+        if(!batch->bounded) {
+            batch->bbox    = bbox;
+            batch->bounded = true;
+        } else {
+            batch->bbox.Include(bbox.minp);
+            batch->bbox.Include(bbox.maxp);
+        }
+        batch->margin = std::max(batch->margin, margin);
+    }
+}
+
+void GraphicsWindow::UpdatePersistent() {
+    bool force = persistentDirty;
+    persistentDirty       = false;
+    persistentRegenerated = false;
+
+    Group *g = SK.GetGroup(activeGroup);
+    UpdatePersistentBatch(&persistentSolid, PersistentSolidKey(), force,
+                          [&](Canvas *canvas) { g->Draw(canvas); });
+
+    std::map<uint32_t, uint64_t> keys;
+    PersistentEntityKeys(&keys);
+    for(auto it = persistentEntities.begin(); it != persistentEntities.end();) {
+        if(keys.find(it->first) == keys.end()) {
+            it->second.canvas->Clear();
+            it = persistentEntities.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::set<uint32_t> changed;
+    for(auto &it : keys) {
+        auto batch = persistentEntities.find(it.first);
+        if(force || batch == persistentEntities.end() || batch->second.key != it.second) {
+            changed.insert(it.first);
+        }
+    }
+    if(!changed.empty()) {
+        // Sort the entities of the changed groups out in a single pass.
+        std::map<uint32_t, std::vector<Entity *>> entities;
+        for(Entity &e : SK.entity) {
+            if(!IsPersistentEntity(e) || changed.count(e.group.v) == 0) continue;
+            entities[e.group.v].push_back(&e);
+        }
+        for(uint32_t hg : changed) {
+            PersistentBatch *batch = &persistentEntities[hg];
+            UpdatePersistentBatch(batch, keys[hg], /*force=*/true,
+                [&](Canvas *canvas) {
+                    for(Entity *e : entities[hg]) {
+                        DrawEntityForView(e, canvas);
+                    }
+                });
+            FindBatchBounds(entities[hg], batch);
+        }
+    }
+
+    UpdatePersistentBatch(&persistentFills, PersistentFillsKey(), force,
+        [&](Canvas *canvas) {
+            for(hGroup hg : SK.groupOrder) {
+                Group *g = SK.GetGroup(hg);
+                if(!(g->IsVisible())) continue;
+                g->DrawFilledPaths(canvas);
+            }
+        });
+}
+
 void GraphicsWindow::Draw(Canvas *canvas) {
     const Camera &camera = canvas->GetCamera();
 
@@ -701,19 +1268,37 @@ void GraphicsWindow::Draw(Canvas *canvas) {
     // up, then we could trigger an oops trying to draw.
     if(!SS.allConsistent) return;
 
+    cullStats = {};
+
     if(showSnapGrid) DrawSnapGrid(canvas);
 
     // Draw all the things that don't change when we rotate.
-    if(persistentCanvas != NULL) {
-        if(persistentDirty) {
-            persistentDirty = false;
+    if(persistentSolid.canvas != NULL) {
+        // The persistent batches are kept across zooming, so that is where the
+        // display meshes get switched to a coarser or finer level of detail.
+        int lod = SShell::LodForScale(scale);
+        if(lod != meshLod) {
+            meshLod = lod;
+            persistentRegenerated = true;
+        }
 
-            persistentCanvas->Clear();
-            DrawPersistent(&*persistentCanvas);
-            persistentCanvas->Finalize();
+        if(persistentDirty || persistentRegenerated) {
+            UpdatePersistent();
         }
 
-        persistentCanvas->Draw();
+        persistentSolid.canvas->Draw();
+        double strokeMargin = GetStrokeMargin();
+        for(auto &it : persistentEntities) {
+            PersistentBatch *batch = &it.second;
+            cullStats.batches++;
+            if(batch->bounded &&
+                    IsCulled(camera, batch->bbox, batch->margin, strokeMargin)) {
+                cullStats.batchesCulled++;
+                continue;
+            }
+            batch->canvas->Draw();
+        }
+        persistentFills.canvas->Draw();
     } else {
         DrawPersistent(canvas);
     }
@@ -726,9 +1311,25 @@ void GraphicsWindow::Draw(Canvas *canvas) {
         SK.GetGroup(activeGroup)->DrawPolyError(canvas);
     }
 
-    // Draw the constraints
-    for(Constraint &c : SK.constraint) {
-        c.Draw(Constraint::DrawAs::DEFAULT, canvas);
+    // Draw the constraints. If they were laid out for this view already, as
+    // they are after hovering and then panning, leave out those that are off
+    // the screen; otherwise, working that out would cost as much as drawing.
+    if(pending.operation == Pending::NONE && ConstraintIndexIsCurrent(camera)) {
+        std::vector<uint32_t> visible;
+        constraintIndex.Query([&](const BBox &bbox, double margin) {
+            return !IsCulled(camera, bbox, margin, /*strokeMargin=*/0.0);
+        }, &visible);
+        std::sort(visible.begin(), visible.end());
+        for(uint32_t v : visible) {
+            SK.GetConstraint({ v })->Draw(Constraint::DrawAs::DEFAULT, canvas);
+        }
+        cullStats.constraints       = SK.constraint.n;
+        cullStats.constraintsCulled = SK.constraint.n - (int)visible.size();
+    } else {
+        for(Constraint &c : SK.constraint) {
+            c.Draw(Constraint::DrawAs::DEFAULT, canvas);
+        }
+        cullStats.constraints = SK.constraint.n;
     }
 
     // Draw areas
@@ -857,6 +1458,45 @@ void GraphicsWindow::Draw(Canvas *canvas) {
     }
 }
 
+void GraphicsWindow::DrawTimings(UiCanvas *canvas) {
+    // This shows the frame before the one being drawn, since this one
+    // isn't finished yet.
+    Profile::Frame frame = Profile::LastFrame();
+
+    std::vector<std::string> lines;
+    lines.push_back(ssprintf("%-32s %9.2f ms", "Since last frame", frame.micros / 1000.0));
+    for(const Profile::Frame::Line &line : frame.lines) {
+        std::string name = std::string(2 * line.depth + 2, ' ') + line.name;
+        if(line.calls > 1) name += ssprintf(" (%dx)", line.calls);
+        lines.push_back(ssprintf("%-32s %9.2f ms", name.c_str(), line.micros / 1000.0));
+    }
+    for(const Profile::Frame::Counter &counter : frame.counters) {
+        lines.push_back(ssprintf("%-32s %12lld", counter.name, (long long)counter.value));
+    }
+
+    size_t chars = 0;
+    for(const std::string &line : lines) {
+        chars = max(chars, line.size());
+    }
+
+    const int lineHeight = 18, margin = 8;
+    double width, height;
+    window->GetContentSize(&width, &height);
+    int right = (int)width - margin,
+        left  = right - 8 * (int)chars - 2 * margin,
+        top   = (int)height - margin,
+        bot   = top - lineHeight * (int)lines.size() - margin;
+    canvas->DrawRect(left, right, top, bot,
+                     /*fillColor=*/{ 30, 30, 30, 220 },
+                     /*outlineColor=*/{ 60, 60, 60, 255 });
+
+    int y = top - lineHeight;
+    for(const std::string &line : lines) {
+        canvas->DrawBitmapText(line, left + margin, y, { 255, 255, 255, 255 });
+        y -= lineHeight;
+    }
+}
+
 void GraphicsWindow::Paint() {
     ssassert(window != NULL && canvas != NULL,
              "Cannot paint without window and canvas");
@@ -882,8 +1522,22 @@ void GraphicsWindow::Paint() {
     canvas->StartFrame();
 
     // Draw the 3d objects.
-    Draw(canvas.get());
-    canvas->FlushFrame();
+    {
+        Profile::Scope scope("Draw");
+        Draw(canvas.get());
+    }
+    {
+        Profile::Scope scope("Flush");
+        canvas->FlushFrame();
+    }
+    if(Profile::IsEnabled()) {
+        Profile::Count("Entities drawn", cullStats.entities - cullStats.entitiesCulled);
+        Profile::Count("Constraints drawn", cullStats.constraints - cullStats.constraintsCulled);
+        Group *g = SK.group.FindByIdNoOops(activeGroup);
+        if(g != NULL) {
+            Profile::Count("Triangles", g->displayMesh.l.n);
+        }
+    }
 
     // Draw the 2d UI overlay.
     camera.LoadIdentity();
@@ -922,15 +1576,24 @@ void GraphicsWindow::Paint() {
         ToolbarDraw(&uiCanvas);
     }
 
+    if(showTimings) {
+        DrawTimings(&uiCanvas);
+    }
+
     canvas->FlushFrame();
     canvas->FinishFrame();
     canvas->Clear();
+
+    // Whatever happened since the last frame, like regenerating, is counted
+    // as part of this one.
+    Profile::EndFrame();
 }
 
 void GraphicsWindow::Invalidate(bool clearPersistent) {
     if(window) {
         if(clearPersistent) {
             persistentDirty = true;
+            constraintIndex.dirty = true;
         }
         window->Invalidate();
     }
@@ -50,7 +50,26 @@ std::string Entity::TypeToString() const {
     }
 }
 
+// Where a text entity's string is plotted from, and along and up which vectors.
+static void GetTtfTextPlacement(Entity *e, Vector *origin, Vector *u, Vector *v) {
+    Vector topLeft = SK.GetEntity(e->point[0])->PointGetNum();
+    Vector botLeft = SK.GetEntity(e->point[1])->PointGetNum();
+    Vector n = e->Normal()->NormalN();
+    *origin = botLeft;
+    *v = topLeft.Minus(botLeft);
+    *u = (v->Cross(n)).WithMagnitude(v->Magnitude());
+}
+
 void Entity::GenerateEdges(SEdgeList *el) {
+    if(type == Type::TTF_TEXT) {
+        // The font keeps the outlines of its glyphs already made piecewise
+        // linear, so that the text doesn't need to be split all over again.
+        Vector origin, u, v;
+        GetTtfTextPlacement(this, &origin, &u, &v);
+        SS.fonts.PlotEdges(font, str, el, Style::ForEntity(h).v, origin, u, v);
+        return;
+    }
+
     SBezierList *sbl = GetOrGenerateBezierCurves();
 
     for(int i = 0; i < sbl->l.n; i++) {
@@ -488,13 +507,9 @@ void Entity::GenerateBezierCurves(SBezierList *sbl) const {
         }
 
         case Type::TTF_TEXT: {
-            Vector topLeft = SK.GetEntity(point[0])->PointGetNum();
-            Vector botLeft = SK.GetEntity(point[1])->PointGetNum();
-            Vector n = Normal()->NormalN();
-            Vector v = topLeft.Minus(botLeft);
-            Vector u = (v.Cross(n)).WithMagnitude(v.Magnitude());
-
-            SS.fonts.PlotString(font, str, sbl, botLeft, u, v);
+            Vector origin, u, v;
+            GetTtfTextPlacement(this, &origin, &u, &v);
+            SS.fonts.PlotString(font, str, sbl, origin, u, v);
             break;
         }
 
@@ -397,13 +397,75 @@ private:
 };
 
 // A list, where each element has an integer identifier. The list is kept
-// sorted by that identifier, and items can be looked up in log n time by
-// id.
+// sorted by that identifier, and items can be looked up in constant time by
+// id, through an open-addressed hash table from id to position in the store.
 template <class T, class H>
 class IdList {
+    struct HashSlot {
+        uint32_t v;
+        int      idx;   // into elemstore, or -1 if the slot is empty
+    };
+
     std::vector<T> elemstore;
     std::vector<int> elemidx;
     std::vector<int> freelist;
+    std::vector<HashSlot> elemhash;
+    // How many elements at the end of elemidx were added by AddUnsorted, and
+    // are still waiting to be sorted into place.
+    size_t unsorted = 0;
+
+    static size_t HashSlotFor(uint32_t v, size_t size) {
+        // Handles are often sequential, or differ only in their high bits,
+        // so mix them all into the low bits.
+        v ^= v >> 16;
+        v *= 0x85ebca6bu;
+        v ^= v >> 13;
+        v *= 0xc2b2ae35u;
+        v ^= v >> 16;
+        return v & (size - 1);
+    }
+
+    void HashInsert(uint32_t v, int idx) {
+        // Keep the table at most half full, so that probes stay short.
+        if(2 * (size_t)(n + 1) > elemhash.size()) {
+            RebuildHash(2 * (size_t)(n + 1));
+        }
+        size_t mask = elemhash.size() - 1;
+        for(size_t i = HashSlotFor(v, elemhash.size());; i = (i + 1) & mask) {
+            if(elemhash[i].idx < 0) {
+                elemhash[i] = { v, idx };
+                return;
+            }
+        }
+    }
+
+    void RebuildHash(size_t minSize) {
+        size_t size = 16;
+        while(size < 2 * minSize) size *= 2;
+        elemhash.assign(size, { 0, -1 });
+        size_t mask = size - 1;
+        for(int idx : elemidx) {
+            uint32_t v = elemstore[idx].h.v;
+            for(size_t i = HashSlotFor(v, size);; i = (i + 1) & mask) {
+                if(elemhash[i].idx < 0) {
+                    elemhash[i] = { v, idx };
+                    break;
+                }
+            }
+        }
+    }
+
+    void SortPending() {
+        if(unsorted == 0) return;
+        auto less = [&](int a, int b) {
+            return elemstore[a].h.v < elemstore[b].h.v;
+        };
+        auto mid = elemidx.end() - unsorted;
+        std::sort(mid, elemidx.end(), less);
+        std::inplace_merge(elemidx.begin(), mid, elemidx.end(), less);
+        unsorted = 0;
+    }
+
 public:
     int n = 0;  // PAR@@@@@ make this private to see all interesting and suspicious places in SoveSpace ;-)
 
@@ -466,6 +528,7 @@ public:
     }
 
     uint32_t MaximumId() {
+        SortPending();
         if(IsEmpty()) {
             return 0;
         } else {
@@ -478,6 +541,7 @@ public:
 
         // Add at the end of the list.
         elemstore.push_back(*t);
+        HashInsert(t->h.v, elemstore.size()-1);
         elemidx.push_back(elemstore.size()-1);
         ++n;
 
@@ -493,32 +557,53 @@ public:
     void Add(T *t) {
         // Look to see if we already have something with the same handle value.
         ssassert(FindByIdNoOops(t->h) == nullptr, "Handle isn't unique");
+        SortPending();
 
         // Find out where the added element should be.
         auto pos = std::lower_bound(elemidx.begin(), elemidx.end(), *t, Compare(this));
 
+        int idx;
         if(freelist.empty()) { // Add a new element to the store
             elemstore.push_back(*t);
-            // Insert a pointer to the element at the correct position
-            if(elemidx.empty()) {
-                // The list is empty so pos, begin and end are all null.
-                // insert does not work in this case.
-                elemidx.push_back(elemstore.size()-1);
-            } else {
-                elemidx.insert(pos, elemstore.size() - 1);
-            }
+            idx = elemstore.size() - 1;
         } else { // Use the last element from the freelist
-            // Insert an index to the element at the correct position
-            elemidx.insert(pos, freelist.back());
+            idx = freelist.back();
             // Remove the element from the freelist
             freelist.pop_back();
 
             // Copy-construct to the element storage.
-            elemstore[*pos] = T(*t);
+            elemstore[idx] = T(*t);
             //            *elemptr[pos] = *t;   // PAR@@@@@@ maybe this?
         }
 
+        // Hash it before it is in elemidx, since growing the hash table
+        // rehashes everything in elemidx.
+        HashInsert(t->h.v, idx);
+        // Insert an index to the element at the correct position
+        elemidx.insert(pos, idx);
+        ++n;
+    }
+
+    // Add an element without keeping the list sorted, for when many are added
+    // at once. It can be found by id right away, but it is sorted into place
+    // (together with everything else added this way) only when the list is
+    // next used in order, so that adding n elements takes n log n time.
+    void AddUnsorted(T *t) {
+        ssassert(FindByIdNoOops(t->h) == nullptr, "Handle isn't unique");
+
+        int idx;
+        if(freelist.empty()) {
+            elemstore.push_back(*t);
+            idx = elemstore.size() - 1;
+        } else {
+            idx = freelist.back();
+            freelist.pop_back();
+            elemstore[idx] = T(*t);
+        }
+        HashInsert(t->h.v, idx);
+        elemidx.push_back(idx);
         ++n;
+        ++unsorted;
     }
 
     T *FindById(H h) {
@@ -531,22 +616,22 @@ public:
         if(IsEmpty()) {
             return nullptr;
         }
-        auto it = std::lower_bound(elemidx.begin(), elemidx.end(), h, Compare(this));
-        if(it == elemidx.end()) {
-            return nullptr;
-        } else {
-            if(elemstore[*it].h.v != h.v) {
+        size_t mask = elemhash.size() - 1;
+        for(size_t i = HashSlotFor(h.v, elemhash.size());; i = (i + 1) & mask) {
+            const HashSlot &slot = elemhash[i];
+            if(slot.idx < 0) {
                 return nullptr;
+            } else if(slot.v == h.v) {
+                return &elemstore[slot.idx];
             }
-            return &elemstore[*it];
         }
     }
 
-    T &Get(size_t i) { return elemstore[elemidx[i]]; }
+    T &Get(size_t i) { SortPending(); return elemstore[elemidx[i]]; }
     T &operator[](size_t i) { return Get(i); }
 
-    iterator begin() { return IsEmpty() ? nullptr : iterator(this); }
-    iterator end() { return IsEmpty() ? nullptr : iterator(this, elemidx.size()); }
+    iterator begin() { SortPending(); return IsEmpty() ? nullptr : iterator(this); }
+    iterator end() { SortPending(); return IsEmpty() ? nullptr : iterator(this, elemidx.size()); }
 
     void ClearTags() {
         for(auto &elt : *this) { elt.tag = 0; }
@@ -560,6 +645,7 @@ public:
     }
 
     void RemoveTagged() {
+        SortPending();
         int src, dest;
         dest = 0;
         for(src = 0; src < n; src++) {
@@ -576,8 +662,11 @@ public:
                 dest++;
             }
         }
-        n = dest;
-        elemidx.resize(n);  // Clear left over elements at the end.
+        if(n != dest) {
+            n = dest;
+            elemidx.resize(n);  // Clear left over elements at the end.
+            RebuildHash(n);
+        }
     }
     void RemoveById(H h) {  // PAR@@@@@ this can be optimized
         ClearTags();
@@ -587,14 +676,17 @@ public:
 
     void MoveSelfInto(IdList<T,H> *l) {
         l->Clear();
+        std::swap(l->unsorted, unsorted);
         std::swap(l->elemstore, elemstore);
         std::swap(l->elemidx, elemidx);
         std::swap(l->freelist, freelist);
+        std::swap(l->elemhash, elemhash);
         std::swap(l->n, n);
     }
 
     void DeepCopyInto(IdList<T,H> *l) {
         l->Clear();
+        SortPending();
 
         for(auto const &it : elemstore) {
             l->elemstore.push_back(it);
@@ -603,6 +695,7 @@ public:
         for(auto const &it : elemidx) {
             l->elemidx.push_back(it);
         }
+        l->elemhash = elemhash;
 
         l->n = n;
     }
@@ -615,6 +708,8 @@ public:
         freelist.clear();
         elemidx.clear();
         elemstore.clear();
+        elemhash.clear();
+        unsorted = 0;
         n = 0;
     }
 
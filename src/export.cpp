@@ -10,12 +10,12 @@
 #include "config.h"
 
 void SolveSpaceUI::ExportSectionTo(const Platform::Path &filename) {
+    Profile::Scope scope("Export section");
     Vector gn = (SS.GW.projRight).Cross(SS.GW.projUp);
     gn = gn.WithMagnitude(1);
 
     Group *g = SK.GetGroup(SS.GW.activeGroup);
-    g->GenerateDisplayItems();
-    if(g->displayMesh.IsEmpty()) {
+    if(g->GetDisplayMesh()->IsEmpty()) {
         Error(_("No solid model present; draw one with extrudes and revolves, "
                 "or use Export 2d View to export bare lines and curves."));
         return;
@@ -185,6 +185,7 @@ public:
 };
 
 void SolveSpaceUI::ExportViewOrWireframeTo(const Platform::Path &filename, bool exportWireframe) {
+    Profile::Scope scope(exportWireframe ? "Export wireframe" : "Export view");
     SEdgeList edges = {};
     SBezierList beziers = {};
 
@@ -197,8 +198,7 @@ void SolveSpaceUI::ExportViewOrWireframeTo(const Platform::Path &filename, bool
     SMesh *sm = NULL;
     if(SS.GW.showShaded || SS.GW.drawOccludedAs != GraphicsWindow::DrawOccludedAs::VISIBLE) {
         Group *g = SK.GetGroup(SS.GW.activeGroup);
-        g->GenerateDisplayItems();
-        sm = &(g->displayMesh);
+        sm = g->GetDisplayMesh();
     }
     if(sm && sm->IsEmpty()) {
         sm = NULL;
@@ -807,140 +807,356 @@ void VectorFileWriter::BezierAsNonrationalCubic(SBezier *sb, int depth) {
 // Export a triangle mesh, in the requested format.
 //-----------------------------------------------------------------------------
 void SolveSpaceUI::ExportMeshTo(const Platform::Path &filename) {
+    Profile::Scope scope("Export mesh");
     SS.exportMode = true;
     GenerateAll(Generate::ALL);
 
     Group *g = SK.GetGroup(SS.GW.activeGroup);
-    g->GenerateDisplayItems();
+    if(filename.HasExtension("stl") ||
+       filename.HasExtension("obj") ||
+       filename.HasExtension("ply")) {
+        // These formats get the triangles straight from the triangulation,
+        // one surface at a time, without building the display mesh first.
+        if(g->runningShell.IsEmpty() && g->runningMesh.IsEmpty()) {
+            Error(_("Active group mesh is empty; nothing to export."));
+            return;
+        }
 
-    SMesh *m = &(SK.GetGroup(SS.GW.activeGroup)->displayMesh);
-    if(m->IsEmpty()) {
-        Error(_("Active group mesh is empty; nothing to export."));
-        return;
+        MeshFileWriter *out = MeshFileWriter::ForFile(filename);
+        if(!out) return;
+        if(!out->StartFile()) {
+            Error("Couldn't write to '%s'", filename.raw.c_str());
+            fclose(out->f);
+            return;
+        }
+        out->OutputShell(&g->runningShell);
+        out->OutputMesh(&g->runningMesh);
+        out->FinishAndCloseFile();
+
+        // The interactive UI is about to triangulate the whole model for
+        // display anyway, so check it for naked edges then; from the command
+        // line, that would defeat the point of streaming the export.
+        if(GW.window) {
+            g->GenerateDisplayItems();
+            ShowNakedEdges(/*reportOnlyWhenNotOkay=*/true);
+        }
+    } else {
+        SMesh *m = g->GetDisplayMesh();
+        if(m->IsEmpty()) {
+            Error(_("Active group mesh is empty; nothing to export."));
+            return;
+        }
+
+        FILE *f = OpenFile(filename, "wb");
+        if(!f) {
+            Error("Couldn't write to '%s'", filename.raw.c_str());
+            return;
+        }
+        ShowNakedEdges(/*reportOnlyWhenNotOkay=*/true);
+        if(filename.HasExtension("js") ||
+           filename.HasExtension("html")) {
+            // Three.js files get loaded into a browser, so decimate the mesh,
+            // to within the export chord tolerance; big imported meshes and
+            // finely triangulated curved surfaces shrink the most. Surfaces
+            // were already triangulated to that tolerance, so they may end up
+            // as far as twice it from the exact ones; that's plenty for a
+            // preview, and giving either step less would undo the savings.
+            SMesh dm = {};
+            dm.MakeFromDecimationOf(m, ExportChordTolMm());
+            SOutlineList *e = &(g->displayOutlines);
+            ExportMeshAsThreeJsTo(f, filename, &dm, e);
+            dm.Clear();
+        } else if(filename.HasExtension("wrl")) {
+            ExportMeshAsVrmlTo(f, filename, m);
+        } else {
+            Error("Can't identify output file type from file extension of "
+                  "filename '%s'; try .stl, .obj, .ply, .js, .html, .wrl.",
+                  filename.raw.c_str());
+        }
+
+        fclose(f);
+    }
+
+    SS.justExportedInfo.showOrigin = false;
+    SS.justExportedInfo.draw = true;
+    GW.Invalidate();
+}
+
+MeshFileWriter *MeshFileWriter::ForFile(const Platform::Path &filename) {
+    MeshFileWriter *ret;
+    if(filename.HasExtension("stl")) {
+        static StlFileWriter StlWriter;
+        ret = &StlWriter;
+    } else if(filename.HasExtension("obj")) {
+        static ObjFileWriter ObjWriter;
+        ret = &ObjWriter;
+    } else if(filename.HasExtension("ply")) {
+        static PlyFileWriter PlyWriter;
+        ret = &PlyWriter;
+    } else {
+        Error("Can't identify output file type from file extension of "
+              "filename '%s'; try .stl, .obj, or .ply.", filename.raw.c_str());
+        return NULL;
     }
+    ret->filename = filename;
 
     FILE *f = OpenFile(filename, "wb");
     if(!f) {
         Error("Couldn't write to '%s'", filename.raw.c_str());
-        return;
+        return NULL;
     }
-    ShowNakedEdges(/*reportOnlyWhenNotOkay=*/true);
-    if(filename.HasExtension("stl")) {
-        ExportMeshAsStlTo(f, m);
-    } else if(filename.HasExtension("obj")) {
-        Platform::Path mtlFilename = filename.WithExtension("mtl");
-        FILE *fMtl = OpenFile(mtlFilename, "wb");
-        if(!fMtl) {
-            Error("Couldn't write to '%s'", filename.raw.c_str());
-            return;
+    ret->f = f;
+    ret->triangleCount = 0;
+    ret->buffer.clear();
+    ret->buffer.reserve(BUFFER_SIZE);
+    return ret;
+}
+
+//-----------------------------------------------------------------------------
+// Triangulate the shell a few surfaces at a time, and write out each batch
+// in surface order before moving on to the next one.
+//-----------------------------------------------------------------------------
+void MeshFileWriter::OutputShell(SShell *sh) {
+    const int BATCH_SIZE = 64;
+    double chordTol = SS.ChordTolMm();
+
+    std::vector<SMesh> meshes(BATCH_SIZE);
+    for(int start = 0; start < sh->surface.n; start += BATCH_SIZE) {
+        int count = min(BATCH_SIZE, sh->surface.n - start);
+#pragma omp parallel for
+        for(int i = 0; i < count; i++) {
+            sh->surface[start + i].TriangulateInto(sh, &meshes[i], chordTol);
+        }
+        for(int i = 0; i < count; i++) {
+            for(const STriangle &tr : meshes[i].l) {
+                Triangle(tr);
+            }
+            meshes[i].Clear();
         }
+    }
+}
 
-        fprintf(f, "mtllib %s\n", mtlFilename.FileName().c_str());
-        ExportMeshAsObjTo(f, fMtl, m);
+void MeshFileWriter::OutputMesh(SMesh *sm) {
+    // Same as the display mesh, a triangle mesh gets flat shading.
+    for(const STriangle &tr : sm->l) {
+        STriangle trn = tr;
+        Vector n = trn.Normal();
+        trn.an = n;
+        trn.bn = n;
+        trn.cn = n;
+        Triangle(trn);
+    }
+}
 
-        fclose(fMtl);
-    } else if(filename.HasExtension("js") ||
-              filename.HasExtension("html")) {
-        SOutlineList *e = &(SK.GetGroup(SS.GW.activeGroup)->displayOutlines);
-        ExportMeshAsThreeJsTo(f, filename, m, e);
-    } else if(filename.HasExtension("wrl")) {
-        ExportMeshAsVrmlTo(f, filename, m);
-    } else {
-        Error("Can't identify output file type from file extension of "
-              "filename '%s'; try .stl, .obj, .js, .html.", filename.raw.c_str());
+void MeshFileWriter::Write(const void *data, size_t size) {
+    if(buffer.size() + size > BUFFER_SIZE) {
+        Flush();
     }
+    const char *bytes = (const char *)data;
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
 
-    fclose(f);
+void MeshFileWriter::Printf(const char *fmt, ...) {
+    char str[256];
+    va_list va;
+    va_start(va, fmt);
+    int size = vsnprintf(str, sizeof(str), fmt, va);
+    va_end(va);
+    ssassert(size >= 0 && (size_t)size < sizeof(str), "Line too long for mesh export");
+    Write(str, (size_t)size);
+}
 
-    SS.justExportedInfo.showOrigin = false;
-    SS.justExportedInfo.draw = true;
-    GW.Invalidate();
+void MeshFileWriter::Flush() {
+    if(!buffer.empty()) {
+        fwrite(buffer.data(), 1, buffer.size(), f);
+        buffer.clear();
+    }
 }
 
 //-----------------------------------------------------------------------------
 // Export the mesh as an STL file; it should always be vertex-to-vertex and
-// not self-intersecting, so not much to do.
+// not self-intersecting, so not much to do. The triangle count in the header
+// is only known at the end, so it gets filled in then.
 //-----------------------------------------------------------------------------
-void SolveSpaceUI::ExportMeshAsStlTo(FILE *f, SMesh *sm) {
+bool StlFileWriter::StartFile() {
     char str[80] = {};
     strcpy(str, "STL exported mesh");
-    fwrite(str, 1, 80, f);
+    Write(str, 80);
 
-    uint32_t n = sm->l.n;
-    fwrite(&n, 4, 1, f);
+    uint32_t n = 0;
+    Write(&n, 4);
+    return true;
+}
 
+void StlFileWriter::Triangle(const STriangle &tr) {
     double s = SS.exportScale;
-    int i;
-    for(i = 0; i < sm->l.n; i++) {
-        STriangle *tr = &(sm->l[i]);
-        Vector n = tr->Normal().WithMagnitude(1);
-        float w;
-        w = (float)n.x;           fwrite(&w, 4, 1, f);
-        w = (float)n.y;           fwrite(&w, 4, 1, f);
-        w = (float)n.z;           fwrite(&w, 4, 1, f);
-        w = (float)((tr->a.x)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->a.y)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->a.z)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->b.x)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->b.y)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->b.z)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->c.x)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->c.y)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->c.z)/s); fwrite(&w, 4, 1, f);
-        fputc(0, f);
-        fputc(0, f);
-    }
+    Vector n = tr.Normal().WithMagnitude(1);
+    float w[12] = {
+        (float)n.x, (float)n.y, (float)n.z,
+        (float)((tr.a.x)/s), (float)((tr.a.y)/s), (float)((tr.a.z)/s),
+        (float)((tr.b.x)/s), (float)((tr.b.y)/s), (float)((tr.b.z)/s),
+        (float)((tr.c.x)/s), (float)((tr.c.y)/s), (float)((tr.c.z)/s),
+    };
+    Write(w, sizeof(w));
+    uint16_t attr = 0;
+    Write(&attr, 2);
+    triangleCount++;
+}
+
+void StlFileWriter::FinishAndCloseFile() {
+    Flush();
+    fseek(f, 80, SEEK_SET);
+    fwrite(&triangleCount, 4, 1, f);
+    fclose(f);
 }
 
 //-----------------------------------------------------------------------------
-// Export the mesh as Wavefront OBJ format. This requires us to reduce all the
-// identical vertices to the same identifier, so do that first.
+// Export the mesh as Wavefront OBJ format. Identical vertices and normals are
+// reduced to the same identifier as we go; OBJ doesn't mind them being
+// interleaved with the faces that use them.
 //-----------------------------------------------------------------------------
-void SolveSpaceUI::ExportMeshAsObjTo(FILE *fObj, FILE *fMtl, SMesh *sm) {
-    std::map<RgbaColor, std::string, RgbaColorCompare> colors;
-    for(const STriangle &t : sm->l) {
-        RgbaColor color = t.meta.color;
-        if(colors.find(color) == colors.end()) {
+bool ObjFileWriter::StartFile() {
+    Platform::Path mtlFilename = filename.WithExtension("mtl");
+    fMtl = OpenFile(mtlFilename, "wb");
+    if(!fMtl) return false;
+
+    vertices.clear();
+    normals.clear();
+    colors.clear();
+    currentColor = {};
+    Printf("mtllib %s\n", mtlFilename.FileName().c_str());
+    return true;
+}
+
+uint32_t ObjFileWriter::IndexOf(std::unordered_map<Vector, uint32_t, VectorHash, VectorPred> *indices,
+                                const char *keyword, Vector v) {
+    auto it = indices->find(v);
+    if(it != indices->end()) return it->second;
+
+    uint32_t index = (uint32_t)indices->size() + 1;
+    indices->emplace(v, index);
+    Printf("%s %.10f %.10f %.10f\n", keyword, CO(v));
+    return index;
+}
+
+void ObjFileWriter::Triangle(const STriangle &tr) {
+    uint32_t vi[3], ni[3];
+    for(int i = 0; i < 3; i++) {
+        vi[i] = IndexOf(&vertices, "v", tr.vertices[i].ScaledBy(1 / SS.exportScale));
+        ni[i] = IndexOf(&normals, "vn", tr.normals[i].WithMagnitude(1.0));
+    }
+
+    RgbaColor color = tr.meta.color;
+    if(triangleCount == 0 || !currentColor.Equals(color)) {
+        currentColor = color;
+        auto it = colors.find(color);
+        if(it == colors.end()) {
             std::string id = ssprintf("h%02x%02x%02x",
                                       color.red,
                                       color.green,
                                       color.blue);
-            colors.emplace(color, id);
-        }
-        for(int i = 0; i < 3; i++) {
-            fprintf(fObj, "v %.10f %.10f %.10f\n",
-                    CO(t.vertices[i].ScaledBy(1 / SS.exportScale)));
+            it = colors.emplace(color, id).first;
         }
+        Printf("usemtl %s\n", it->second.c_str());
     }
 
+    Printf("f %u//%u %u//%u %u//%u\n",
+           vi[0], ni[0], vi[1], ni[1], vi[2], ni[2]);
+    triangleCount++;
+}
+
+void ObjFileWriter::FinishAndCloseFile() {
     for(auto &it : colors) {
         fprintf(fMtl, "newmtl %s\n",
                 it.second.c_str());
         fprintf(fMtl, "Kd %.3f %.3f %.3f\n",
                 it.first.redF(), it.first.greenF(), it.first.blueF());
     }
+    fclose(fMtl);
+
+    Flush();
+    fclose(f);
 
-    for(const STriangle &t : sm->l) {
-        for(int i = 0; i < 3; i++) {
-            Vector n = t.normals[i].WithMagnitude(1.0);
-            fprintf(fObj, "vn %.10f %.10f %.10f\n",
-                    CO(n));
+    vertices.clear();
+    normals.clear();
+    colors.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Export the mesh as binary Stanford PLY, with shared vertices and a color per
+// face. PLY wants all the vertices before all the faces, so the faces go to a
+// temporary file and are appended at the end; the element counts in the header
+// are written as fixed-width fields, and filled in then too.
+//-----------------------------------------------------------------------------
+bool PlyFileWriter::StartFile() {
+    fFaces = tmpfile();
+    if(!fFaces) return false;
+
+    vertices.clear();
+    std::string header =
+        "ply\n"
+        "format binary_little_endian 1.0\n"
+        "comment Exported by SolveSpace\n"
+        "element vertex ";
+    vertexCountAt = (long)header.size();
+    header +=
+        "0000000000\n"
+        "property float x\n"
+        "property float y\n"
+        "property float z\n"
+        "element face ";
+    faceCountAt = (long)header.size();
+    header +=
+        "0000000000\n"
+        "property list uchar uint vertex_indices\n"
+        "property uchar red\n"
+        "property uchar green\n"
+        "property uchar blue\n"
+        "end_header\n";
+    Write(header.data(), header.size());
+    return true;
+}
+
+void PlyFileWriter::Triangle(const STriangle &tr) {
+    uint32_t vi[3];
+    for(int i = 0; i < 3; i++) {
+        Vector v = tr.vertices[i].ScaledBy(1 / SS.exportScale);
+        auto it = vertices.find(v);
+        if(it == vertices.end()) {
+            it = vertices.emplace(v, (uint32_t)vertices.size()).first;
+            float w[3] = { (float)v.x, (float)v.y, (float)v.z };
+            Write(w, sizeof(w));
         }
+        vi[i] = it->second;
     }
 
-    RgbaColor currentColor = {};
-    for(int i = 0; i < sm->l.n; i++) {
-        const STriangle &t = sm->l[i];
-        if(!currentColor.Equals(t.meta.color)) {
-            currentColor = t.meta.color;
-            fprintf(fObj, "usemtl %s\n", colors[currentColor].c_str());
-        }
+    uint8_t face[16];
+    face[0] = 3;
+    memcpy(&face[1], vi, sizeof(vi));
+    face[13] = tr.meta.color.red;
+    face[14] = tr.meta.color.green;
+    face[15] = tr.meta.color.blue;
+    fwrite(face, 1, sizeof(face), fFaces);
+    triangleCount++;
+}
 
-        fprintf(fObj, "f %d//%d %d//%d %d//%d\n",
-                i * 3 + 1, i * 3 + 1,
-                i * 3 + 2, i * 3 + 2,
-                i * 3 + 3, i * 3 + 3);
+void PlyFileWriter::FinishAndCloseFile() {
+    rewind(fFaces);
+    char chunk[4096];
+    size_t size;
+    while((size = fread(chunk, 1, sizeof(chunk), fFaces)) > 0) {
+        Write(chunk, size);
     }
+    fclose(fFaces);
+    Flush();
+
+    fseek(f, vertexCountAt, SEEK_SET);
+    fprintf(f, "%010u", (uint32_t)vertices.size());
+    fseek(f, faceCountAt, SEEK_SET);
+    fprintf(f, "%010u", triangleCount);
+    fclose(f);
+
+    vertices.clear();
 }
 
 //-----------------------------------------------------------------------------
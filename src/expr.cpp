@@ -266,6 +266,7 @@ int Expr::Children() const {
     switch(op) {
         case Op::PARAM:
         case Op::PARAM_PTR:
+        case Op::PARAM_VAL:
         case Op::CONSTANT:
         case Op::VARIABLE:
             return 0;
@@ -333,10 +334,26 @@ Expr *Expr::DeepCopyWithParamsAsPointers(IdList<Param,hParam> *firstTry,
     return n;
 }
 
+void Expr::ParamPointersToValues(const std::unordered_map<const Param *, double *> &vals) {
+    if(op == Op::PARAM_PTR) {
+        auto it = vals.find(parp);
+        if(it != vals.end()) {
+            op   = Op::PARAM_VAL;
+            parv = it->second;
+        }
+        return;
+    }
+
+    int c = Children();
+    if(c > 0) a->ParamPointersToValues(vals);
+    if(c > 1) b->ParamPointersToValues(vals);
+}
+
 double Expr::Eval() const {
     switch(op) {
         case Op::PARAM:         return SK.GetParam(parh)->val;
         case Op::PARAM_PTR:     return parp->val;
+        case Op::PARAM_VAL:     return *parv;
 
         case Op::CONSTANT:      return v;
         case Op::VARIABLE:      ssassert(false, "Not supported yet");
@@ -363,6 +380,7 @@ Expr *Expr::PartialWrt(hParam p) const {
     switch(op) {
         case Op::PARAM_PTR: return From(p == parp->h ? 1 : 0);
         case Op::PARAM:     return From(p == parh ? 1 : 0);
+        case Op::PARAM_VAL: ssassert(false, "Expected an expression that refer to params");
 
         case Op::CONSTANT:  return From(0.0);
         case Op::VARIABLE:  ssassert(false, "Not supported yet");
@@ -401,6 +419,8 @@ Expr *Expr::PartialWrt(hParam p) const {
 }
 
 uint64_t Expr::ParamsUsed() const {
+    ssassert(op != Op::PARAM_VAL, "Expected an expression that refer to params");
+
     uint64_t r = 0;
     if(op == Op::PARAM)     r |= ((uint64_t)1 << (parh.v % 61));
     if(op == Op::PARAM_PTR) r |= ((uint64_t)1 << (parp->h.v % 61));
@@ -412,6 +432,8 @@ uint64_t Expr::ParamsUsed() const {
 }
 
 bool Expr::DependsOn(hParam p) const {
+    ssassert(op != Op::PARAM_VAL, "Expected an expression that refer to params");
+
     if(op == Op::PARAM)     return (parh    == p);
     if(op == Op::PARAM_PTR) return (parp->h == p);
 
@@ -434,6 +456,7 @@ Expr *Expr::FoldConstants() {
 
     switch(op) {
         case Op::PARAM_PTR:
+        case Op::PARAM_VAL:
         case Op::PARAM:
         case Op::CONSTANT:
         case Op::VARIABLE:
@@ -492,7 +515,8 @@ Expr *Expr::FoldConstants() {
 }
 
 void Expr::Substitute(hParam oldh, hParam newh) {
-    ssassert(op != Op::PARAM_PTR, "Expected an expression that refer to params via handles");
+    ssassert(op != Op::PARAM_PTR && op != Op::PARAM_VAL,
+             "Expected an expression that refer to params via handles");
 
     if(op == Op::PARAM && parh == oldh) {
         parh = newh;
@@ -517,7 +541,8 @@ hParam Expr::ReferencedParams(ParamList *pl) const {
             return NO_PARAMS;
         }
     }
-    ssassert(op != Op::PARAM_PTR, "Expected an expression that refer to params via handles");
+    ssassert(op != Op::PARAM_PTR && op != Op::PARAM_VAL,
+             "Expected an expression that refer to params via handles");
 
     int c = Children();
     if(c == 0) {
@@ -550,6 +575,7 @@ std::string Expr::Print() const {
     switch(op) {
         case Op::PARAM:     return ssprintf("param(%08x)", parh.v);
         case Op::PARAM_PTR: return ssprintf("param(p%08x)", parp->h.v);
+        case Op::PARAM_VAL: return ssprintf("param(v%p)", (void *)parv);
 
         case Op::CONSTANT:  return ssprintf("%.3f", v);
         case Op::VARIABLE:  return "(var)";
@@ -16,6 +16,10 @@ public:
         // A parameter, by a pointer straight in to the param table (faster,
         // if we know that the param table won't move around)
         PARAM_PTR      =  1,
+        // A parameter that is an unknown of the solver, by a pointer straight
+        // in to the solver's array of their values (faster still, since those
+        // are contiguous)
+        PARAM_VAL      =  2,
 
         // Operands
         CONSTANT       = 20,
@@ -42,6 +46,7 @@ public:
         double  v;
         hParam  parh;
         Param  *parp;
+        double *parv;
         Expr    *b;
     };
 
@@ -95,6 +100,9 @@ public:
     // considerably.
     Expr *DeepCopyWithParamsAsPointers(IdList<Param,hParam> *firstTry,
                                        IdList<Param,hParam> *thenTry) const;
+    // Rewrite, in place, the pointers to the given params into pointers to
+    // their values. After this, the expression can only be evaluated.
+    void ParamPointersToValues(const std::unordered_map<const Param *, double *> &vals);
 
     static Expr *Parse(const std::string &input, std::string *error);
     static Expr *From(const std::string &input, bool popUpError);
@@ -7,8 +7,219 @@
 
 #define VERSION_STRING "\261\262\263" "SolveSpaceREVa"
 
-static int StrStartsWith(const char *str, const char *start) {
-    return memcmp(str, start, strlen(start)) == 0;
+namespace SolveSpace {
+
+//-----------------------------------------------------------------------------
+// Splits a file that was read into memory into lines, in place.
+//-----------------------------------------------------------------------------
+class SlvsLineReader {
+public:
+    char *pos;
+    char *end;
+
+    SlvsLineReader(std::string *data) : pos(&(*data)[0]), end(&(*data)[0] + data->size()) {}
+
+    // Returns the next line, without its line ending, or NULL at the end.
+    char *Next() {
+        if(pos >= end) return NULL;
+
+        char *line = pos;
+        char *nl = (char *)memchr(pos, '\n', end - pos);
+        if(nl != NULL) {
+            *nl = '\0';
+            pos = nl + 1;
+        } else {
+            // The string's own terminator ends the last line.
+            pos = end;
+        }
+        // We should never get files with \r characters in them, but mailers
+        // will sometimes mangle attachments.
+        char *cr = strchr(line, '\r');
+        if(cr) *cr = '\0';
+        return line;
+    }
+};
+
+}
+
+//-----------------------------------------------------------------------------
+// Reads whitespace-separated fields from a line, like sscanf would with %x,
+// %d and %lf, but without interpreting a format string every time.
+//-----------------------------------------------------------------------------
+class SlvsFieldReader {
+public:
+    const char *pos;
+    bool        ok;
+
+    SlvsFieldReader(const char *pos) : pos(pos), ok(true) {}
+
+    uint32_t Hex() {
+        char *next;
+        unsigned long v = strtoul(pos, &next, 16);
+        if(next == pos) ok = false;
+        pos = next;
+        return (uint32_t)v;
+    }
+
+    int Int() {
+        char *next;
+        long v = strtol(pos, &next, 10);
+        if(next == pos) ok = false;
+        pos = next;
+        return (int)v;
+    }
+
+    double Double() {
+        char *next;
+        double v = strtod(pos, &next);
+        if(next == pos) ok = false;
+        pos = next;
+        return v;
+    }
+
+    Vector Point() {
+        Vector v;
+        v.x = Double();
+        v.y = Double();
+        v.z = Double();
+        return v;
+    }
+
+    // Skips over a literal word, such as "Weight".
+    void Word(const char *word) {
+        while(*pos == ' ') pos++;
+        size_t len = strlen(word);
+        if(strncmp(pos, word, len) != 0) {
+            ok = false;
+            return;
+        }
+        pos += len;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// A perfect hash over a fixed set of distinct strings: each of them has a
+// slot of its own, so that a lookup is one hash and one comparison. The seed
+// that makes it so is found by trial when the table is built.
+//-----------------------------------------------------------------------------
+class PerfectHash {
+public:
+    std::vector<const char *> keys;
+    std::vector<int>          slots;
+    uint32_t                  seed;
+    uint32_t                  mask;
+
+    static uint32_t Hash(uint32_t seed, const char *key) {
+        // FNV-1a with the seed mixed into the offset basis, then a finalizer
+        // so that the low bits depend on all of the key.
+        uint32_t h = 2166136261u ^ seed;
+        for(; *key != '\0'; key++) {
+            h ^= (uint8_t)*key;
+            h *= 16777619u;
+        }
+        h ^= h >> 16;
+        h *= 0x85ebca6bu;
+        h ^= h >> 13;
+        return h;
+    }
+
+    explicit PerfectHash(const std::vector<const char *> &keys) : keys(keys) {
+        size_t size = 16;
+        while(size < keys.size() * 2) size *= 2;
+        for(;;) {
+            mask = (uint32_t)size - 1;
+            for(seed = 0; seed < 1000; seed++) {
+                if(TryBuild(size)) return;
+            }
+            size *= 2;
+        }
+    }
+
+    bool TryBuild(size_t size) {
+        slots.assign(size, -1);
+        for(size_t i = 0; i < keys.size(); i++) {
+            int &slot = slots[Hash(seed, keys[i]) & mask];
+            if(slot >= 0) {
+                ssassert(strcmp(keys[slot], keys[i]) != 0, "Duplicate key in perfect hash");
+                return false;
+            }
+            slot = (int)i;
+        }
+        return true;
+    }
+
+    // Returns the index of the key in the list the table was built from, or -1.
+    int Find(const char *key) const {
+        int i = slots[Hash(seed, key) & mask];
+        if(i >= 0 && strcmp(keys[i], key) == 0) return i;
+        return -1;
+    }
+};
+
+// The lines that are not key=value pairs.
+enum class SlvsMarker : int {
+    ADD_GROUP = 0,
+    ADD_PARAM,
+    ADD_ENTITY,
+    ADD_REQUEST,
+    ADD_CONSTRAINT,
+    ADD_STYLE,
+    VERSION,
+    TRIANGLE,
+    SURFACE,
+    SCTRL,
+    TRIM_BY,
+    ADD_SURFACE,
+    CURVE,
+    CCTRL,
+    CURVE_PT,
+    ADD_CURVE,
+    UNKNOWN
+};
+
+static const struct {
+    const char *word;
+    bool        hasArgs;
+} SLVS_MARKERS[] = {
+    { "AddGroup",       false },
+    { "AddParam",       false },
+    { "AddEntity",      false },
+    { "AddRequest",     false },
+    { "AddConstraint",  false },
+    { "AddStyle",       false },
+    { VERSION_STRING,   false },
+    { "Triangle",       true  },
+    { "Surface",        true  },
+    { "SCtrl",          true  },
+    { "TrimBy",         true  },
+    { "AddSurface",     false },
+    { "Curve",          true  },
+    { "CCtrl",          true  },
+    { "CurvePt",        true  },
+    { "AddCurve",       false },
+};
+
+// Identifies a line by its first word. For markers that have arguments, *args
+// is set to point to them; otherwise it is left alone.
+static SlvsMarker FindMarker(char *line, const char **args) {
+    static const PerfectHash markers([]() -> std::vector<const char *> {
+        std::vector<const char *> words;
+        for(const auto &marker : SLVS_MARKERS) {
+            words.push_back(marker.word);
+        }
+        return words;
+    }());
+
+    char *space = strchr(line, ' ');
+    if(space) *space = '\0';
+    int i = markers.Find(line);
+    if(space) *space = ' ';
+
+    if(i < 0 || SLVS_MARKERS[i].hasArgs != (space != NULL)) {
+        return SlvsMarker::UNKNOWN;
+    }
+    if(space) *args = space;
+    return (SlvsMarker)i;
 }
 
 //-----------------------------------------------------------------------------
@@ -220,20 +431,38 @@ struct SAVEDptr {
     uint32_t  &x() { return *((uint32_t *)this); }
 };
 
-void SolveSpaceUI::SaveUsingTable(const Platform::Path &filename, int type) {
+// The table points into SS.sv; the fields of any other element of the same
+// type are at the same offsets from the start of that element.
+static const void *SavedElementFor(int type) {
+    switch(type) {
+        case 'g': return &SS.sv.g;
+        case 'p': return &SS.sv.p;
+        case 'r': return &SS.sv.r;
+        case 'e': return &SS.sv.e;
+        case 'c': return &SS.sv.c;
+        case 's': return &SS.sv.s;
+    }
+    ssassert(false, "Unexpected element type");
+}
+
+void SolveSpaceUI::SaveUsingTable(FILE *fh, const Platform::Path &filename, int type,
+                                  const void *elem) {
+    ptrdiff_t shift = (const char *)elem - (const char *)SavedElementFor(type);
     int i;
     for(i = 0; SAVED[i].type != 0; i++) {
         if(SAVED[i].type != type) continue;
 
         int fmt = SAVED[i].fmt;
-        SAVEDptr *p = (SAVEDptr *)SAVED[i].ptr;
+        // Ignored items have no field, and so no pointer to shift.
+        if(fmt == 'i') continue;
+
+        SAVEDptr *p = (SAVEDptr *)((char *)SAVED[i].ptr + shift);
         // Any items that aren't specified are assumed to be zero
         if(fmt == 'S' && p->S().empty())          continue;
         if(fmt == 'P' && p->P().IsEmpty())        continue;
         if(fmt == 'd' && p->d() == 0)             continue;
         if(fmt == 'f' && EXACT(p->f() == 0.0))    continue;
         if(fmt == 'x' && p->x() == 0)             continue;
-        if(fmt == 'i')                            continue;
 
         fprintf(fh, "%s=", SAVED[i].desc);
         switch(fmt) {
@@ -269,18 +498,41 @@ void SolveSpaceUI::SaveUsingTable(const Platform::Path &filename, int type) {
                 break;
             }
 
-            case 'i': break;
-
             default: ssassert(false, "Unexpected value format");
         }
         fprintf(fh, "\n");
     }
 }
 
-bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
+class SolveSpaceUI::SaveSnapshot {
+public:
+    std::vector<Group>      group;
+    std::vector<Param>      param;
+    std::vector<Request>    request;
+    std::vector<Entity>     entity;
+    std::vector<Constraint> constraint;
+    std::vector<Style>      style;
+    // Of the last group, which has either a mesh or a shell, but not both.
+    SMesh                   mesh;
+    SShell                  shell;
+
+    SaveSnapshot() : mesh(), shell() {}
+    SaveSnapshot(const SaveSnapshot &) = delete;
+    SaveSnapshot &operator=(const SaveSnapshot &) = delete;
+
+    ~SaveSnapshot() {
+        mesh.Clear();
+        shell.Clear();
+    }
+};
+
+std::shared_ptr<SolveSpaceUI::SaveSnapshot>
+        SolveSpaceUI::TakeSaveSnapshot(const Platform::Path &filename) {
     // Make sure all the entities are regenerated up to date, since they will be exported.
+    // Only the groups that changed since they were last solved need to be solved again;
+    // the meshes and shells of the rest are already what we would get.
     SS.ScheduleShowTW();
-    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    SS.GenerateAll(SolveSpaceUI::Generate::DIRTY_ALL);
 
     for(Group &g : SK.group) {
         if(g.type != Group::Type::LINKED) continue;
@@ -288,63 +540,97 @@ bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
         if(g.linkFile.RelativeTo(filename).IsEmpty()) {
             Error("This sketch links the sketch '%s'; it can only be saved "
                   "on the same volume.", g.linkFile.raw.c_str());
-            return false;
+            return nullptr;
         }
     }
 
-    fh = OpenFile(filename, "wb");
-    if(!fh) {
-        Error("Couldn't write to file '%s'", filename.raw.c_str());
-        return false;
+    std::shared_ptr<SaveSnapshot> snapshot = std::make_shared<SaveSnapshot>();
+    snapshot->group.reserve(SK.group.n);
+    for(Group &g : SK.group) {
+        snapshot->group.push_back(g.CopyWithoutGeneratedData());
+    }
+    snapshot->param.reserve(SK.param.n);
+    for(Param &p : SK.param) {
+        snapshot->param.push_back(p);
+    }
+    snapshot->request.reserve(SK.request.n);
+    for(Request &r : SK.request) {
+        snapshot->request.push_back(r);
+    }
+    snapshot->entity.reserve(SK.entity.n);
+    for(Entity &e : SK.entity) {
+        e.CalculateNumerical(/*forExport=*/true);
+        Entity copy = e;
+        // Leave behind the generated curves, which aren't saved.
+        copy.beziers = {};
+        copy.edges = {};
+        snapshot->entity.push_back(copy);
+    }
+    snapshot->constraint.reserve(SK.constraint.n);
+    for(Constraint &c : SK.constraint) {
+        snapshot->constraint.push_back(c);
     }
+    for(Style &s : SK.style) {
+        if(s.h.v >= Style::FIRST_CUSTOM) {
+            snapshot->style.push_back(s);
+        }
+    }
+
+    Group *g = SK.GetGroup(*SK.groupOrder.Last());
+    snapshot->mesh.MakeFromCopyOf(&g->runningMesh);
+    snapshot->shell.MakeFromCopyOf(&g->runningShell);
+    return snapshot;
+}
+
+// Doesn't touch the sketch, so it can run on any thread.
+bool SolveSpaceUI::WriteSaveSnapshot(SaveSnapshot *snapshot, const Platform::Path &filename) {
+    // Write to a temporary file and then put it in place of the old one, so that
+    // a crash or a full disk while saving never leaves a half-written file behind.
+    Platform::Path tempFile = Platform::Path::From(filename.raw + ".tmp");
+    FILE *fh = OpenFile(tempFile, "wb");
+    if(!fh) return false;
+
+    // Lots of short writes; pass them on to the OS in large chunks.
+    std::vector<char> buffer(1 << 20);
+    setvbuf(fh, &buffer[0], _IOFBF, buffer.size());
 
     fprintf(fh, "%s\n\n\n", VERSION_STRING);
 
     int i, j;
-    for(auto &g : SK.group) {
-        sv.g = g;
-        SaveUsingTable(filename, 'g');
+    for(const Group &g : snapshot->group) {
+        SaveUsingTable(fh, filename, 'g', &g);
         fprintf(fh, "AddGroup\n\n");
     }
 
-    for(auto &p : SK.param) {
-        sv.p = p;
-        SaveUsingTable(filename, 'p');
+    for(const Param &p : snapshot->param) {
+        SaveUsingTable(fh, filename, 'p', &p);
         fprintf(fh, "AddParam\n\n");
     }
 
-    for(auto &r : SK.request) {
-        sv.r = r;
-        SaveUsingTable(filename, 'r');
+    for(const Request &r : snapshot->request) {
+        SaveUsingTable(fh, filename, 'r', &r);
         fprintf(fh, "AddRequest\n\n");
     }
 
-    for(auto &e : SK.entity) {
-        e.CalculateNumerical(/*forExport=*/true);
-        sv.e = e;
-        SaveUsingTable(filename, 'e');
+    for(const Entity &e : snapshot->entity) {
+        SaveUsingTable(fh, filename, 'e', &e);
         fprintf(fh, "AddEntity\n\n");
     }
 
-    for(auto &c : SK.constraint) {
-        sv.c = c;
-        SaveUsingTable(filename, 'c');
+    for(const Constraint &c : snapshot->constraint) {
+        SaveUsingTable(fh, filename, 'c', &c);
         fprintf(fh, "AddConstraint\n\n");
     }
 
-    for(auto &s : SK.style) {
-        sv.s = s;
-        if(sv.s.h.v >= Style::FIRST_CUSTOM) {
-            SaveUsingTable(filename, 's');
-            fprintf(fh, "AddStyle\n\n");
-        }
+    for(const Style &s : snapshot->style) {
+        SaveUsingTable(fh, filename, 's', &s);
+        fprintf(fh, "AddStyle\n\n");
     }
 
-    // A group will have either a mesh or a shell, but not both; but the code
-    // to print either of those just does nothing if the mesh/shell is empty.
+    // The code to print either the mesh or the shell just does nothing if
+    // it is empty.
 
-    Group *g = SK.GetGroup(*SK.groupOrder.Last());
-    SMesh *m = &g->runningMesh;
+    SMesh *m = &snapshot->mesh;
     for(i = 0; i < m->l.n; i++) {
         STriangle *tr = &(m->l[i]);
         fprintf(fh, "Triangle %08x %08x "
@@ -353,7 +639,7 @@ bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
             CO(tr->a), CO(tr->b), CO(tr->c));
     }
 
-    SShell *s = &g->runningShell;
+    SShell *s = &snapshot->shell;
     for(SSurface &srf : s->surface) {
         fprintf(fh, "Surface %08x %08x %08x %d %d\n",
             srf.h.v, srf.color.ToPackedInt(), srf.face, srf.degm, srf.degn);
@@ -394,157 +680,261 @@ bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
         fprintf(fh, "AddCurve\n");
     }
 
-    fclose(fh);
+    bool ok = !ferror(fh);
+    if(fclose(fh) != 0) ok = false;
+    if(!ok || !RenameFile(tempFile, filename)) {
+        RemoveFile(tempFile);
+        return false;
+    }
+    return true;
+}
+
+bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
+    Profile::Scope scope("Save");
+    std::shared_ptr<SaveSnapshot> snapshot = TakeSaveSnapshot(filename);
+    if(!snapshot) return false;
+
+    // Don't let an autosave still being written race with this one.
+    FinishBackgroundSave();
+    if(!WriteSaveSnapshot(snapshot.get(), filename)) {
+        Error("Couldn't write to file '%s'", filename.raw.c_str());
+        return false;
+    }
+
+    // Keep the binary cache up to date, if there is one.
+    Platform::Path cache = filename.WithExtension(CACHE_EXT);
+    if(filename.HasExtension(SKETCH_EXT) && FileExists(cache)) {
+        SaveToBinaryCache(cache, filename);
+    }
 
     return true;
 }
 
-void SolveSpaceUI::LoadUsingTable(const Platform::Path &filename, char *key, char *val) {
-    int i;
-    for(i = 0; SAVED[i].type != 0; i++) {
-        if(strcmp(SAVED[i].desc, key)==0) {
-            SAVEDptr *p = (SAVEDptr *)SAVED[i].ptr;
-            unsigned int u = 0;
-            switch(SAVED[i].fmt) {
-                case 'S': p->S() = val;                     break;
-                case 'b': p->b() = (atoi(val) != 0);        break;
-                case 'd': p->d() = atoi(val);               break;
-                case 'f': p->f() = atof(val);               break;
-                case 'x': sscanf(val, "%x", &u); p->x()= u; break;
-
-                case 'P': {
-                    Platform::Path path = Platform::Path::FromPortable(val);
-                    if(!path.IsEmpty()) {
-                        p->P() = filename.Parent().Join(path).Expand();
-                    }
-                    break;
-                }
+// Only taking the snapshot happens here; it is written out on another thread,
+// so that saving a large sketch doesn't hold up editing it.
+void SolveSpaceUI::SaveToFileInBackground(const Platform::Path &filename) {
+    FinishBackgroundSave();
 
-                case 'c':
-                    sscanf(val, "%x", &u);
-                    p->c() = RgbaColor::FromPackedInt(u);
-                    break;
+    std::shared_ptr<SaveSnapshot> snapshot = TakeSaveSnapshot(filename);
+    if(!snapshot) return;
 
-                case 'M': {
-                    p->M().clear();
-                    for(;;) {
-                        EntityKey ek;
-                        EntityId ei;
-                        char line2[1024];
-                        if (fgets(line2, (int)sizeof(line2), fh) == NULL)
-                            break;
-                        if(sscanf(line2, "%d %x %d", &(ei.v), &(ek.input.v),
-                                                     &(ek.copyNumber)) == 3) {
-                            if(ei.v == Entity::NO_ENTITY.v) {
-                                // Commit bd84bc1a mistakenly introduced code that would remap
-                                // some entities to NO_ENTITY. This was fixed in commit bd84bc1a,
-                                // but files created meanwhile are corrupt, and can cause crashes.
-                                //
-                                // To fix this, we skip any such remaps when loading; they will be
-                                // recreated on the next regeneration. Any resulting orphans will
-                                // be pruned in the usual way, recovering to a well-defined state.
-                                continue;
-                            }
-                            p->M().insert({ ek, ei });
-                        } else {
-                            break;
-                        }
-                    }
-                    break;
-                }
+    backgroundSaveFile = filename;
+    backgroundSave = std::async(std::launch::async, [snapshot, filename]() -> bool {
+        return WriteSaveSnapshot(snapshot.get(), filename);
+    });
+}
+
+void SolveSpaceUI::FinishBackgroundSave() {
+    if(!backgroundSave.valid()) return;
 
-                case 'i': break;
+    if(!backgroundSave.get()) {
+        Error("Couldn't write to file '%s'", backgroundSaveFile.raw.c_str());
+    }
+}
 
-                default: ssassert(false, "Unexpected value format");
+void SolveSpaceUI::LoadUsingTable(const Platform::Path &filename, char *key, char *val,
+                                  SlvsLineReader *lines) {
+    static const PerfectHash savedKeys([]() -> std::vector<const char *> {
+        std::vector<const char *> keys;
+        for(int i = 0; SAVED[i].type != 0; i++) {
+            keys.push_back(SAVED[i].desc);
+        }
+        return keys;
+    }());
+
+    int i = savedKeys.Find(key);
+    if(i < 0) {
+        fileLoadError = true;
+        return;
+    }
+
+    SAVEDptr *p = (SAVEDptr *)SAVED[i].ptr;
+    SlvsFieldReader fr(val);
+    switch(SAVED[i].fmt) {
+        case 'S': p->S() = val;                     break;
+        case 'b': p->b() = (fr.Int() != 0);         break;
+        case 'd': p->d() = fr.Int();                break;
+        case 'f': p->f() = fr.Double();             break;
+        case 'x': p->x() = fr.Hex();                break;
+
+        case 'P': {
+            Platform::Path path = Platform::Path::FromPortable(val);
+            if(!path.IsEmpty()) {
+                p->P() = filename.Parent().Join(path).Expand();
             }
             break;
         }
-    }
-    if(SAVED[i].type == 0) {
-        fileLoadError = true;
+
+        case 'c':
+            p->c() = RgbaColor::FromPackedInt(fr.Hex());
+            break;
+
+        case 'M': {
+            p->M().clear();
+            while(char *line2 = lines->Next()) {
+                SlvsFieldReader fr2(line2);
+                EntityKey ek;
+                EntityId ei;
+                ei.v          = fr2.Int();
+                ek.input.v    = fr2.Hex();
+                ek.copyNumber = fr2.Int();
+                if(!fr2.ok) break;
+
+                if(ei.v == Entity::NO_ENTITY.v) {
+                    // Commit bd84bc1a mistakenly introduced code that would remap
+                    // some entities to NO_ENTITY. This was fixed in commit bd84bc1a,
+                    // but files created meanwhile are corrupt, and can cause crashes.
+                    //
+                    // To fix this, we skip any such remaps when loading; they will be
+                    // recreated on the next regeneration. Any resulting orphans will
+                    // be pruned in the usual way, recovering to a well-defined state.
+                    continue;
+                }
+                p->M().insert({ ek, ei });
+            }
+            break;
+        }
+
+        case 'i': break;
+
+        default: ssassert(false, "Unexpected value format");
     }
 }
 
 bool SolveSpaceUI::LoadFromFile(const Platform::Path &filename, bool canCancel) {
+    Profile::Scope scope("Load");
     bool fileIsEmpty = true;
     allConsistent = false;
     fileLoadError = false;
 
-    fh = OpenFile(filename, "rb");
-    if(!fh) {
-        Error("Couldn't read from file '%s'", filename.raw.c_str());
-        return false;
-    }
+    auto addRecord = [&](char type) {
+        switch(type) {
+            case 'g':
+                // legacy files have a spurious dependency between linked groups
+                // and their parent groups, remove
+                if(sv.g.type == Group::Type::LINKED)
+                    sv.g.opA.v = 0;
+
+                SK.group.AddUnsorted(&(sv.g));
+                sv.g = {};
+                sv.g.scale = 1; // default is 1, not 0; so legacy files need this
+                break;
 
-    ClearExisting();
+            case 'p':
+                // params are regenerated, but we want to preload the values
+                // for initial guesses
+                SK.param.AddUnsorted(&(sv.p));
+                sv.p = {};
+                break;
 
-    sv = {};
-    sv.g.scale = 1; // default is 1, not 0; so legacy files need this
-    Style::FillDefaultStyle(&sv.s);
+            case 'e':
+                // entities are regenerated
+                break;
 
-    char line[1024];
-    while(fgets(line, (int)sizeof(line), fh)) {
-        fileIsEmpty = false;
+            case 'r':
+                SK.request.AddUnsorted(&(sv.r));
+                sv.r = {};
+                break;
 
-        char *s = strchr(line, '\n');
-        if(s) *s = '\0';
-        // We should never get files with \r characters in them, but mailers
-        // will sometimes mangle attachments.
-        s = strchr(line, '\r');
-        if(s) *s = '\0';
+            case 'c':
+                SK.constraint.AddUnsorted(&(sv.c));
+                sv.c = {};
+                break;
 
-        if(*line == '\0') continue;
+            case 's':
+                SK.style.AddUnsorted(&(sv.s));
+                sv.s = {};
+                Style::FillDefaultStyle(&sv.s);
+                break;
+        }
+    };
+    auto resetRecords = [&]() {
+        sv = {};
+        sv.g.scale = 1; // default is 1, not 0; so legacy files need this
+        Style::FillDefaultStyle(&sv.s);
+    };
 
-        char *e = strchr(line, '=');
-        if(e) {
-            *e = '\0';
-            char *key = line, *val = e+1;
-            LoadUsingTable(filename, key, val);
-        } else if(strcmp(line, "AddGroup")==0) {
-            // legacy files have a spurious dependency between linked groups
-            // and their parent groups, remove
-            if(sv.g.type == Group::Type::LINKED)
-                sv.g.opA.v = 0;
-
-            SK.group.Add(&(sv.g));
-            sv.g = {};
-            sv.g.scale = 1; // default is 1, not 0; so legacy files need this
-        } else if(strcmp(line, "AddParam")==0) {
-            // params are regenerated, but we want to preload the values
-            // for initial guesses
-            SK.param.Add(&(sv.p));
-            sv.p = {};
-        } else if(strcmp(line, "AddEntity")==0) {
-            // entities are regenerated
-        } else if(strcmp(line, "AddRequest")==0) {
-            SK.request.Add(&(sv.r));
-            sv.r = {};
-        } else if(strcmp(line, "AddConstraint")==0) {
-            SK.constraint.Add(&(sv.c));
-            sv.c = {};
-        } else if(strcmp(line, "AddStyle")==0) {
-            SK.style.Add(&(sv.s));
-            sv.s = {};
-            Style::FillDefaultStyle(&sv.s);
-        } else if(strcmp(line, VERSION_STRING)==0) {
-            // do nothing, version string
-        } else if(StrStartsWith(line, "Triangle ")      ||
-                  StrStartsWith(line, "Surface ")       ||
-                  StrStartsWith(line, "SCtrl ")         ||
-                  StrStartsWith(line, "TrimBy ")        ||
-                  StrStartsWith(line, "Curve ")         ||
-                  StrStartsWith(line, "CCtrl ")         ||
-                  StrStartsWith(line, "CurvePt ")       ||
-                  strcmp(line, "AddSurface")==0         ||
-                  strcmp(line, "AddCurve")==0)
-        {
-            // ignore the mesh or shell, since we regenerate that
-        } else {
-            fileLoadError = true;
+    // A binary file, or an up to date binary cache next to a text file,
+    // loads without any parsing.
+    bool isBinary = filename.HasExtension(CACHE_EXT);
+    Platform::Path source, cache = filename;
+    if(!isBinary) {
+        source = filename;
+        cache  = filename.WithExtension(CACHE_EXT);
+    }
+    bool loadedBinary = false;
+    if(isBinary || (filename.HasExtension(SKETCH_EXT) && FileExists(cache))) {
+        ClearExisting();
+        resetRecords();
+
+        loadedBinary = LoadFromBinaryCache(cache, source, addRecord,
+                                           /*m=*/NULL, /*sh=*/NULL);
+        if(!loadedBinary && isBinary) {
+            Error("Couldn't read from file '%s'", filename.raw.c_str());
+            NewFile();
+            return false;
         }
+        fileIsEmpty = !loadedBinary;
     }
 
-    fclose(fh);
+    if(!loadedBinary) {
+        // A stale or damaged cache is simply ignored.
+        fileLoadError = false;
+
+        std::string data;
+        if(!ReadFile(filename, &data)) {
+            Error("Couldn't read from file '%s'", filename.raw.c_str());
+            return false;
+        }
+
+        ClearExisting();
+        resetRecords();
+
+        SlvsLineReader lines(&data);
+        while(char *line = lines.Next()) {
+            fileIsEmpty = false;
+
+            if(*line == '\0') continue;
+
+            char *e = strchr(line, '=');
+            if(e) {
+                *e = '\0';
+                char *key = line, *val = e+1;
+                LoadUsingTable(filename, key, val, &lines);
+                continue;
+            }
+
+            const char *args = "";
+            switch(FindMarker(line, &args)) {
+                case SlvsMarker::ADD_GROUP:      addRecord('g'); break;
+                case SlvsMarker::ADD_PARAM:      addRecord('p'); break;
+                case SlvsMarker::ADD_ENTITY:     addRecord('e'); break;
+                case SlvsMarker::ADD_REQUEST:    addRecord('r'); break;
+                case SlvsMarker::ADD_CONSTRAINT: addRecord('c'); break;
+                case SlvsMarker::ADD_STYLE:      addRecord('s'); break;
+
+                case SlvsMarker::VERSION:
+                    // do nothing, version string
+                    break;
+
+                case SlvsMarker::TRIANGLE:
+                case SlvsMarker::SURFACE:
+                case SlvsMarker::SCTRL:
+                case SlvsMarker::TRIM_BY:
+                case SlvsMarker::ADD_SURFACE:
+                case SlvsMarker::CURVE:
+                case SlvsMarker::CCTRL:
+                case SlvsMarker::CURVE_PT:
+                case SlvsMarker::ADD_CURVE:
+                    // ignore the mesh or shell, since we regenerate that
+                    break;
+
+                case SlvsMarker::UNKNOWN:
+                    fileLoadError = true;
+                    break;
+            }
+        }
+    }
 
     if(fileIsEmpty) {
         Error(_("The file is empty. It may be corrupt."));
@@ -722,137 +1112,841 @@ bool SolveSpaceUI::LoadEntitiesFromSlvs(const Platform::Path &filename, EntityLi
     SSurface srf = {};
     SCurve crv = {};
 
-    fh = OpenFile(filename, "rb");
-    if(!fh) return false;
+    auto addRecord = [&](char type) {
+        switch(type) {
+            case 'g':
+                // These get allocated whether we want them or not.
+                sv.g.remap.clear();
+                break;
+
+            case 'e':
+                le->Add(&(sv.e));
+                sv.e = {};
+                break;
+
+            case 's':
+                // Linked file contains a style that we don't have yet,
+                // so import it.
+                if (SK.style.FindByIdNoOops(sv.s.h) == nullptr) {
+                    SK.style.Add(&(sv.s));
+                }
+                sv.s = {};
+                Style::FillDefaultStyle(&sv.s);
+                break;
+        }
+    };
+
+    // Prefer the binary form, if it is what we link, or if an up to date
+    // cache of the text file exists.
+    bool isBinary = filename.HasExtension(CACHE_EXT);
+    Platform::Path source, cache = filename;
+    if(!isBinary) {
+        source = filename;
+        cache  = filename.WithExtension(CACHE_EXT);
+    }
+    if(isBinary || (filename.HasExtension(SKETCH_EXT) && FileExists(cache))) {
+        le->Clear();
+        sv = {};
+        if(LoadFromBinaryCache(cache, source, addRecord, m, sh)) {
+            return true;
+        } else if(isBinary) {
+            return false;
+        }
+        m->Clear();
+        sh->Clear();
+    }
+
+    std::string data;
+    if(!ReadFile(filename, &data)) return false;
 
     le->Clear();
     sv = {};
 
-    char line[1024];
-    while(fgets(line, (int)sizeof(line), fh)) {
-        char *s = strchr(line, '\n');
-        if(s) *s = '\0';
-        // We should never get files with \r characters in them, but mailers
-        // will sometimes mangle attachments.
-        s = strchr(line, '\r');
-        if(s) *s = '\0';
-
+    SlvsLineReader lines(&data);
+    while(char *line = lines.Next()) {
         if(*line == '\0') continue;
 
         char *e = strchr(line, '=');
         if(e) {
             *e = '\0';
             char *key = line, *val = e+1;
-            LoadUsingTable(filename, key, val);
-        } else if(strcmp(line, "AddGroup")==0) {
-            // These get allocated whether we want them or not.
-            sv.g.remap.clear();
-        } else if(strcmp(line, "AddParam")==0) {
-
-        } else if(strcmp(line, "AddEntity")==0) {
-            le->Add(&(sv.e));
-            sv.e = {};
-        } else if(strcmp(line, "AddRequest")==0) {
-
-        } else if(strcmp(line, "AddConstraint")==0) {
-
-        } else if(strcmp(line, "AddStyle")==0) {
-            // Linked file contains a style that we don't have yet,
-            // so import it.
-            if (SK.style.FindByIdNoOops(sv.s.h) == nullptr) {
-                SK.style.Add(&(sv.s));
-            }
-            sv.s = {};
-            Style::FillDefaultStyle(&sv.s);
-        } else if(strcmp(line, VERSION_STRING)==0) {
-
-        } else if(StrStartsWith(line, "Triangle ")) {
+            LoadUsingTable(filename, key, val, &lines);
+            continue;
+        }
+
+        const char *args = "";
+        SlvsMarker marker = FindMarker(line, &args);
+        SlvsFieldReader fr(args);
+        switch(marker) {
+            case SlvsMarker::ADD_GROUP:      addRecord('g'); break;
+            case SlvsMarker::ADD_PARAM:      addRecord('p'); break;
+            case SlvsMarker::ADD_ENTITY:     addRecord('e'); break;
+            case SlvsMarker::ADD_REQUEST:    addRecord('r'); break;
+            case SlvsMarker::ADD_CONSTRAINT: addRecord('c'); break;
+            case SlvsMarker::ADD_STYLE:      addRecord('s'); break;
+
+            case SlvsMarker::VERSION:
+                break;
+
+            case SlvsMarker::TRIANGLE: {
+                STriangle tr = {};
+                tr.meta.face  = fr.Hex();
+                tr.meta.color = RgbaColor::FromPackedInt(fr.Hex());
+                tr.a = fr.Point();
+                tr.b = fr.Point();
+                tr.c = fr.Point();
+                ssassert(fr.ok, "Unexpected Triangle format");
+                m->AddTriangle(&tr);
+                break;
+            }
+
+            case SlvsMarker::SURFACE:
+                srf.h.v   = fr.Hex();
+                srf.color = RgbaColor::FromPackedInt(fr.Hex());
+                srf.face  = fr.Hex();
+                srf.degm  = fr.Int();
+                srf.degn  = fr.Int();
+                ssassert(fr.ok, "Unexpected Surface format");
+                break;
+
+            case SlvsMarker::SCTRL: {
+                int i = fr.Int(),
+                    j = fr.Int();
+                Vector c = fr.Point();
+                fr.Word("Weight");
+                double w = fr.Double();
+                ssassert(fr.ok, "Unexpected SCtrl format");
+                srf.ctrl[i][j] = c;
+                srf.weight[i][j] = w;
+                break;
+            }
+
+            case SlvsMarker::TRIM_BY: {
+                STrimBy stb = {};
+                stb.curve.v   = fr.Hex();
+                stb.backwards = (fr.Int() != 0);
+                stb.start     = fr.Point();
+                stb.finish    = fr.Point();
+                ssassert(fr.ok, "Unexpected TrimBy format");
+                srf.trim.Add(&stb);
+                break;
+            }
+
+            case SlvsMarker::ADD_SURFACE:
+                sh->surface.Add(&srf);
+                srf = {};
+                break;
+
+            case SlvsMarker::CURVE:
+                crv.h.v       = fr.Hex();
+                crv.isExact   = (fr.Int() != 0);
+                crv.exact.deg = fr.Int();
+                crv.surfA.v   = fr.Hex();
+                crv.surfB.v   = fr.Hex();
+                ssassert(fr.ok, "Unexpected Curve format");
+                break;
+
+            case SlvsMarker::CCTRL: {
+                int i = fr.Int();
+                Vector c = fr.Point();
+                fr.Word("Weight");
+                double w = fr.Double();
+                ssassert(fr.ok, "Unexpected CCtrl format");
+                crv.exact.ctrl[i] = c;
+                crv.exact.weight[i] = w;
+                break;
+            }
+
+            case SlvsMarker::CURVE_PT: {
+                SCurvePt scpt;
+                scpt.vertex = (fr.Int() != 0);
+                scpt.p      = fr.Point();
+                ssassert(fr.ok, "Unexpected CurvePt format");
+                crv.pts.Add(&scpt);
+                break;
+            }
+
+            case SlvsMarker::ADD_CURVE:
+                sh->curve.Add(&crv);
+                crv = {};
+                break;
+
+            case SlvsMarker::UNKNOWN:
+                ssassert(false, "Unexpected operation");
+        }
+    }
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// The binary form of our file format. It holds the same data as the text form,
+// but loads without any parsing: the file is mapped into memory, a table in
+// the header locates each section, the sketch is a stream of (key, value)
+// records, and the mesh and shell are arrays of fixed-size records that are
+// read in place. It is used either as a standalone file, or as a cache of
+// a text file with the same name, valid while the text file is unchanged.
+//-----------------------------------------------------------------------------
+static const char     BINARY_MAGIC[8]   = { 'S', 'L', 'V', 'S', 'B', 'I', 'N', '\0' };
+static const uint32_t BINARY_BYTE_ORDER = 0x01020304;
+static const uint32_t BINARY_VERSION    = 2;
+
+enum class BinarySection : uint32_t {
+    KEYS        = 1,
+    GROUPS      = 2,
+    PARAMS      = 3,
+    REQUESTS    = 4,
+    ENTITIES    = 5,
+    CONSTRAINTS = 6,
+    STYLES      = 7,
+    TRIANGLES   = 8,
+    SURFACES    = 9,
+    CURVES      = 10,
+};
+
+// The sketch records, in the order they're loaded, same as the text form.
+static const struct {
+    BinarySection section;
+    char          type;
+} BINARY_RECORDS[] = {
+    { BinarySection::GROUPS,      'g' },
+    { BinarySection::PARAMS,      'p' },
+    { BinarySection::REQUESTS,    'r' },
+    { BinarySection::ENTITIES,    'e' },
+    { BinarySection::CONSTRAINTS, 'c' },
+    { BinarySection::STYLES,      's' },
+};
+
+struct BinaryHeader {
+    char     magic[8];
+    uint32_t byteOrder;
+    uint32_t version;
+    // The size and a hash of the contents of the text file that this caches,
+    // or zero for a standalone file.
+    uint64_t sourceSize;
+    uint64_t sourceHash;
+    uint32_t sectionCount;
+    uint32_t reserved;
+};
+
+struct BinarySectionEntry {
+    BinarySection kind;
+    uint32_t      count;
+    uint64_t      offset;
+    uint64_t      size;
+};
+
+struct BinaryTriangle {
+    uint32_t face;
+    uint32_t color;
+    Vector   a, b, c;
+};
+
+struct BinarySurface {
+    uint32_t h;
+    uint32_t color;
+    uint32_t face;
+    int32_t  degm, degn;
+    // Followed by this many BinaryTrimBy.
+    uint32_t trimCount;
+    Vector   ctrl[4][4];
+    double   weight[4][4];
+};
+
+struct BinaryTrimBy {
+    uint32_t curve;
+    uint32_t backwards;
+    Vector   start;
+    Vector   finish;
+};
+
+struct BinaryCurve {
+    uint32_t h;
+    uint32_t isExact;
+    int32_t  deg;
+    uint32_t surfA, surfB;
+    // Followed by this many BinaryCurvePt.
+    uint32_t ptCount;
+    Vector   ctrl[4];
+    double   weight[4];
+};
+
+struct BinaryCurvePt {
+    uint32_t vertex;
+    uint32_t reserved;
+    Vector   p;
+};
+
+// The fixed-size records are read in place, so they must not need padding
+// that a different compiler could lay out differently.
+static_assert(sizeof(BinaryTriangle) == 80 && sizeof(BinarySurface) == 536 &&
+              sizeof(BinaryTrimBy) == 56 && sizeof(BinaryCurve) == 152 &&
+              sizeof(BinaryCurvePt) == 32, "Unexpected binary record layout");
+
+template<class T>
+static void BinaryPut(std::string *out, const T &v) {
+    out->append((const char *)&v, sizeof(T));
+}
+
+static void BinaryPutString(std::string *out, const std::string &str) {
+    BinaryPut(out, (uint32_t)str.size());
+    out->append(str);
+}
+
+static void BinaryAlign(std::string *out) {
+    out->resize((out->size() + 7) & ~(size_t)7, '\0');
+}
+
+class BinaryReader {
+public:
+    const uint8_t *p;
+    const uint8_t *end;
+    bool           ok;
+
+    BinaryReader(const uint8_t *p, size_t size) : p(p), end(p + size), ok(true) {}
+
+    template<class T>
+    T Get() {
+        T v = {};
+        if((size_t)(end - p) < sizeof(T)) {
+            ok = false;
+            return v;
+        }
+        memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+
+    std::string GetString() {
+        uint32_t n = Get<uint32_t>();
+        if(!ok || (size_t)(end - p) < n) {
+            ok = false;
+            return "";
+        }
+        std::string str((const char *)p, n);
+        p += n;
+        return str;
+    }
+
+    // Returns a pointer to count records directly in the mapped file.
+    template<class T>
+    const T *GetArray(size_t count) {
+        if(count > (size_t)(end - p) / sizeof(T) ||
+           ((uintptr_t)p % alignof(T)) != 0) {
+            ok = false;
+            return NULL;
+        }
+        const T *arr = (const T *)p;
+        p += count * sizeof(T);
+        return arr;
+    }
+};
+
+static void SaveBinaryUsingTable(std::string *out, const Platform::Path &filename, int type) {
+    size_t countAt = out->size();
+    uint32_t count = 0;
+    BinaryPut(out, count);
+
+    for(int i = 0; SolveSpaceUI::SAVED[i].type != 0; i++) {
+        if(SolveSpaceUI::SAVED[i].type != type) continue;
+
+        int fmt = SolveSpaceUI::SAVED[i].fmt;
+        // Ignored items have no field to save.
+        if(fmt == 'i') continue;
+
+        SAVEDptr *p = (SAVEDptr *)SolveSpaceUI::SAVED[i].ptr;
+        // Any items that aren't specified are assumed to be zero
+        if(fmt == 'S' && p->S().empty())          continue;
+        if(fmt == 'P' && p->P().IsEmpty())        continue;
+        if(fmt == 'd' && p->d() == 0)             continue;
+        if(fmt == 'f' && EXACT(p->f() == 0.0))    continue;
+        if(fmt == 'x' && p->x() == 0)             continue;
+
+        BinaryPut(out, (uint32_t)i);
+        switch(fmt) {
+            case 'S': BinaryPutString(out, p->S());               break;
+            case 'b': BinaryPut(out, (uint32_t)(p->b() ? 1 : 0)); break;
+            case 'c': BinaryPut(out, p->c().ToPackedInt());       break;
+            case 'd': BinaryPut(out, (int32_t)p->d());            break;
+            case 'f': BinaryPut(out, p->f());                     break;
+            case 'x': BinaryPut(out, p->x());                     break;
+
+            case 'P': {
+                Platform::Path relativePath = p->P().RelativeTo(filename.Parent());
+                ssassert(!relativePath.IsEmpty(), "Cannot relativize path");
+                BinaryPutString(out, relativePath.ToPortable());
+                break;
+            }
+
+            case 'M': {
+                // Sort the mapping, since EntityMap is not deterministic.
+                std::vector<std::pair<EntityKey, EntityId>> sorted(p->M().begin(), p->M().end());
+                std::sort(sorted.begin(), sorted.end(),
+                    [](std::pair<EntityKey, EntityId> &a, std::pair<EntityKey, EntityId> &b) {
+                        return a.second.v < b.second.v;
+                    });
+                BinaryPut(out, (uint32_t)sorted.size());
+                for(auto it : sorted) {
+                    BinaryPut(out, (uint32_t)it.second.v);
+                    BinaryPut(out, it.first.input.v);
+                    BinaryPut(out, (int32_t)it.first.copyNumber);
+                }
+                break;
+            }
+
+            default: ssassert(false, "Unexpected value format");
+        }
+        count++;
+    }
+
+    memcpy(&(*out)[countAt], &count, sizeof(count));
+}
+
+// Reads one value in the given format; if savedIndex is negative, the key
+// is not one we know about, and the value is skipped.
+static void LoadBinaryUsingTable(BinaryReader *r, const Platform::Path &filename,
+                                 char fmt, int savedIndex) {
+    SAVEDptr *p = (savedIndex >= 0) ? (SAVEDptr *)SolveSpaceUI::SAVED[savedIndex].ptr : NULL;
+    switch(fmt) {
+        case 'S': {
+            std::string str = r->GetString();
+            if(p) p->S() = str;
+            break;
+        }
+        case 'b': {
+            uint32_t v = r->Get<uint32_t>();
+            if(p) p->b() = (v != 0);
+            break;
+        }
+        case 'c': {
+            uint32_t v = r->Get<uint32_t>();
+            if(p) p->c() = RgbaColor::FromPackedInt(v);
+            break;
+        }
+        case 'd': {
+            int32_t v = r->Get<int32_t>();
+            if(p) p->d() = v;
+            break;
+        }
+        case 'f': {
+            double v = r->Get<double>();
+            if(p) p->f() = v;
+            break;
+        }
+        case 'x': {
+            uint32_t v = r->Get<uint32_t>();
+            if(p) p->x() = v;
+            break;
+        }
+
+        case 'P': {
+            Platform::Path path = Platform::Path::FromPortable(r->GetString());
+            if(p && !path.IsEmpty()) {
+                p->P() = filename.Parent().Join(path).Expand();
+            }
+            break;
+        }
+
+        case 'M': {
+            if(p) p->M().clear();
+            uint32_t n = r->Get<uint32_t>();
+            for(uint32_t i = 0; i < n && r->ok; i++) {
+                EntityKey ek;
+                EntityId ei;
+                ei.v            = r->Get<uint32_t>();
+                ek.input.v      = r->Get<uint32_t>();
+                ek.copyNumber   = r->Get<int32_t>();
+                // See the text loader for why these are skipped.
+                if(ei.v == Entity::NO_ENTITY.v) continue;
+                if(p) p->M().insert({ ek, ei });
+            }
+            break;
+        }
+
+        default:
+            r->ok = false;
+            break;
+    }
+}
+
+// A file can be changed within the resolution of its modification time, or
+// replaced by an older one, so a binary cache or a linked file already loaded
+// is only trusted to be current if the contents are the same.
+static bool GetSourceStamp(const Platform::Path &source, uint64_t *size, uint64_t *hash) {
+    Platform::MappedFile file;
+    if(!file.Open(source)) return false;
+
+    // FNV-1a.
+    uint64_t h = 14695981039346656037ull;
+    for(size_t i = 0; i < file.size; i++) {
+        h ^= file.data[i];
+        h *= 1099511628211ull;
+    }
+    *size = file.size;
+    *hash = h;
+    return true;
+}
+
+bool SolveSpaceUI::SaveToBinaryCache(const Platform::Path &filename,
+                                     const Platform::Path &source) {
+    for(Group &g : SK.group) {
+        if(g.type != Group::Type::LINKED) continue;
+
+        if(g.linkFile.RelativeTo(filename).IsEmpty()) {
+            Error("This sketch links the sketch '%s'; it can only be saved "
+                  "on the same volume.", g.linkFile.raw.c_str());
+            return false;
+        }
+    }
+
+    std::vector<BinarySectionEntry> sections;
+    std::string data;
+
+    auto beginSection = [&](BinarySection kind, size_t count) {
+        BinaryAlign(&data);
+        BinarySectionEntry entry = {};
+        entry.kind   = kind;
+        entry.count  = (uint32_t)count;
+        entry.offset = data.size();
+        sections.push_back(entry);
+    };
+    auto endSection = [&]() {
+        sections.back().size = data.size() - sections.back().offset;
+    };
+
+    // The names and formats of the keys; records refer to them by index, so
+    // that the table is free to change between versions.
+    int keyCount = 0;
+    while(SAVED[keyCount].type != 0) keyCount++;
+    beginSection(BinarySection::KEYS, keyCount);
+    for(int i = 0; i < keyCount; i++) {
+        BinaryPut(&data, SAVED[i].fmt);
+        BinaryPutString(&data, SAVED[i].desc);
+    }
+    endSection();
+
+    beginSection(BinarySection::GROUPS, SK.group.n);
+    for(auto &g : SK.group) {
+        sv.g = g;
+        SaveBinaryUsingTable(&data, filename, 'g');
+    }
+    endSection();
+
+    beginSection(BinarySection::PARAMS, SK.param.n);
+    for(auto &p : SK.param) {
+        sv.p = p;
+        SaveBinaryUsingTable(&data, filename, 'p');
+    }
+    endSection();
+
+    beginSection(BinarySection::REQUESTS, SK.request.n);
+    for(auto &r : SK.request) {
+        sv.r = r;
+        SaveBinaryUsingTable(&data, filename, 'r');
+    }
+    endSection();
+
+    beginSection(BinarySection::ENTITIES, SK.entity.n);
+    for(auto &e : SK.entity) {
+        e.CalculateNumerical(/*forExport=*/true);
+        sv.e = e;
+        SaveBinaryUsingTable(&data, filename, 'e');
+    }
+    endSection();
+
+    beginSection(BinarySection::CONSTRAINTS, SK.constraint.n);
+    for(auto &c : SK.constraint) {
+        sv.c = c;
+        SaveBinaryUsingTable(&data, filename, 'c');
+    }
+    endSection();
+
+    size_t styleCount = 0;
+    for(auto &s : SK.style) {
+        if(s.h.v >= Style::FIRST_CUSTOM) styleCount++;
+    }
+    beginSection(BinarySection::STYLES, styleCount);
+    for(auto &s : SK.style) {
+        sv.s = s;
+        if(sv.s.h.v >= Style::FIRST_CUSTOM) {
+            SaveBinaryUsingTable(&data, filename, 's');
+        }
+    }
+    endSection();
+
+    Group *g = SK.GetGroup(*SK.groupOrder.Last());
+    SMesh *m = &g->runningMesh;
+    beginSection(BinarySection::TRIANGLES, m->l.n);
+    for(const STriangle &tr : m->l) {
+        BinaryTriangle btr = {};
+        btr.face  = tr.meta.face;
+        btr.color = tr.meta.color.ToPackedInt();
+        btr.a     = tr.a;
+        btr.b     = tr.b;
+        btr.c     = tr.c;
+        BinaryPut(&data, btr);
+    }
+    endSection();
+
+    SShell *sh = &g->runningShell;
+    beginSection(BinarySection::SURFACES, sh->surface.n);
+    for(SSurface &srf : sh->surface) {
+        BinarySurface bsrf = {};
+        bsrf.h         = srf.h.v;
+        bsrf.color     = srf.color.ToPackedInt();
+        bsrf.face      = srf.face;
+        bsrf.degm      = srf.degm;
+        bsrf.degn      = srf.degn;
+        bsrf.trimCount = srf.trim.n;
+        for(int i = 0; i <= srf.degm; i++) {
+            for(int j = 0; j <= srf.degn; j++) {
+                bsrf.ctrl[i][j]   = srf.ctrl[i][j];
+                bsrf.weight[i][j] = srf.weight[i][j];
+            }
+        }
+        BinaryPut(&data, bsrf);
+
+        for(const STrimBy &stb : srf.trim) {
+            BinaryTrimBy bstb = {};
+            bstb.curve     = stb.curve.v;
+            bstb.backwards = stb.backwards ? 1 : 0;
+            bstb.start     = stb.start;
+            bstb.finish    = stb.finish;
+            BinaryPut(&data, bstb);
+        }
+    }
+    endSection();
+
+    beginSection(BinarySection::CURVES, sh->curve.n);
+    for(SCurve &sc : sh->curve) {
+        BinaryCurve bsc = {};
+        bsc.h       = sc.h.v;
+        bsc.isExact = sc.isExact ? 1 : 0;
+        bsc.deg     = sc.exact.deg;
+        bsc.surfA   = sc.surfA.v;
+        bsc.surfB   = sc.surfB.v;
+        bsc.ptCount = sc.pts.n;
+        if(sc.isExact) {
+            for(int i = 0; i <= sc.exact.deg; i++) {
+                bsc.ctrl[i]   = sc.exact.ctrl[i];
+                bsc.weight[i] = sc.exact.weight[i];
+            }
+        }
+        BinaryPut(&data, bsc);
+
+        for(const SCurvePt &scpt : sc.pts) {
+            BinaryCurvePt bscpt = {};
+            bscpt.vertex = scpt.vertex ? 1 : 0;
+            bscpt.p      = scpt.p;
+            BinaryPut(&data, bscpt);
+        }
+    }
+    endSection();
+
+    BinaryHeader header = {};
+    memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+    header.byteOrder    = BINARY_BYTE_ORDER;
+    header.version      = BINARY_VERSION;
+    header.sectionCount = (uint32_t)sections.size();
+    if(!source.IsEmpty()) {
+        if(!GetSourceStamp(source, &header.sourceSize, &header.sourceHash)) {
+            Error("Couldn't read from file '%s'", source.raw.c_str());
+            return false;
+        }
+    }
+
+    // Sections are placed after the header and the section table, keeping
+    // their alignment.
+    std::string prefix;
+    BinaryPut(&prefix, header);
+    size_t dataStart = (prefix.size() + sections.size() * sizeof(BinarySectionEntry) + 7) &
+                       ~(size_t)7;
+    for(BinarySectionEntry &entry : sections) {
+        entry.offset += dataStart;
+        BinaryPut(&prefix, entry);
+    }
+    prefix.resize(dataStart, '\0');
+
+    fh = OpenFile(filename, "wb");
+    if(!fh) {
+        Error("Couldn't write to file '%s'", filename.raw.c_str());
+        return false;
+    }
+    bool ok = fwrite(prefix.data(), 1, prefix.size(), fh) == prefix.size() &&
+              fwrite(data.data(), 1, data.size(), fh) == data.size();
+    if(fclose(fh) != 0) ok = false;
+    if(!ok) {
+        Error("Couldn't write to file '%s'", filename.raw.c_str());
+        RemoveFile(filename);
+        return false;
+    }
+    return true;
+}
+
+bool SolveSpaceUI::LoadFromBinaryCache(const Platform::Path &filename,
+                                       const Platform::Path &source,
+                                       const std::function<void(char)> &addRecord,
+                                       SMesh *m, SShell *sh) {
+    Platform::MappedFile file;
+    if(!file.Open(filename)) return false;
+
+    BinaryReader r(file.data, file.size);
+    BinaryHeader header = r.Get<BinaryHeader>();
+    if(!r.ok || memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic)) != 0 ||
+       header.byteOrder != BINARY_BYTE_ORDER || header.version != BINARY_VERSION) {
+        return false;
+    }
+    if(!source.IsEmpty()) {
+        uint64_t sourceSize, sourceHash;
+        if(!GetSourceStamp(source, &sourceSize, &sourceHash) ||
+           sourceSize != header.sourceSize || sourceHash != header.sourceHash) {
+            return false;
+        }
+    }
+
+    const BinarySectionEntry *sections = r.GetArray<BinarySectionEntry>(header.sectionCount);
+    if(!r.ok) return false;
+    auto findSection = [&](BinarySection kind, BinaryReader *sr) -> const BinarySectionEntry * {
+        for(uint32_t i = 0; i < header.sectionCount; i++) {
+            const BinarySectionEntry &entry = sections[i];
+            if(entry.kind != kind) continue;
+            if(entry.offset > file.size || entry.size > file.size - entry.offset) break;
+            *sr = BinaryReader(file.data + entry.offset, (size_t)entry.size);
+            return &entry;
+        }
+        return NULL;
+    };
+
+    // Map the keys in the file to our table, once.
+    BinaryReader kr(NULL, 0);
+    const BinarySectionEntry *keys = findSection(BinarySection::KEYS, &kr);
+    if(keys == NULL) return false;
+    std::vector<char> keyFormat;
+    std::vector<int>  keySaved;
+    for(uint32_t i = 0; i < keys->count && kr.ok; i++) {
+        char fmt = kr.Get<char>();
+        std::string desc = kr.GetString();
+        int saved = -1;
+        for(int j = 0; SAVED[j].type != 0; j++) {
+            if(SAVED[j].fmt == fmt && desc == SAVED[j].desc) {
+                saved = j;
+                break;
+            }
+        }
+        if(saved < 0) {
+            fileLoadError = true;
+        }
+        keyFormat.push_back(fmt);
+        keySaved.push_back(saved);
+    }
+    if(!kr.ok) return false;
+
+    for(const auto &record : BINARY_RECORDS) {
+        BinaryReader sr(NULL, 0);
+        const BinarySectionEntry *entry = findSection(record.section, &sr);
+        if(entry == NULL) return false;
+        for(uint32_t i = 0; i < entry->count && sr.ok; i++) {
+            uint32_t fieldCount = sr.Get<uint32_t>();
+            for(uint32_t j = 0; j < fieldCount && sr.ok; j++) {
+                uint32_t key = sr.Get<uint32_t>();
+                if(key >= keyFormat.size()) {
+                    sr.ok = false;
+                    break;
+                }
+                LoadBinaryUsingTable(&sr, filename, keyFormat[key], keySaved[key]);
+            }
+            if(sr.ok) addRecord(record.type);
+        }
+        if(!sr.ok) return false;
+    }
+
+    if(m != NULL) {
+        BinaryReader sr(NULL, 0);
+        const BinarySectionEntry *entry = findSection(BinarySection::TRIANGLES, &sr);
+        if(entry == NULL) return false;
+        const BinaryTriangle *tris = sr.GetArray<BinaryTriangle>(entry->count);
+        if(!sr.ok) return false;
+
+        m->l.ReserveMore(entry->count);
+        for(uint32_t i = 0; i < entry->count; i++) {
             STriangle tr = {};
-            unsigned int rgba = 0;
-            if(sscanf(line, "Triangle %x %x  "
-                             "%lf %lf %lf  %lf %lf %lf  %lf %lf %lf",
-                &(tr.meta.face), &rgba,
-                &(tr.a.x), &(tr.a.y), &(tr.a.z),
-                &(tr.b.x), &(tr.b.y), &(tr.b.z),
-                &(tr.c.x), &(tr.c.y), &(tr.c.z)) != 11) {
-                ssassert(false, "Unexpected Triangle format");
-            }
-            tr.meta.color = RgbaColor::FromPackedInt((uint32_t)rgba);
+            tr.meta.face  = tris[i].face;
+            tr.meta.color = RgbaColor::FromPackedInt(tris[i].color);
+            tr.a          = tris[i].a;
+            tr.b          = tris[i].b;
+            tr.c          = tris[i].c;
             m->AddTriangle(&tr);
-        } else if(StrStartsWith(line, "Surface ")) {
-            unsigned int rgba = 0;
-            if(sscanf(line, "Surface %x %x %x %d %d",
-                &(srf.h.v), &rgba, &(srf.face),
-                &(srf.degm), &(srf.degn)) != 5) {
-                ssassert(false, "Unexpected Surface format");
-            }
-            srf.color = RgbaColor::FromPackedInt((uint32_t)rgba);
-        } else if(StrStartsWith(line, "SCtrl ")) {
-            int i, j;
-            Vector c;
-            double w;
-            if(sscanf(line, "SCtrl %d %d %lf %lf %lf Weight %lf",
-                                &i, &j, &(c.x), &(c.y), &(c.z), &w) != 6)
-            {
-                ssassert(false, "Unexpected SCtrl format");
-            }
-            srf.ctrl[i][j] = c;
-            srf.weight[i][j] = w;
-        } else if(StrStartsWith(line, "TrimBy ")) {
-            STrimBy stb = {};
-            int backwards;
-            if(sscanf(line, "TrimBy %x %d  %lf %lf %lf  %lf %lf %lf",
-                &(stb.curve.v), &backwards,
-                &(stb.start.x), &(stb.start.y), &(stb.start.z),
-                &(stb.finish.x), &(stb.finish.y), &(stb.finish.z)) != 8)
-            {
-                ssassert(false, "Unexpected TrimBy format");
-            }
-            stb.backwards = (backwards != 0);
-            srf.trim.Add(&stb);
-        } else if(strcmp(line, "AddSurface")==0) {
+        }
+    }
+
+    if(sh != NULL) {
+        BinaryReader sr(NULL, 0);
+        const BinarySectionEntry *entry = findSection(BinarySection::SURFACES, &sr);
+        if(entry == NULL) return false;
+        for(uint32_t i = 0; i < entry->count; i++) {
+            const BinarySurface *bsrf = sr.GetArray<BinarySurface>(1);
+            if(!sr.ok || bsrf->degm < 0 || bsrf->degm > 3 ||
+                         bsrf->degn < 0 || bsrf->degn > 3) {
+                return false;
+            }
+            const BinaryTrimBy *bstb = sr.GetArray<BinaryTrimBy>(bsrf->trimCount);
+            if(!sr.ok) return false;
+
+            SSurface srf = {};
+            srf.h.v   = bsrf->h;
+            srf.color = RgbaColor::FromPackedInt(bsrf->color);
+            srf.face  = bsrf->face;
+            srf.degm  = bsrf->degm;
+            srf.degn  = bsrf->degn;
+            for(int j = 0; j <= srf.degm; j++) {
+                for(int k = 0; k <= srf.degn; k++) {
+                    srf.ctrl[j][k]   = bsrf->ctrl[j][k];
+                    srf.weight[j][k] = bsrf->weight[j][k];
+                }
+            }
+            srf.trim.ReserveMore(bsrf->trimCount);
+            for(uint32_t j = 0; j < bsrf->trimCount; j++) {
+                STrimBy stb = {};
+                stb.curve.v   = bstb[j].curve;
+                stb.backwards = (bstb[j].backwards != 0);
+                stb.start     = bstb[j].start;
+                stb.finish    = bstb[j].finish;
+                srf.trim.Add(&stb);
+            }
             sh->surface.Add(&srf);
-            srf = {};
-        } else if(StrStartsWith(line, "Curve ")) {
-            int isExact;
-            if(sscanf(line, "Curve %x %d %d %x %x",
-                &(crv.h.v),
-                &(isExact),
-                &(crv.exact.deg),
-                &(crv.surfA.v), &(crv.surfB.v)) != 5)
-            {
-                ssassert(false, "Unexpected Curve format");
-            }
-            crv.isExact = (isExact != 0);
-        } else if(StrStartsWith(line, "CCtrl ")) {
-            int i;
-            Vector c;
-            double w;
-            if(sscanf(line, "CCtrl %d %lf %lf %lf Weight %lf",
-                                &i, &(c.x), &(c.y), &(c.z), &w) != 5)
-            {
-                ssassert(false, "Unexpected CCtrl format");
-            }
-            crv.exact.ctrl[i] = c;
-            crv.exact.weight[i] = w;
-        } else if(StrStartsWith(line, "CurvePt ")) {
-            SCurvePt scpt;
-            int vertex;
-            if(sscanf(line, "CurvePt %d %lf %lf %lf",
-                &vertex,
-                &(scpt.p.x), &(scpt.p.y), &(scpt.p.z)) != 4)
-            {
-                ssassert(false, "Unexpected CurvePt format");
-            }
-            scpt.vertex = (vertex != 0);
-            crv.pts.Add(&scpt);
-        } else if(strcmp(line, "AddCurve")==0) {
+        }
+
+        entry = findSection(BinarySection::CURVES, &sr);
+        if(entry == NULL) return false;
+        for(uint32_t i = 0; i < entry->count; i++) {
+            const BinaryCurve *bsc = sr.GetArray<BinaryCurve>(1);
+            if(!sr.ok || bsc->deg < 0 || bsc->deg > 3) return false;
+            const BinaryCurvePt *bscpt = sr.GetArray<BinaryCurvePt>(bsc->ptCount);
+            if(!sr.ok) return false;
+
+            SCurve crv = {};
+            crv.h.v       = bsc->h;
+            crv.isExact   = (bsc->isExact != 0);
+            crv.exact.deg = bsc->deg;
+            crv.surfA.v   = bsc->surfA;
+            crv.surfB.v   = bsc->surfB;
+            if(crv.isExact) {
+                for(int j = 0; j <= crv.exact.deg; j++) {
+                    crv.exact.ctrl[j]   = bsc->ctrl[j];
+                    crv.exact.weight[j] = bsc->weight[j];
+                }
+            }
+            crv.pts.ReserveMore(bsc->ptCount);
+            for(uint32_t j = 0; j < bsc->ptCount; j++) {
+                SCurvePt scpt = {};
+                scpt.vertex = (bscpt[j].vertex != 0);
+                scpt.p      = bscpt[j].p;
+                crv.pts.Add(&scpt);
+            }
             sh->curve.Add(&crv);
-            crv = {};
-        } else ssassert(false, "Unexpected operation");
+        }
     }
 
-    fclose(fh);
     return true;
 }
 
@@ -879,19 +1973,48 @@ static Platform::MessageDialog::Response LocateImportedFile(const Platform::Path
     return dialog->RunModal();
 }
 
+LinkedFile::~LinkedFile() {
+    entity.Clear();
+    mesh.Clear();
+    shell.Clear();
+    for(int i = 0; i < SSurface::LOD_LEVELS; i++) {
+        lodMesh[i].Clear();
+        lodOutlines[i].Clear();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Returns the contents of a linked file if some group already has them
+// loaded, and the file hasn't changed since.
+//-----------------------------------------------------------------------------
+std::shared_ptr<LinkedFile> SolveSpaceUI::FindLinkedFile(const Platform::Path &filename) {
+    auto it = linkedFiles.find(filename);
+    if(it == linkedFiles.end()) return nullptr;
+
+    std::shared_ptr<LinkedFile> lf = it->second.lock();
+    uint64_t fileSize, fileHash;
+    if(!lf || !GetSourceStamp(filename, &fileSize, &fileHash) ||
+       lf->fileSize != fileSize || lf->fileHash != fileHash) {
+        linkedFiles.erase(it);
+        return nullptr;
+    }
+    return lf;
+}
+
 bool SolveSpaceUI::ReloadAllLinked(const Platform::Path &saveFile, bool canCancel) {
     Platform::SettingsRef settings = Platform::GetSettings();
 
     std::map<Platform::Path, Platform::Path, Platform::PathLess> linkMap;
+    // The files found current or loaded already during this reload, which
+    // needn't be read again for every other group that links them.
+    std::map<Platform::Path, std::shared_ptr<LinkedFile>, Platform::PathLess> linked;
 
     allConsistent = false;
 
     for(Group &g : SK.group) {
         if(g.type != Group::Type::LINKED) continue;
 
-        g.impEntity.Clear();
-        g.impMesh.Clear();
-        g.impShell.Clear();
+        g.impFile.reset();
 
         // If we prompted for this specific file before, don't ask again.
         if(linkMap.count(g.linkFile)) {
@@ -899,14 +2022,30 @@ bool SolveSpaceUI::ReloadAllLinked(const Platform::Path &saveFile, bool canCance
         }
 
 try_again:
-        if(LoadEntitiesFromFile(g.linkFile, &g.impEntity, &g.impMesh, &g.impShell)) {
+        // Many groups may link the same file; load it only once.
+        if(linked.count(g.linkFile)) {
+            g.impFile = linked[g.linkFile];
+            continue;
+        }
+        g.impFile = FindLinkedFile(g.linkFile);
+        if(g.impFile) {
+            linked[g.linkFile] = g.impFile;
+            continue;
+        }
+
+        std::shared_ptr<LinkedFile> lf = std::make_shared<LinkedFile>();
+        bool haveStamp = GetSourceStamp(g.linkFile, &lf->fileSize, &lf->fileHash);
+        if(haveStamp && LoadEntitiesFromFile(g.linkFile, &lf->entity, &lf->mesh, &lf->shell)) {
             // We loaded the data, good. Now import its dependencies as well.
-            for(Entity &e : g.impEntity) {
+            for(Entity &e : lf->entity) {
                 if(e.type != Entity::Type::IMAGE) continue;
                 if(!ReloadLinkedImage(g.linkFile, &e.file, canCancel)) {
                     return false;
                 }
             }
+            g.impFile = lf;
+            linkedFiles[g.linkFile] = lf;
+            linked[g.linkFile] = lf;
         } else if(linkMap.count(g.linkFile) == 0) {
             dbp("Missing file for group: %s", g.name.c_str());
             // The file was moved; prompt the user for its new location.
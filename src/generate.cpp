@@ -130,6 +130,7 @@ bool SolveSpaceUI::PruneConstraints(hGroup hg) {
 }
 
 void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox) {
+    Profile::Scope scope(genForBBox ? "GenerateAll (for bounding box)" : "GenerateAll");
     int first = 0, last = 0, i;
 
     uint64_t startMillis = GetMilliseconds(),
@@ -143,19 +144,21 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
         });
 
     switch(type) {
-        case Generate::DIRTY: {
+        case Generate::DIRTY:
+        case Generate::DIRTY_ALL: {
             first = INT_MAX;
             last  = 0;
 
             // Start from the first dirty group, and solve until the active group,
-            // since all groups after the active group are hidden.
+            // since all groups after the active group are hidden; or, if every
+            // group is needed (e.g. to save the file), until the last group.
             // Not using range-for because we're tracking the indices.
             for(i = 0; i < SK.groupOrder.n; i++) {
                 Group *g = SK.GetGroup(SK.groupOrder[i]);
                 if((!g->clean) || !g->IsSolvedOkay()) {
                     first = min(first, i);
                 }
-                if(g->h == SS.GW.activeGroup) {
+                if(g->h == SS.GW.activeGroup || type == Generate::DIRTY_ALL) {
                     last = i;
                 }
             }
@@ -352,9 +355,23 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
         deleted = {};
     }
 
+    // While the naked edges are shown, find them again in the mesh that we
+    // just made; only the faces that changed are checked again. Regenerating
+    // a dirty sketch already cleared them, to show the edges where boolean
+    // operations failed, so keep those.
+    if(showingNakedEdges && !genForBBox && first >= 0 &&
+       SK.group.FindByIdNoOops(GW.activeGroup)) {
+        if(type != Generate::DIRTY && type != Generate::DIRTY_ALL) {
+            nakedEdges.Clear();
+        }
+        CheckNakedEdges(NULL, NULL);
+    }
+
     FreeAllTemporary();
     allConsistent = true;
-    SS.GW.persistentDirty = true;
+    SS.GW.persistentRegenerated = true;
+    SS.GW.entityIndex.dirty = true;
+    SS.GW.constraintIndex.dirty = true;
     SS.centerOfMass.dirty = true;
 
     endMillis = GetMilliseconds();
@@ -366,6 +383,7 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
             case Generate::ALL:             typeStr = "ALL";          break;
             case Generate::REGEN:           typeStr = "REGEN";        break;
             case Generate::UNTIL_ACTIVE:    typeStr = "UNTIL_ACTIVE"; break;
+            case Generate::DIRTY_ALL:       typeStr = "DIRTY_ALL";    break;
         }
         if(endMillis)
         dbp("Generate::%s%s took %lld ms",
@@ -416,7 +434,7 @@ void SolveSpaceUI::ForceReferences() {
 }
 
 void SolveSpaceUI::UpdateCenterOfMass() {
-    SMesh *m = &(SK.GetGroup(SS.GW.activeGroup)->displayMesh);
+    SMesh *m = SK.GetGroup(SS.GW.activeGroup)->GetDisplayMesh();
     SS.centerOfMass.position = m->GetCenterOfMass();
     SS.centerOfMass.dirty = false;
 }
@@ -532,6 +550,9 @@ void SolveSpaceUI::WriteEqSystemForGroup(hGroup hg) {
 }
 
 void SolveSpaceUI::SolveGroup(hGroup hg, bool andFindFree) {
+    Profile::Scope scope("Solve");
+    // The equations and their derivatives only live as long as the solve.
+    TemporaryArena arena;
     WriteEqSystemForGroup(hg);
     Group *g = SK.GetGroup(hg);
     g->solved.remove.Clear();
@@ -546,15 +567,13 @@ void SolveSpaceUI::SolveGroup(hGroup hg, bool andFindFree) {
         g->dofCheckOk = true;
     }
     g->solved.how = how;
-    FreeAllTemporary();
 }
 
 SolveResult SolveSpaceUI::TestRankForGroup(hGroup hg, int *rank) {
+    TemporaryArena arena;
     WriteEqSystemForGroup(hg);
     Group *g = SK.GetGroup(hg);
-    SolveResult result = sys.SolveRank(g, rank);
-    FreeAllTemporary();
-    return result;
+    return sys.SolveRank(g, rank);
 }
 
 bool SolveSpaceUI::ActiveGroupsOkay() {
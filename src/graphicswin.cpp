@@ -177,6 +177,9 @@ const MenuEntry Menu[] = {
 { 1, N_("&Trace Point"),                Command::TRACE_PT,         C|S|'t', KN, mAna   },
 { 1, N_("&Stop Tracing..."),            Command::STOP_TRACING,     C|S|'s', KN, mAna   },
 { 1, N_("Step &Dimension..."),          Command::STEP_DIM,         C|S|'d', KN, mAna   },
+{ 1, NULL,                              Command::NONE,             0,       KN, NULL   },
+{ 1, N_("Show Ti&mings"),               Command::SHOW_TIMINGS,     0,       KC, mAna   },
+{ 1, N_("E&xport Timings Trace..."),    Command::EXPORT_TRACE,     0,       KN, mAna   },
 
 { 0, N_("&Help"),                       Command::NONE,             0,       KN, mHelp  },
 { 1, N_("&Language"),                   Command::LOCALE,           0,       KN, mHelp  },
@@ -323,6 +326,8 @@ void GraphicsWindow::PopulateMainMenu() {
                 showTextWndMenuItem = menuItem;
             } else if(Menu[i].cmd == Command::FULL_SCREEN) {
                 fullScreenMenuItem = menuItem;
+            } else if(Menu[i].cmd == Command::SHOW_TIMINGS) {
+                showTimingsMenuItem = menuItem;
             } else if(Menu[i].cmd == Command::UNITS_MM) {
                 unitsMmMenuItem = menuItem;
             } else if(Menu[i].cmd == Command::UNITS_METERS) {
@@ -409,10 +414,15 @@ void GraphicsWindow::Init() {
     showOutlines = false;
     drawOccludedAs = DrawOccludedAs::INVISIBLE;
 
+    entityIndex.Clear();
+    viewEntityIndex.Clear();
+    constraintIndex.Clear();
+
     showTextWindow = true;
 
     showSnapGrid = false;
     dimSolidModel = true;
+    showTimings = false;
     context.active = false;
     toolbarHovered = Command::NONE;
 
@@ -436,7 +446,7 @@ void GraphicsWindow::Init() {
     if(window) {
         canvas = CreateRenderer();
         if(canvas) {
-            persistentCanvas = canvas->CreateBatch();
+            persistentSolid.canvas = canvas->CreateBatch();
             persistentDirty = true;
         }
     }
@@ -587,20 +597,27 @@ void GraphicsWindow::LoopOverPoints(const std::vector<Entity *> &entities,
 
     Group *g = SK.GetGroup(activeGroup);
     g->GenerateDisplayItems();
-    for(int i = 0; i < g->displayMesh.l.n; i++) {
-        STriangle *tr = &(g->displayMesh.l[i]);
+    auto handleTriangle = [&](const STriangle &tr) {
         if(!includeMesh) {
             bool found = false;
             for(const hEntity &face : faces) {
-                if(face.v != tr->meta.face) continue;
+                if(face.v != tr.meta.face) continue;
                 found = true;
                 break;
             }
-            if(!found) continue;
+            if(!found) return;
+        }
+        HandlePointForZoomToFit(tr.a, pmax, pmin, wmin, usePerspective, camera);
+        HandlePointForZoomToFit(tr.b, pmax, pmin, wmin, usePerspective, camera);
+        HandlePointForZoomToFit(tr.c, pmax, pmin, wmin, usePerspective, camera);
+    };
+    for(const STriangle &tr : g->displayMesh.l) {
+        handleTriangle(tr);
+    }
+    for(const LinkedInstance &li : g->runningInstances) {
+        for(const STriangle &tr : li.file->TriangulationForLod(g->displayLod)->l) {
+            handleTriangle(li.TransformTriangle(tr));
         }
-        HandlePointForZoomToFit(tr->a, pmax, pmin, wmin, usePerspective, camera);
-        HandlePointForZoomToFit(tr->b, pmax, pmin, wmin, usePerspective, camera);
-        HandlePointForZoomToFit(tr->c, pmax, pmin, wmin, usePerspective, camera);
     }
     if(!includeMesh) return;
     for(int i = 0; i < g->polyLoops.l.n; i++) {
@@ -940,6 +957,7 @@ void GraphicsWindow::EnsureValidActives() {
     perspectiveProjMenuItem->SetActive(SS.usePerspectiveProj);
     showToolbarMenuItem->SetActive(SS.showToolbar);
     fullScreenMenuItem->SetActive(SS.GW.window->IsFullScreen());
+    showTimingsMenuItem->SetActive(SS.GW.showTimings);
 
     if(change) SS.ScheduleShowTW();
 }
@@ -1040,6 +1058,7 @@ void GraphicsWindow::MenuEdit(Command id) {
             SS.GW.ClearSuper();
             SS.TW.HideEditControl();
             SS.nakedEdges.Clear();
+            SS.showingNakedEdges = false;
             SS.justExportedInfo.draw = false;
             SS.centerOfMass.draw = false;
             // This clears the marks drawn to indicate which points are
@@ -1181,6 +1200,7 @@ void GraphicsWindow::MenuEdit(Command id) {
                     std::vector<Vector> refs;
                     c->GetReferencePoints(SS.GW.GetCamera(), &refs);
                     c->disp.offset = c->disp.offset.Plus(SS.GW.SnapToGrid(refs[0]).Minus(refs[0]));
+                    SS.GW.constraintIndex.dirty = true;
                 }
             }
             // Regenerate, with these points marked as dragged so that they
@@ -28,13 +28,43 @@ void Group::Clear() {
     runningShell.Clear();
     displayMesh.Clear();
     displayOutlines.Clear();
-    impMesh.Clear();
-    impShell.Clear();
-    impEntity.Clear();
+    decimatedMesh.Clear();
+    runningInstances.clear();
+    flatDisplayMesh.Clear();
+    impFile.reset();
     // remap is the only one that doesn't get recreated when we regen
     remap.clear();
 }
 
+// A copy that shares none of the dynamic stuff that gets regenerated, so it
+// can outlive changes to this group. The linked file in impFile is immutable,
+// so it is shared.
+Group Group::CopyWithoutGeneratedData() const {
+    // Shallow copy
+    Group dest(*this);
+    // And then zero out all the dynamic stuff that will get regenerated.
+    dest.tag = 0;
+    dest.clean = false;
+    dest.solved = {};
+    dest.polyLoops = {};
+    dest.bezierLoops = {};
+    dest.bezierOpens = {};
+    dest.polyError = {};
+    dest.thisMesh = {};
+    dest.runningMesh = {};
+    dest.thisShell = {};
+    dest.runningShell = {};
+    dest.displayGeneration = 0;
+    dest.displayMesh = {};
+    dest.displayOutlines = {};
+    dest.decimatedLod = 0;
+    dest.decimatedMesh = {};
+    dest.runningInstances = {};
+    dest.flatDisplayValid = false;
+    dest.flatDisplayMesh = {};
+    return dest;
+}
+
 void Group::AddParam(IdList<Param,hParam> *param, hParam hp, double v) {
     Param pa = {};
     pa.h = hp;
@@ -777,9 +807,10 @@ void Group::Generate(IdList<Entity,hEntity> *entity,
             AddParam(param, h.param(5), 0);
             AddParam(param, h.param(6), 0);
 
+            if(!impFile) return;
             // Not using range-for here because we're changing the size of entity in the loop.
-            for(i = 0; i < impEntity.n; i++) {
-                Entity *ie = &(impEntity[i]);
+            for(i = 0; i < impFile->entity.n; i++) {
+                Entity *ie = &(impFile->entity[i]);
                 CopyEntity(entity, ie, 0, 0,
                     h.param(0), h.param(1), h.param(2),
                     h.param(3), h.param(4), h.param(5), h.param(6), NO_PARAM,
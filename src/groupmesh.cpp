@@ -106,6 +106,76 @@ void SMesh::RemapFaces(Group *g, int remap) {
     }
 }
 
+//-----------------------------------------------------------------------------
+// The display triangulation of a linked file, at the given level of detail,
+// retriangulated only if the chord tolerance for that level has changed.
+//-----------------------------------------------------------------------------
+SMesh *LinkedFile::TriangulationForLod(int lod) {
+    ssassert(lod >= 0 && lod < SSurface::LOD_LEVELS, "Unexpected level of detail");
+    double chordTol = SShell::LodChordTol(lod);
+    SMesh *m = &lodMesh[lod];
+    if(m->IsEmpty() || lodChordTol[lod] != chordTol) {
+        m->Clear();
+        lodOutlines[lod].Clear();
+        shell.TriangulateInto(m, chordTol);
+        m->PrecomputeTransparency();
+        lodChordTol[lod] = chordTol;
+    }
+    return m;
+}
+
+SOutlineList *LinkedFile::OutlinesForLod(int lod) {
+    SMesh *m = TriangulationForLod(lod);
+    SOutlineList *ol = &lodOutlines[lod];
+    if(ol->l.IsEmpty()) {
+        m->MakeOutlinesInto(ol, EdgeKind::SHARP);
+    }
+    return ol;
+}
+
+Canvas::Placement LinkedInstance::GetPlacement() const {
+    Canvas::Placement p = {};
+    p.offset = offset;
+    p.q      = q;
+    return p;
+}
+
+STriangle LinkedInstance::TransformTriangle(const STriangle &tr) const {
+    Canvas::Placement p = GetPlacement();
+    STriangle tt = tr;
+    tt.a  = p.Transform(tr.a);
+    tt.b  = p.Transform(tr.b);
+    tt.c  = p.Transform(tr.c);
+    tt.an = p.TransformNormal(tr.an);
+    tt.bn = p.TransformNormal(tr.bn);
+    tt.cn = p.TransformNormal(tr.cn);
+
+    auto it = faceRemap.find(tr.meta.face);
+    if(it != faceRemap.end()) {
+        tt.meta.face = it->second;
+    }
+    return tt;
+}
+
+//-----------------------------------------------------------------------------
+// Like SMesh::FirstIntersectionWith, but the ray is brought into the file's
+// coordinates instead of the triangles into the model's; the transformation
+// is rigid, so the parameter along the ray stays comparable.
+//-----------------------------------------------------------------------------
+uint32_t LinkedInstance::FirstIntersectionWith(const Vector &rayPoint, const Vector &rayDir,
+                                               int lod, double *faceT) const {
+    Quaternion qi = q.Inverse();
+    Vector localPoint = qi.Rotate(rayPoint.Minus(offset)),
+           localDir   = qi.Rotate(rayDir);
+
+    uint32_t face = file->TriangulationForLod(lod)->FirstIntersectionWith(
+        localPoint, localDir, faceT);
+    if(face == 0) return 0;
+
+    auto it = faceRemap.find(face);
+    return (it != faceRemap.end()) ? it->second : face;
+}
+
 template<class T>
 void Group::GenerateForStepAndRepeat(T *steps, T *outs, Group::CombineAs forWhat) {
 
@@ -211,6 +281,7 @@ void Group::GenerateForBoolean(T *prevs, T *thiss, T *outs, Group::CombineAs how
 }
 
 void Group::GenerateShellAndMesh() {
+    Profile::Scope scope("GenerateShellAndMesh");
     bool prevBooleanFailed = booleanFailed;
     booleanFailed = false;
 
@@ -220,6 +291,7 @@ void Group::GenerateShellAndMesh() {
     thisMesh.Clear();
     runningShell.Clear();
     runningMesh.Clear();
+    runningInstances.clear();
 
     // Don't attempt a lathe or extrusion unless the source section is good:
     // planar and not self-intersecting.
@@ -391,11 +463,13 @@ void Group::GenerateShellAndMesh() {
             SK.GetParam(h.param(5))->val,
             SK.GetParam(h.param(6))->val };
 
-        thisMesh.MakeFromTransformationOf(&impMesh, offset, q, scale);
-        thisMesh.RemapFaces(this, 0);
+        if(impFile) {
+            thisMesh.MakeFromTransformationOf(&impFile->mesh, offset, q, scale);
+            thisMesh.RemapFaces(this, 0);
 
-        thisShell.MakeFromTransformationOf(&impShell, offset, q, scale);
-        thisShell.RemapFaces(this, 0);
+            thisShell.MakeFromTransformationOf(&impFile->shell, offset, q, scale);
+            thisShell.RemapFaces(this, 0);
+        }
     }
 
     dbp("Group.Merge");
@@ -427,6 +501,8 @@ void Group::GenerateShellAndMesh() {
         if(booleanFailed != prevBooleanFailed) {
             SS.ScheduleShowTW();
         }
+
+        GenerateRunningInstances(srcg, prevg);
     } else {
         SMesh prevm, thism;
         prevm = {};
@@ -441,19 +517,16 @@ void Group::GenerateShellAndMesh() {
         SMesh outm = {};
         GenerateForBoolean<SMesh>(&prevm, &thism, &outm, srcg->meshCombine);
 
-        // Remove degenerate triangles; if we don't, they'll get split in SnapToMesh
+        // Remove degenerate triangles; if we don't, they'll get split in SnapToVertices
         // in every generated group, resulting in polynomial increase in triangle count,
         // and corresponding slowdown.
         outm.RemoveDegenerateTriangles();
 
         if(srcg->meshCombine != CombineAs::ASSEMBLE) {
             // And make sure that the output mesh is vertex-to-vertex.
-            SKdNode *root = SKdNode::From(&outm);
-            root->SnapToMesh(&outm);
-            root->MakeMeshInto(&runningMesh);
-        } else {
-            runningMesh.MakeFromCopyOf(&outm);
+            outm.SnapToVertices();
         }
+        runningMesh.MakeFromCopyOf(&outm);
 
         outm.Clear();
         thism.Clear();
@@ -463,11 +536,55 @@ void Group::GenerateShellAndMesh() {
     displayDirty = true;
 }
 
+//-----------------------------------------------------------------------------
+// Work out which surfaces of the running shell are rigid copies of a linked
+// file. An assembly keeps all of the previous group's surfaces first and in
+// order, so those copies stay where they were until a real Boolean operation
+// rebuilds the shell.
+//-----------------------------------------------------------------------------
+void Group::GenerateRunningInstances(Group *srcg, Group *prevg) {
+    runningInstances.clear();
+
+    bool keepsPrevious = (thisShell.IsEmpty() || suppress ||
+                          srcg->meshCombine == CombineAs::ASSEMBLE);
+    if(prevg == NULL || !keepsPrevious) return;
+    runningInstances = prevg->runningInstances;
+
+    if(type == Type::LINKED && impFile && !suppress && !thisShell.IsEmpty() &&
+       meshCombine == CombineAs::ASSEMBLE && fabs(scale - 1.0) < LENGTH_EPS) {
+        LinkedInstance li = {};
+        li.group        = h;
+        li.file         = impFile;
+        li.offset       = Vector::From(h.param(0), h.param(1), h.param(2));
+        li.q            = Quaternion::From(h.param(3), h.param(4), h.param(5), h.param(6));
+        li.firstSurface = prevg->runningShell.surface.n;
+        li.surfaces     = thisShell.surface.n;
+        for(const SSurface &ss : impFile->shell.surface) {
+            hEntity face = { ss.face };
+            if(face == Entity::NO_ENTITY) continue;
+            li.faceRemap[face.v] = Remap(face, 0).v;
+        }
+        runningInstances.push_back(li);
+    }
+
+    bool laidOut = true;
+    for(const LinkedInstance &li : runningInstances) {
+        if(li.firstSurface + li.surfaces > runningShell.surface.n) laidOut = false;
+    }
+    if(!laidOut) {
+        // Not laid out like we expected; just draw the whole shell then.
+        runningInstances.clear();
+    }
+}
+
 void Group::GenerateDisplayItems() {
     // This is potentially slow (since we've got to triangulate a shell, or
     // to find the emphasized edges for a mesh), so we will run it only
-    // if its inputs have changed.
-    if(displayDirty) {
+    // if its inputs have changed. Exports always get the finest level of
+    // detail, which is triangulated with exactly the export chord tolerance.
+    int lod = SS.exportMode ? 0 : SS.GW.meshLod;
+    if(displayDirty || lod != displayLod) {
+        Profile::Scope scope("GenerateDisplayItems");
         Group *pg = RunningMeshGroup();
         if(pg && thisMesh.IsEmpty() && thisShell.IsEmpty()) {
             // We don't contribute any new solid model in this group, so our
@@ -487,49 +604,142 @@ void Group::GenerateDisplayItems() {
             if(SS.GW.showEdges || SS.GW.showOutlines) {
                 displayOutlines.MakeFromCopyOf(&pg->displayOutlines);
             }
+            displayGeneration = pg->displayGeneration;
         } else {
-            // We do contribute new solid model, so we have to triangulate the
-            // shell, and edge-find the mesh.
-            displayMesh.Clear();
-            runningShell.TriangulateInto(&displayMesh);
-            STriangle *t;
-            for(t = runningMesh.l.First(); t; t = runningMesh.l.NextAfter(t)) {
-                STriangle trn = *t;
-                Vector n = trn.Normal();
-                trn.an = n;
-                trn.bn = n;
-                trn.cn = n;
-                displayMesh.AddTriangle(&trn);
+            // The linked files placed in the assembly are drawn from their
+            // own shared triangulations, so leave their surfaces out.
+            std::vector<bool> instanced(runningShell.surface.n, false);
+            for(const LinkedInstance &li : runningInstances) {
+                for(int i = 0; i < li.surfaces; i++) {
+                    instanced[li.firstSurface + i] = true;
+                }
             }
+            const std::vector<bool> *skip = runningInstances.empty() ? NULL : &instanced;
+
+            if(!displayDirty) {
+                // Only the level of detail changed; the surfaces keep their
+                // triangulations for each level, and the outlines don't depend
+                // on the level, so just reassemble the mesh.
+                displayMesh.Clear();
+                runningShell.TriangulateLodInto(&displayMesh, lod, skip);
+                AddRunningMeshToDisplayMesh(lod);
+            } else {
+                // We do contribute new solid model, so we have to triangulate
+                // the shell, and edge-find the mesh.
+                displayMesh.Clear();
+                runningShell.TriangulateLodInto(&displayMesh, lod, skip);
+                decimatedMesh.Clear();
+                decimatedLod = 0;
+                AddRunningMeshToDisplayMesh(lod);
+
+                displayOutlines.Clear();
+
+                if(SS.GW.showEdges || SS.GW.showOutlines) {
+                    Profile::Scope stage("Outlines");
+                    SOutlineList rawOutlines = {};
+                    if(!runningMesh.l.IsEmpty()) {
+                        // Triangle mesh only; no shell or emphasized edges.
+                        runningMesh.MakeOutlinesInto(&rawOutlines, EdgeKind::EMPHASIZED);
+                    } else {
+                        displayMesh.MakeOutlinesInto(&rawOutlines, EdgeKind::SHARP);
+                    }
 
-            displayOutlines.Clear();
+                    // The edges of each linked file are found once, too.
+                    for(const LinkedInstance &li : runningInstances) {
+                        Canvas::Placement p = li.GetPlacement();
+                        for(const SOutline &so : li.file->OutlinesForLod(lod)->l) {
+                            rawOutlines.AddEdge(p.Transform(so.a), p.Transform(so.b),
+                                                p.TransformNormal(so.nl),
+                                                p.TransformNormal(so.nr), so.tag);
+                        }
+                    }
 
-            if(SS.GW.showEdges || SS.GW.showOutlines) {
-                SOutlineList rawOutlines = {};
-                if(!runningMesh.l.IsEmpty()) {
-                    // Triangle mesh only; no shell or emphasized edges.
-                    runningMesh.MakeOutlinesInto(&rawOutlines, EdgeKind::EMPHASIZED);
-                } else {
-                    displayMesh.MakeOutlinesInto(&rawOutlines, EdgeKind::SHARP);
+                    PolylineBuilder builder;
+                    builder.MakeFromOutlines(rawOutlines);
+                    builder.GenerateOutlines(&displayOutlines);
+                    rawOutlines.Clear();
                 }
-
-                PolylineBuilder builder;
-                builder.MakeFromOutlines(rawOutlines);
-                builder.GenerateOutlines(&displayOutlines);
-                rawOutlines.Clear();
             }
+            static uint64_t lastDisplayGeneration = 0;
+            displayGeneration = ++lastDisplayGeneration;
         }
+        flatDisplayMesh.Clear();
+        flatDisplayValid = false;
 
         // If we render this mesh, we need to know whether it's transparent,
         // and we'll want all transparent triangles last, to make the depth test
         // work correctly.
         displayMesh.PrecomputeTransparency();
+        displayDirty = false;
+        displayLod = lod;
 
         // Recalculate mass center if needed
         if(SS.centerOfMass.draw && SS.centerOfMass.dirty && h == SS.GW.activeGroup) {
             SS.UpdateCenterOfMass();
         }
-        displayDirty = false;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// The whole display mesh, including the linked files that are drawn as
+// instances; those are flattened into a copy only for the things that need
+// every triangle at once, like exports and the mesh analysis commands.
+//-----------------------------------------------------------------------------
+SMesh *Group::GetDisplayMesh() {
+    GenerateDisplayItems();
+    if(runningInstances.empty()) return &displayMesh;
+
+    if(!flatDisplayValid) {
+        flatDisplayMesh.Clear();
+        flatDisplayMesh.MakeFromCopyOf(&displayMesh);
+        for(const LinkedInstance &li : runningInstances) {
+            SMesh *m = li.file->TriangulationForLod(displayLod);
+            flatDisplayMesh.l.ReserveMore(m->l.n);
+            for(const STriangle &tr : m->l) {
+                STriangle tt = li.TransformTriangle(tr);
+                flatDisplayMesh.AddTriangle(&tt);
+            }
+        }
+        flatDisplayMesh.PrecomputeTransparency();
+        flatDisplayValid = true;
+    }
+    return &flatDisplayMesh;
+}
+
+uint32_t Group::FirstFaceIntersectionWith(Point2d mp) {
+    Vector rayPoint = SS.GW.UnProjectPoint3(Vector::From(mp.x, mp.y, 0.0));
+    Vector rayDir = SS.GW.UnProjectPoint3(Vector::From(mp.x, mp.y, 1.0)).Minus(rayPoint);
+
+    double faceT = VERY_NEGATIVE;
+    uint32_t face = displayMesh.FirstIntersectionWith(rayPoint, rayDir, &faceT);
+    for(const LinkedInstance &li : runningInstances) {
+        uint32_t f = li.FirstIntersectionWith(rayPoint, rayDir, displayLod, &faceT);
+        if(f != 0) face = f;
+    }
+    return face;
+}
+
+void Group::AddRunningMeshToDisplayMesh(int lod) {
+    // Triangle meshes (like imported STL files) can't be retriangulated more
+    // coarsely, so decimate them instead, to the same chord tolerance.
+    SMesh *m = &runningMesh;
+    if(lod > 0 && !runningMesh.IsEmpty()) {
+        if(decimatedLod != lod) {
+            decimatedMesh.Clear();
+            decimatedMesh.MakeFromDecimationOf(&runningMesh, SShell::LodChordTol(lod));
+            decimatedLod = lod;
+        }
+        m = &decimatedMesh;
+    }
+
+    STriangle *t;
+    for(t = m->l.First(); t; t = m->l.NextAfter(t)) {
+        STriangle trn = *t;
+        Vector n = trn.Normal();
+        trn.an = n;
+        trn.bn = n;
+        trn.cn = n;
+        displayMesh.AddTriangle(&trn);
     }
 }
 
@@ -602,6 +812,17 @@ void Group::DrawMesh(DrawMeshAs how, Canvas *canvas) {
             // and if we're actually going to display it, to the color buffer too.
             canvas->DrawMesh(displayMesh, hcfFront, hcfBack);
 
+            // Each linked file is triangulated once, and drawn at every place
+            // where it was assembled.
+            std::map<LinkedFile *, std::vector<Canvas::Placement>> instances;
+            for(const LinkedInstance &li : runningInstances) {
+                instances[li.file.get()].push_back(li.GetPlacement());
+            }
+            for(auto &it : instances) {
+                canvas->DrawMeshInstances(*it.first->TriangulationForLod(displayLod),
+                                          it.second, hcfFront, hcfBack);
+            }
+
             // Draw mesh edges, for debugging.
             if(SS.GW.showMesh) {
                 Canvas::Stroke strokeTriangle = {};
@@ -616,6 +837,17 @@ void Group::DrawMesh(DrawMeshAs how, Canvas *canvas) {
                     edges.AddEdge(t.b, t.c);
                     edges.AddEdge(t.c, t.a);
                 }
+                for(const LinkedInstance &li : runningInstances) {
+                    Canvas::Placement p = li.GetPlacement();
+                    for(const STriangle &t : li.file->TriangulationForLod(displayLod)->l) {
+                        Vector a = p.Transform(t.a),
+                               b = p.Transform(t.b),
+                               c = p.Transform(t.c);
+                        edges.AddEdge(a, b);
+                        edges.AddEdge(b, c);
+                        edges.AddEdge(c, a);
+                    }
+                }
                 canvas->DrawEdges(edges, hcsTriangle);
                 edges.Clear();
             }
@@ -635,6 +867,7 @@ void Group::DrawMesh(DrawMeshAs how, Canvas *canvas) {
                 faces.push_back(he.v);
             }
             canvas->DrawFaces(displayMesh, faces, hcf);
+            DrawInstanceFaces(faces, hcf, canvas);
             break;
         }
 
@@ -651,11 +884,42 @@ void Group::DrawMesh(DrawMeshAs how, Canvas *canvas) {
             if(gs.faces > 0) faces.push_back(gs.face[0].v);
             if(gs.faces > 1) faces.push_back(gs.face[1].v);
             canvas->DrawFaces(displayMesh, faces, hcf);
+            DrawInstanceFaces(faces, hcf, canvas);
             break;
         }
     }
 }
 
+//-----------------------------------------------------------------------------
+// The faces of the instanced linked files aren't in the displayMesh, so pick
+// out the triangles of those that are highlighted, and draw them separately.
+//-----------------------------------------------------------------------------
+void Group::DrawInstanceFaces(const std::vector<uint32_t> &faces, Canvas::hFill hcf,
+                              Canvas *canvas) {
+    if(faces.empty() || runningInstances.empty()) return;
+
+    SMesh facesMesh = {};
+    std::vector<uint32_t> fileFaces;
+    for(const LinkedInstance &li : runningInstances) {
+        // The faces are numbered differently in the linked file, so find
+        // its own numbers for them, and then just the triangles of those.
+        fileFaces.clear();
+        for(const auto &it : li.faceRemap) {
+            if(std::find(faces.begin(), faces.end(), it.second) == faces.end()) continue;
+            fileFaces.push_back(it.first);
+        }
+        li.file->TriangulationForLod(displayLod)->ForEachTriangleOf(fileFaces,
+            [&](const STriangle &tr) {
+                STriangle tt = li.TransformTriangle(tr);
+                facesMesh.AddTriangle(&tt);
+            });
+    }
+    if(!facesMesh.IsEmpty()) {
+        canvas->DrawFaces(facesMesh, faces, hcf);
+    }
+    facesMesh.Clear();
+}
+
 void Group::Draw(Canvas *canvas) {
     // Everything here gets drawn whether or not the group is hidden; we
     // can control this stuff independently, with show/hide solids, edges,
@@ -74,9 +74,9 @@ void Slvs_Solve(Slvs_System *ssys, Slvs_hGroup shg)
 
         p.h.v = sp->h;
         p.val = sp->val;
-        SK.param.Add(&p);
+        SK.param.AddUnsorted(&p);
         if(sp->group == shg) {
-            SYS.param.Add(&p);
+            SYS.param.AddUnsorted(&p);
         }
     }
 
@@ -112,7 +112,7 @@ default: dbp("bad entity type %d", se->type); return;
         e.param[2].v    = se->param[2];
         e.param[3].v    = se->param[3];
 
-        SK.entity.Add(&e);
+        SK.entity.AddUnsorted(&e);
     }
     IdList<Param, hParam> params = {};
     for(i = 0; i < ssys->constraints; i++) {
@@ -185,7 +185,7 @@ default: dbp("bad constraint type %d", sc->type); return;
             c.ModifyToSatisfy();
         }
 
-        SK.constraint.Add(&c);
+        SK.constraint.AddUnsorted(&c);
     }
 
     for(i = 0; i < (int)arraylen(ssys->dragged); i++) {
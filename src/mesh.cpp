@@ -6,10 +6,12 @@
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
 #include "dbg.h"
+#include <queue>
 #include <set>
 
 void SMesh::Clear() {
     l.Clear();
+    faceRanges.clear();
 }
 
 void SMesh::AddTriangle(STriMeta meta, Vector n, Vector a, Vector b, Vector c) {
@@ -35,6 +37,7 @@ void SMesh::AddTriangle(STriMeta meta, Vector a, Vector b, Vector c) {
 }
 void SMesh::AddTriangle(const STriangle *st) {
     l.Add(st);
+    faceRanges.clear();
     if (!dump.tr) return;
     dump.trn++;
     std::string s = ssprintf("  tr %d", dump.trn);
@@ -86,8 +89,8 @@ void SMesh::MakeEdgesInPlaneInto(SEdgeList *sel, Vector n, double d) {
     m.l.RemoveTagged();
 
     // Select the naked edges in our resulting open mesh.
+    m.SnapToVertices();
     SKdNode *root = SKdNode::From(&m);
-    root->SnapToMesh(&m);
     root->MakeCertainEdgesInto(sel, EdgeKind::NAKED_OR_SELF_INTER,
                                /*coplanarIsInter=*/false, NULL, NULL);
 
@@ -270,6 +273,7 @@ void SMesh::AddAgainstBsp(SMesh *srcm, SBsp3 *bsp3) {
 }
 
 void SMesh::MakeFromUnionOf(SMesh *a, SMesh *b) {
+    TemporaryArena arena;
     SBsp3 *bspa = SBsp3::FromMesh(a);
     SBsp3 *bspb = SBsp3::FromMesh(b);
 
@@ -284,6 +288,7 @@ void SMesh::MakeFromUnionOf(SMesh *a, SMesh *b) {
 }
 
 void SMesh::MakeFromDifferenceOf(SMesh *a, SMesh *b) {
+    TemporaryArena arena;
     SBsp3 *bspa = SBsp3::FromMesh(a);
     SBsp3 *bspb = SBsp3::FromMesh(b);
 
@@ -299,6 +304,7 @@ void SMesh::MakeFromDifferenceOf(SMesh *a, SMesh *b) {
 }
 
 void SMesh::MakeFromIntersectionOf(SMesh *a, SMesh *b) {
+    TemporaryArena arena;
     SBsp3 *bspa = SBsp3::FromMesh(a);
     SBsp3 *bspb = SBsp3::FromMesh(b);
 
@@ -350,20 +356,44 @@ uint32_t SMesh::FirstIntersectionWith(Point2d mp) const {
     Vector rayPoint = SS.GW.UnProjectPoint3(Vector::From(mp.x, mp.y, 0.0));
     Vector rayDir = SS.GW.UnProjectPoint3(Vector::From(mp.x, mp.y, 1.0)).Minus(rayPoint);
 
-    uint32_t face = 0;
     double faceT = VERY_NEGATIVE;
-    for(int i = 0; i < l.n; i++) {
-        const STriangle &tr = l[i];
-        if(tr.meta.face == 0) continue;
+    return FirstIntersectionWith(rayPoint, rayDir, &faceT);
+}
 
-        double t;
-        if(!tr.Raytrace(rayPoint, rayDir, &t, NULL)) continue;
-        if(t > faceT) {
-            face  = tr.meta.face;
-            faceT = t;
+//-----------------------------------------------------------------------------
+// Find the face hit first along the ray, if it's hit before faceT; in that
+// case faceT is updated, so that several meshes can be tested in turn.
+//-----------------------------------------------------------------------------
+uint32_t SMesh::FirstIntersectionWith(const Vector &rayPoint, const Vector &rayDir,
+                                      double *faceT) const {
+    uint32_t face = 0;
+    auto testRange = [&](int start, int n) {
+        for(int i = start; i < start + n; i++) {
+            const STriangle &tr = l[i];
+            if(tr.meta.face == 0) continue;
+
+            double t;
+            if(!tr.Raytrace(rayPoint, rayDir, &t, NULL)) continue;
+            if(t > *faceT) {
+                face   = tr.meta.face;
+                *faceT = t;
+            }
         }
-    }
+    };
 
+    if(faceRanges.empty()) {
+        testRange(0, l.n);
+        return face;
+    }
+    // With the triangles grouped by face, we need only test the faces whose
+    // bounding box the ray goes through.
+    for(const FaceRange &fr : faceRanges) {
+        if(fr.face == 0) continue;
+        if(!Vector::BoundingBoxIntersectsLine(fr.bbmax, fr.bbmin,
+                                              rayPoint, rayPoint.Plus(rayDir),
+                                              /*asSegment=*/false)) continue;
+        testRange(fr.start, fr.n);
+    }
     return face;
 }
 
@@ -656,7 +686,8 @@ void SKdNode::SnapToVertex(Vector v, SMesh *extras) {
 //-----------------------------------------------------------------------------
 // Snap to each vertex of each triangle of the given mesh. If the given mesh
 // is identical to the mesh used to make this kd tree, then the result should
-// be a vertex-to-vertex mesh.
+// be a vertex-to-vertex mesh. SMesh::SnapToVertices is faster, and is what we
+// use; this is kept as the reference for it.
 //-----------------------------------------------------------------------------
 void SKdNode::SnapToMesh(SMesh *m) {
     int i, j, k;
@@ -681,6 +712,217 @@ void SKdNode::SnapToMesh(SMesh *m) {
     }
 }
 
+//-----------------------------------------------------------------------------
+// Make this mesh vertex-to-vertex, like SKdNode::SnapToMesh does for the mesh
+// that the tree was made from, but without searching the tree once for every
+// vertex of every triangle. The distinct vertices go into a uniform grid, with
+// cells about as big as the edges; we then walk along each edge of each
+// triangle, collect every vertex on it, and split the triangle at all of
+// them at once. That's linear in the size of the mesh, unless some edges are
+// much longer than the average.
+//-----------------------------------------------------------------------------
+namespace {
+
+class VertexGrid {
+public:
+    double                                          cell;
+    std::vector<Vector>                             verts;
+    std::unordered_map<uint64_t, std::vector<int>>  cells;
+    std::vector<int>                                visited;
+    int                                             visit;
+
+    static uint64_t KeyFor(int64_t x, int64_t y, int64_t z) {
+        // Keys that alias only cost us a few more candidates to test.
+        return ((uint64_t)(x & 0x1fffff) << 42) |
+               ((uint64_t)(y & 0x1fffff) << 21) |
+                (uint64_t)(z & 0x1fffff);
+    }
+
+    void CellOf(Vector p, int64_t *x, int64_t *y, int64_t *z) const {
+        *x = (int64_t)floor(p.x / cell);
+        *y = (int64_t)floor(p.y / cell);
+        *z = (int64_t)floor(p.z / cell);
+    }
+
+    // Call fn for the index of each vertex in the cells that overlap the box
+    // from lo to hi.
+    template<class F>
+    void ForEachInBox(Vector lo, Vector hi, F fn) const {
+        int64_t x0, y0, z0, x1, y1, z1;
+        CellOf(lo, &x0, &y0, &z0);
+        CellOf(hi, &x1, &y1, &z1);
+        for(int64_t i = x0; i <= x1; i++) {
+            for(int64_t j = y0; j <= y1; j++) {
+                for(int64_t k = z0; k <= z1; k++) {
+                    auto it = cells.find(KeyFor(i, j, k));
+                    if(it == cells.end()) continue;
+                    for(int vi : it->second) fn(vi);
+                }
+            }
+        }
+    }
+
+    template<class F>
+    void ForEachNear(Vector p, double r, F fn) const {
+        Vector d = Vector::From(r, r, r);
+        ForEachInBox(p.Minus(d), p.Plus(d), fn);
+    }
+
+    int Find(Vector p) const {
+        int found = -1;
+        ForEachNear(p, LENGTH_EPS, [&](int vi) {
+            if(found < 0 && verts[vi].Equals(p)) found = vi;
+        });
+        return found;
+    }
+
+    void Add(Vector p) {
+        if(Find(p) >= 0) return;
+        int64_t x, y, z;
+        CellOf(p, &x, &y, &z);
+        cells[KeyFor(x, y, z)].push_back((int)verts.size());
+        verts.push_back(p);
+    }
+
+    struct EdgePoint {
+        int     edge;
+        double  t;
+        Vector  p;
+    };
+
+    // Find the vertices that lie on the edge from a to b, other than at a
+    // or b themselves.
+    void FindOnEdge(Vector a, Vector b, int edge, std::vector<EdgePoint> *pts) {
+        if(visited.size() < verts.size()) visited.resize(verts.size(), 0);
+        visit++;
+
+        auto test = [&](int vi) {
+            if(visited[vi] == visit) return;
+            visited[vi] = visit;
+
+            Vector v = verts[vi];
+            if(v.Equals(a) || v.Equals(b)) return;
+            if(!v.OnLineSegment(a, b)) return;
+            pts->push_back({ edge, v.Minus(a).DivProjected(b.Minus(a)), v });
+        };
+
+        // Short edges, and edges along an axis, we can just search within
+        // their bounding box; for anything else, search around points
+        // spaced along the edge, so that the work grows only linearly with
+        // the length of the edge.
+        Vector eps = Vector::From(LENGTH_EPS, LENGTH_EPS, LENGTH_EPS);
+        Vector hi = a, lo = a;
+        b.MakeMaxMin(&hi, &lo);
+        hi = hi.Plus(eps);
+        lo = lo.Minus(eps);
+        Vector d = b.Minus(a);
+        int steps = (int)ceil(d.Magnitude() / cell);
+        Vector ext = hi.Minus(lo).ScaledBy(1 / cell);
+        if((ext.x + 1) * (ext.y + 1) * (ext.z + 1) <= 8 * (steps + 1)) {
+            ForEachInBox(lo, hi, test);
+        } else {
+            for(int i = 0; i <= steps; i++) {
+                ForEachNear(a.Plus(d.ScaledBy((double)i / steps)),
+                            cell / 2 + LENGTH_EPS, test);
+            }
+        }
+    }
+};
+
+// Split tr at the given points on its edges, by splitting it in two at one
+// of the points, and then each half at the points on its own edges.
+void SplitAtEdgePoints(STriangle tr, std::vector<VertexGrid::EdgePoint> pts,
+                       SMesh *dest) {
+    if(pts.empty()) {
+        dest->AddTriangle(&tr);
+        return;
+    }
+
+    int e = pts[0].edge;
+    std::vector<VertexGrid::EdgePoint> onEdge;
+    for(const auto &ep : pts) {
+        if(ep.edge == e) onEdge.push_back(ep);
+    }
+    std::sort(onEdge.begin(), onEdge.end(),
+              [](const VertexGrid::EdgePoint &a, const VertexGrid::EdgePoint &b) {
+                  return a.t < b.t;
+              });
+    VertexGrid::EdgePoint split = onEdge[onEdge.size() / 2];
+
+    int i = e, j = (e + 1) % 3;
+    Vector vi = tr.vertices[i], vj = tr.vertices[j];
+    double s = split.p.Minus(vi).DivProjected(vj.Minus(vi));
+    Vector n = tr.normals[i].ScaledBy(1 - s).Plus(tr.normals[j].ScaledBy(s));
+
+    // The half that keeps vertex i, and the half that keeps vertex j; the
+    // new edge from the split point to the third vertex is interior, so
+    // nothing lies on it.
+    STriangle tri = tr, trj = tr;
+    tri.vertices[j] = split.p;
+    tri.normals[j]  = n;
+    trj.vertices[i] = split.p;
+    trj.normals[i]  = n;
+
+    std::vector<VertexGrid::EdgePoint> ptsi, ptsj;
+    for(const auto &ep : pts) {
+        if(ep.edge == e) {
+            if(ep.t < split.t) ptsi.push_back(ep);
+            if(ep.t > split.t) ptsj.push_back(ep);
+        } else if(ep.edge == j) {
+            ptsj.push_back(ep);
+        } else {
+            ptsi.push_back(ep);
+        }
+    }
+    SplitAtEdgePoints(tri, ptsi, dest);
+    SplitAtEdgePoints(trj, ptsj, dest);
+}
+
+}
+
+void SMesh::SnapToVertices() {
+    if(l.IsEmpty()) return;
+
+    double edgeLength = 0;
+    for(const STriangle &tr : l) {
+        edgeLength += tr.a.Minus(tr.b).Magnitude() +
+                      tr.b.Minus(tr.c).Magnitude() +
+                      tr.c.Minus(tr.a).Magnitude();
+    }
+    VertexGrid grid = {};
+    grid.cell = max(edgeLength / (3 * l.n), 2 * KDTREE_EPS);
+
+    for(const STriangle &tr : l) {
+        if(tr.IsDegenerate()) continue;
+        for(int i = 0; i < 3; i++) {
+            grid.Add(tr.vertices[i]);
+        }
+    }
+
+    SMesh snapped = {};
+    std::vector<VertexGrid::EdgePoint> pts;
+    for(STriangle tr : l) {
+        // Vertices that are within LENGTH_EPS become exactly equal.
+        for(int i = 0; i < 3; i++) {
+            int vi = grid.Find(tr.vertices[i]);
+            if(vi >= 0) tr.vertices[i] = grid.verts[vi];
+        }
+        if(tr.IsDegenerate()) {
+            snapped.AddTriangle(&tr);
+            continue;
+        }
+
+        pts.clear();
+        for(int i = 0; i < 3; i++) {
+            grid.FindOnEdge(tr.vertices[i], tr.vertices[(i + 1) % 3], i, &pts);
+        }
+        SplitAtEdgePoints(tr, pts, &snapped);
+    }
+
+    std::swap(l, snapped.l);
+    snapped.Clear();
+}
+
 //-----------------------------------------------------------------------------
 // For all the edges in sel, split them against the given triangle, and test
 // them for occlusion. sel is both our input and our output. tag indicates
@@ -907,6 +1149,7 @@ void SKdNode::FindEdgeOn(Vector a, Vector b, int cnt, bool coplanarIsInter,
                 if(tr->ContainsPointProjd(b.Minus(a), a)) {
                     if(coplanarIsInter) {
                         info->intersectsMesh = true;
+                        if(info->crossed) info->crossed->push_back(tr);
                     } else {
                         Vector p = Vector::AtIntersectionOfPlaneAndLine(
                                                 n, d, a, b, NULL);
@@ -926,6 +1169,7 @@ void SKdNode::FindEdgeOn(Vector a, Vector b, int cnt, bool coplanarIsInter,
                             // will intersect on their edges.
                         } else {
                             info->intersectsMesh = true;
+                            if(info->crossed) info->crossed->push_back(tr);
                         }
                     }
                 }
@@ -1107,6 +1351,258 @@ void SKdNode::MakeOutlinesInto(SOutlineList *sol, EdgeKind edgeKind) const
     }
 }
 
+//-----------------------------------------------------------------------------
+// Check a mesh for naked and self-intersecting edges, by the same rules as
+// SKdNode::MakeCertainEdgesInto, but remembering what we found. The mesh is
+// split up by face; a face whose triangles are the same as last time isn't
+// checked again, and its edges are only tested against the triangles of the
+// faces that did change.
+//-----------------------------------------------------------------------------
+int SMeshCheck::VertexFor(Vector p) {
+    // The cells are a few times bigger than the tolerance, so that we need
+    // to look in at most eight of them.
+    const double cell = 4 * LENGTH_EPS;
+    int64_t x0 = (int64_t)floor((p.x - LENGTH_EPS) / cell),
+            y0 = (int64_t)floor((p.y - LENGTH_EPS) / cell),
+            z0 = (int64_t)floor((p.z - LENGTH_EPS) / cell),
+            x1 = (int64_t)floor((p.x + LENGTH_EPS) / cell),
+            y1 = (int64_t)floor((p.y + LENGTH_EPS) / cell),
+            z1 = (int64_t)floor((p.z + LENGTH_EPS) / cell);
+    for(int64_t i = x0; i <= x1; i++) {
+        for(int64_t j = y0; j <= y1; j++) {
+            for(int64_t k = z0; k <= z1; k++) {
+                auto it = cells.find(VertexGrid::KeyFor(i, j, k));
+                if(it == cells.end()) continue;
+                for(int vi : it->second) {
+                    if(verts[vi].Equals(p)) return vi;
+                }
+            }
+        }
+    }
+
+    int vi = (int)verts.size();
+    verts.push_back(p);
+    cells[VertexGrid::KeyFor((int64_t)floor(p.x / cell),
+                             (int64_t)floor(p.y / cell),
+                             (int64_t)floor(p.z / cell))].push_back(vi);
+    return vi;
+}
+
+void SMeshCheck::CountEdges(const Face &f, int delta, std::vector<uint64_t> *touched) {
+    for(size_t i = 0; i < f.verts.size(); i += 3) {
+        for(int j = 0; j < 3; j++) {
+            int a = f.verts[i + j],
+                b = f.verts[i + (j + 1) % 3];
+            uint64_t key = ((uint64_t)min(a, b) << 32) | (uint32_t)max(a, b);
+            EdgeCount &ec = edges[key];
+            // An edge from a vertex to itself goes both ways.
+            if(a <= b) ec.n[0] += delta;
+            if(a >= b) ec.n[1] += delta;
+            touched->push_back(key);
+        }
+    }
+}
+
+// The p triangles with an edge one way around should each have exactly one
+// mate with it the other way around; or if not, then there must be as many
+// triangles each way, as where coincident faces meet.
+static bool IsNakedWay(int p, int q) {
+    return p > 0 && q != 1 && q != p;
+}
+
+static uint64_t DigestOf(const std::vector<STriangle> &tris) {
+    uint64_t h = 14695981039346656037ull;
+    for(const STriangle &tr : tris) {
+        for(const Vector &v : tr.vertices) {
+            for(double c : { v.x, v.y, v.z }) {
+                uint64_t bits;
+                memcpy(&bits, &c, sizeof(bits));
+                h = (h ^ bits) * 1099511628211ull;
+                h ^= h >> 32;
+            }
+        }
+    }
+    return h;
+}
+
+void SMeshCheck::Check(SMesh *m, bool coplanarIsInter, SEdgeList *sel,
+                       bool *inter, bool *leaky, int auxA) {
+    if(inter) *inter = false;
+    if(leaky) *leaky = false;
+
+    // What we found by the other rule for coplanar triangles is no use; and
+    // vertices are never removed from the table, so start over once most of
+    // them are gone.
+    if(coplanarIsInter != this->coplanarIsInter ||
+       verts.size() > 6 * (size_t)m->l.n + 1024) {
+        Clear();
+        this->coplanarIsInter = coplanarIsInter;
+    }
+
+    if(verts.empty()) {
+        cells.reserve(m->l.n);
+        edges.reserve(3 * m->l.n / 2);
+    }
+
+    // Split the mesh up by face, and see which faces changed or went away.
+    std::unordered_map<uint32_t, Face> current;
+    for(const STriangle &tr : m->l) {
+        current[tr.meta.face].tris.push_back(tr);
+    }
+    std::unordered_set<uint32_t> dirty;
+    for(auto &it : current) {
+        Face &f = it.second;
+        f.digest = DigestOf(f.tris);
+        auto prev = faces.find(it.first);
+        if(prev != faces.end() && prev->second.digest == f.digest &&
+           prev->second.tris.size() == f.tris.size()) continue;
+        dirty.insert(it.first);
+    }
+    for(auto &it : faces) {
+        if(current.find(it.first) == current.end()) dirty.insert(it.first);
+    }
+
+    // Count the triangles on each edge again for the faces that changed, and
+    // then see whether those edges are naked now.
+    std::vector<uint64_t> touched;
+    for(uint32_t face : dirty) {
+        auto prev = faces.find(face);
+        if(prev != faces.end()) {
+            CountEdges(prev->second, -1, &touched);
+            faces.erase(prev);
+        }
+
+        auto cur = current.find(face);
+        if(cur == current.end()) continue;
+        Face &f = faces[face];
+        f = std::move(cur->second);
+        f.verts.reserve(3 * f.tris.size());
+        for(const STriangle &tr : f.tris) {
+            for(int i = 0; i < 3; i++) {
+                f.verts.push_back(VertexFor(tr.vertices[i]));
+            }
+        }
+        CountEdges(f, 1, &touched);
+    }
+    for(uint64_t key : touched) {
+        auto it = edges.find(key);
+        if(it == edges.end()) continue;
+        const EdgeCount &ec = it->second;
+        if(ec.n[0] == 0 && ec.n[1] == 0) {
+            edges.erase(it);
+            naked.erase(key);
+        } else if(IsNakedWay(ec.n[0], ec.n[1]) || IsNakedWay(ec.n[1], ec.n[0])) {
+            naked.insert(key);
+        } else {
+            naked.erase(key);
+        }
+    }
+
+    // An edge of a face that didn't change can only start or stop crossing
+    // the mesh where the faces that changed are, so forget what it crossed
+    // there, and test it against their triangles again. The edges of the
+    // faces that changed are tested against every triangle near them.
+    if(!dirty.empty()) {
+        SMesh changed = {};
+        Vector hi = Vector::From(VERY_NEGATIVE, VERY_NEGATIVE, VERY_NEGATIVE),
+               lo = Vector::From(VERY_POSITIVE, VERY_POSITIVE, VERY_POSITIVE);
+        for(auto &it : faces) {
+            Face &f = it.second;
+            if(dirty.find(it.first) == dirty.end()) {
+                f.crossings.erase(std::remove_if(f.crossings.begin(), f.crossings.end(),
+                    [&](const std::pair<int, uint32_t> &c) {
+                        return dirty.find(c.second) != dirty.end();
+                    }), f.crossings.end());
+                continue;
+            }
+            for(STriangle &tr : f.tris) {
+                changed.AddTriangle(&tr);
+                for(const Vector &v : tr.vertices) v.MakeMaxMin(&hi, &lo);
+            }
+        }
+
+        if(!changed.IsEmpty()) {
+            auto isNear = [&](const STriangle &tr) {
+                Vector tmax = tr.a, tmin = tr.a;
+                tr.b.MakeMaxMin(&tmax, &tmin);
+                tr.c.MakeMaxMin(&tmax, &tmin);
+                return !Vector::BoundingBoxesDisjoint(hi, lo, tmax, tmin);
+            };
+
+            SKdNode *changedRoot = SKdNode::From(&changed),
+                    *nearRoot    = changedRoot;
+            SMesh near = {};
+            if(changed.l.n < m->l.n) {
+                for(auto &it : faces) {
+                    for(STriangle &tr : it.second.tris) {
+                        if(isNear(tr)) near.AddTriangle(&tr);
+                    }
+                }
+                nearRoot = SKdNode::From(&near);
+            }
+            changedRoot->ClearTags();
+            nearRoot->ClearTags();
+
+            std::vector<STriangle *> crossed;
+            int cnt = 1234;
+            for(auto &it : faces) {
+                Face &f = it.second;
+                bool isDirty = dirty.find(it.first) != dirty.end();
+                SKdNode *root = isDirty ? nearRoot : changedRoot;
+                for(int i = 0; i < (int)f.tris.size(); i++) {
+                    const STriangle &tr = f.tris[i];
+                    if(!isDirty && !isNear(tr)) continue;
+                    for(int j = 0; j < 3; j++) {
+                        crossed.clear();
+                        SKdNode::EdgeOnInfo info = {};
+                        info.crossed = &crossed;
+                        root->FindEdgeOn(tr.vertices[j], tr.vertices[(j + 1) % 3], cnt++,
+                                         coplanarIsInter, &info);
+                        for(STriangle *ct : crossed) {
+                            f.crossings.emplace_back(3 * i + j, ct->meta.face);
+                        }
+                    }
+                }
+            }
+            near.Clear();
+        }
+        changed.Clear();
+    }
+
+    for(uint64_t key : naked) {
+        const EdgeCount &ec = edges[key];
+        Vector a = verts[(int)(key >> 32)],
+               b = verts[(int)(key & 0xffffffff)];
+        if(IsNakedWay(ec.n[0], ec.n[1])) {
+            for(int i = 0; i < ec.n[0]; i++) sel->AddEdge(a, b, auxA);
+        }
+        if(IsNakedWay(ec.n[1], ec.n[0])) {
+            for(int i = 0; i < ec.n[1]; i++) sel->AddEdge(b, a, auxA);
+        }
+        if(leaky) *leaky = true;
+    }
+    for(auto &it : faces) {
+        Face &f = it.second;
+        std::sort(f.crossings.begin(), f.crossings.end());
+        for(size_t i = 0; i < f.crossings.size(); i++) {
+            int e = f.crossings[i].first;
+            if(i > 0 && f.crossings[i - 1].first == e) continue;
+            const STriangle &tr = f.tris[e / 3];
+            sel->AddEdge(tr.vertices[e % 3], tr.vertices[(e + 1) % 3], auxA);
+            if(inter) *inter = true;
+        }
+    }
+}
+
+void SMeshCheck::Clear() {
+    coplanarIsInter = false;
+    faces.clear();
+    verts.clear();
+    cells.clear();
+    edges.clear();
+    naked.clear();
+}
+
 bool SOutline::IsVisible(Vector projDir) const {
     double ldot = nl.Dot(projDir);
     double rdot = nr.Dot(projDir);
@@ -1141,16 +1637,86 @@ void SOutlineList::MakeFromCopyOf(SOutlineList *sol) {
     }
 }
 
+//-----------------------------------------------------------------------------
+// Put the transparent triangles last, so that they're drawn over the opaque
+// ones; and the triangles of each face together, noting where each face is,
+// so that one face can be drawn or picked without looking at all the others.
+// A triangulated shell already has each face together, so usually nothing
+// has to move.
+//-----------------------------------------------------------------------------
 void SMesh::PrecomputeTransparency() {
-    std::sort(l.begin(), l.end(),
-              [&](const STriangle &sta, const STriangle &stb) {
-        RgbaColor colora = sta.meta.color,
-                  colorb = stb.meta.color;
-        bool opaquea = colora.IsEmpty() || colora.alpha == 255,
-             opaqueb = colorb.IsEmpty() || colorb.alpha == 255;
-
-        if(!opaquea || !opaqueb) isTransparent = true;
-        return (opaquea != opaqueb && opaquea == true);
+    auto isOpaque = [](const STriangle &st) {
+        RgbaColor color = st.meta.color;
+        return color.IsEmpty() || color.alpha == 255;
+    };
+
+    // Find the runs of triangles, one for each face and opacity, in the order
+    // that they first appear.
+    std::unordered_map<uint64_t, int> runOf;
+    std::vector<int> runs(l.n);
+    std::vector<bool> runOpaque;
+    faceRanges.clear();
+    uint64_t lastKey = UINT64_MAX;
+    int lastRun = -1;
+    for(int i = 0; i < l.n; i++) {
+        const STriangle &tr = l[i];
+        bool opaque = isOpaque(tr);
+        uint64_t key = ((uint64_t)!opaque << 32) | tr.meta.face;
+        if(key != lastKey) {
+            auto it = runOf.find(key);
+            if(it == runOf.end()) {
+                it = runOf.emplace(key, (int)faceRanges.size()).first;
+                faceRanges.push_back({ tr.meta.face, 0, 0, tr.a, tr.a });
+                runOpaque.push_back(opaque);
+            }
+            lastKey = key;
+            lastRun = it->second;
+        }
+        runs[i] = lastRun;
+        faceRanges[lastRun].n++;
+    }
+
+    // Lay out the opaque runs, and then the transparent ones.
+    isTransparent = false;
+    int start = 0;
+    for(bool opaque : { true, false }) {
+        for(size_t r = 0; r < faceRanges.size(); r++) {
+            if(runOpaque[r] != opaque) continue;
+            if(!opaque) isTransparent = true;
+            faceRanges[r].start = start;
+            start += faceRanges[r].n;
+        }
+    }
+
+    // Move the triangles there, if they aren't already.
+    std::vector<int> dest(l.n);
+    std::vector<int> next(faceRanges.size());
+    bool inPlace = true;
+    for(size_t r = 0; r < faceRanges.size(); r++) {
+        next[r] = faceRanges[r].start;
+    }
+    for(int i = 0; i < l.n; i++) {
+        dest[i] = next[runs[i]]++;
+        if(dest[i] != i) inPlace = false;
+    }
+    if(!inPlace) {
+        std::vector<STriangle> moved(l.n);
+        for(int i = 0; i < l.n; i++) {
+            moved[dest[i]] = l[i];
+        }
+        std::copy(moved.begin(), moved.end(), l.begin());
+    }
+
+    for(FaceRange &fr : faceRanges) {
+        for(int i = fr.start; i < fr.start + fr.n; i++) {
+            for(const Vector &v : l[i].vertices) {
+                v.MakeMaxMin(&fr.bbmax, &fr.bbmin);
+            }
+        }
+    }
+    std::sort(faceRanges.begin(), faceRanges.end(),
+              [](const FaceRange &a, const FaceRange &b) {
+        return a.face < b.face || (a.face == b.face && a.start < b.start);
     });
 }
 
@@ -1224,3 +1790,299 @@ double SMesh::CalculateSurfaceArea(const std::vector<uint32_t> &faces) const {
     }
     return area;
 }
+
+//-----------------------------------------------------------------------------
+// Decimate a mesh by quadric error metric edge collapses, after Garland and
+// Heckbert. Each vertex accumulates the (unweighted) quadrics of the planes
+// of its original triangles, so the cost of a collapse bounds from above the
+// squared distance from the new position to every one of those planes; we
+// stop when that would exceed tol.
+//
+// Only half-edge collapses are made, so every vertex that survives keeps its
+// original position and normal. A vertex is never removed if it lies on an
+// edge that isn't shared by exactly two triangles, or if its triangles don't
+// all have the same face and color; so naked edges and face boundaries are
+// preserved exactly, and the decimated mesh still meets its neighbours.
+//-----------------------------------------------------------------------------
+namespace {
+
+struct Quadric {
+    double xx, xy, xz, xw, yy, yz, yw, zz, zw, ww;
+
+    static Quadric FromPlane(Vector n, double d) {
+        return { n.x*n.x, n.x*n.y, n.x*n.z, n.x*d,
+                 n.y*n.y, n.y*n.z, n.y*d,
+                 n.z*n.z, n.z*d,
+                 d*d };
+    }
+
+    void Add(const Quadric &q) {
+        xx += q.xx; xy += q.xy; xz += q.xz; xw += q.xw;
+        yy += q.yy; yz += q.yz; yw += q.yw;
+        zz += q.zz; zw += q.zw;
+        ww += q.ww;
+    }
+
+    double Evaluate(Vector p) const {
+        return     p.x*p.x*xx + 2*p.x*p.y*xy + 2*p.x*p.z*xz + 2*p.x*xw
+                 + p.y*p.y*yy + 2*p.y*p.z*yz + 2*p.y*yw
+                 + p.z*p.z*zz + 2*p.z*zw
+                 + ww;
+    }
+};
+
+class MeshDecimator {
+public:
+    struct Tri {
+        int         v[3];
+        Vector      n[3];
+        STriMeta    meta;
+        bool        removed;
+    };
+
+    struct Vert {
+        Vector              p;
+        Quadric             q;
+        std::vector<int>    tris;
+        bool                locked;
+        bool                removed;
+        int                 version;
+    };
+
+    struct Collapse {
+        double  cost;
+        int     from, to;
+        int     fromVersion, toVersion;
+
+        bool operator<(const Collapse &c) const { return cost > c.cost; }
+    };
+
+    std::vector<Vert>   verts;
+    std::vector<Tri>    tris;
+    std::priority_queue<Collapse> queue;
+    double              maxCost;
+
+    static uint64_t EdgeKey(int a, int b) {
+        if(a > b) std::swap(a, b);
+        return ((uint64_t)a << 32) | (uint32_t)b;
+    }
+
+    void Build(const SMesh *src) {
+        std::unordered_map<Vector, int, VectorHash, VectorPred> index;
+        auto vertexFor = [&](Vector p) {
+            auto it = index.find(p);
+            if(it != index.end()) return it->second;
+            int vi = (int)verts.size();
+            verts.push_back({ p, {}, {}, false, false, 0 });
+            index.emplace(p, vi);
+            return vi;
+        };
+
+        for(const STriangle &st : src->l) {
+            Tri t = {};
+            t.meta = st.meta;
+            for(int i = 0; i < 3; i++) {
+                t.v[i] = vertexFor(st.vertices[i]);
+                t.n[i] = st.normals[i];
+            }
+            if(t.v[0] == t.v[1] || t.v[1] == t.v[2] || t.v[2] == t.v[0]) continue;
+            tris.push_back(t);
+        }
+
+        // Count the triangles on each edge, and note whether they all agree
+        // about face and color.
+        struct EdgeInfo {
+            int         count;
+            STriMeta    meta;
+            bool        mixed;
+        };
+        std::unordered_map<uint64_t, EdgeInfo> edges;
+        for(int ti = 0; ti < (int)tris.size(); ti++) {
+            Tri &t = tris[ti];
+            Vector n = verts[t.v[1]].p.Minus(verts[t.v[0]].p).Cross(
+                       verts[t.v[2]].p.Minus(verts[t.v[0]].p));
+            // A sliver contributes no plane, rather than an arbitrary one.
+            n = (n.Magnitude() > LENGTH_EPS*LENGTH_EPS) ? n.WithMagnitude(1) :
+                                                         Vector::From(0, 0, 0);
+            Quadric q = Quadric::FromPlane(n, -n.Dot(verts[t.v[0]].p));
+            for(int i = 0; i < 3; i++) {
+                Vert &v = verts[t.v[i]];
+                v.q.Add(q);
+                v.tris.push_back(ti);
+
+                auto it = edges.find(EdgeKey(t.v[i], t.v[(i + 1) % 3]));
+                if(it == edges.end()) {
+                    edges.emplace(EdgeKey(t.v[i], t.v[(i + 1) % 3]),
+                                  EdgeInfo { 1, t.meta, false });
+                } else {
+                    EdgeInfo &ei = it->second;
+                    ei.count++;
+                    if(ei.meta.face != t.meta.face ||
+                       !ei.meta.color.Equals(t.meta.color)) {
+                        ei.mixed = true;
+                    }
+                }
+            }
+        }
+        for(auto &it : edges) {
+            if(it.second.count == 2 && !it.second.mixed) continue;
+            verts[(int)(it.first >> 32)].locked = true;
+            verts[(int)(it.first & 0xffffffff)].locked = true;
+        }
+        // A vertex can also join two regions that meet only at that vertex.
+        for(Vert &v : verts) {
+            for(int ti : v.tris) {
+                const STriMeta &m = tris[ti].meta, &m0 = tris[v.tris[0]].meta;
+                if(m.face != m0.face || !m.color.Equals(m0.color)) {
+                    v.locked = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    void Neighbours(int vi, std::vector<int> *out) const {
+        out->clear();
+        for(int ti : verts[vi].tris) {
+            const Tri &t = tris[ti];
+            if(t.removed) continue;
+            for(int i = 0; i < 3; i++) {
+                if(t.v[i] == vi) continue;
+                if(std::find(out->begin(), out->end(), t.v[i]) == out->end()) {
+                    out->push_back(t.v[i]);
+                }
+            }
+        }
+    }
+
+    void Consider(int from, int to) {
+        if(verts[from].locked) return;
+        Quadric q = verts[from].q;
+        q.Add(verts[to].q);
+        double cost = q.Evaluate(verts[to].p);
+        if(cost > maxCost) return;
+        queue.push({ cost, from, to, verts[from].version, verts[to].version });
+    }
+
+    void ConsiderAround(int vi) {
+        std::vector<int> nbrs;
+        Neighbours(vi, &nbrs);
+        for(int ni : nbrs) {
+            Consider(vi, ni);
+            Consider(ni, vi);
+        }
+    }
+
+    bool CanCollapse(int from, int to) const {
+        // The two vertices must share exactly the two triangles on the edge
+        // between them, or we'd make the mesh non-manifold.
+        std::vector<int> nf, nt;
+        Neighbours(from, &nf);
+        Neighbours(to, &nt);
+        int common = 0;
+        for(int vi : nf) {
+            if(std::find(nt.begin(), nt.end(), vi) != nt.end()) common++;
+        }
+        if(common != 2) return false;
+
+        // And no triangle that moves may flip over or become degenerate.
+        for(int ti : verts[from].tris) {
+            const Tri &t = tris[ti];
+            if(t.removed) continue;
+            if(t.v[0] == to || t.v[1] == to || t.v[2] == to) continue;
+            Vector a = verts[t.v[0]].p, b = verts[t.v[1]].p, c = verts[t.v[2]].p;
+            Vector before = b.Minus(a).Cross(c.Minus(a));
+            for(int i = 0; i < 3; i++) {
+                if(t.v[i] == from) {
+                    if(i == 0) a = verts[to].p;
+                    if(i == 1) b = verts[to].p;
+                    if(i == 2) c = verts[to].p;
+                }
+            }
+            Vector after = b.Minus(a).Cross(c.Minus(a));
+            if(after.Magnitude() < LENGTH_EPS*LENGTH_EPS) return false;
+            if(after.Dot(before) <= 0) return false;
+        }
+        return true;
+    }
+
+    void DoCollapse(int from, int to) {
+        // The surviving vertex keeps its own normal, which we can read from
+        // either of the triangles on the collapsed edge; all the triangles
+        // around the removed vertex are on the same face.
+        Vector toNormal = Vector::From(0, 0, 0);
+        for(int ti : verts[from].tris) {
+            Tri &t = tris[ti];
+            if(t.removed) continue;
+            for(int i = 0; i < 3; i++) {
+                if(t.v[i] == to) {
+                    toNormal = t.n[i];
+                    t.removed = true;
+                }
+            }
+        }
+        for(int ti : verts[from].tris) {
+            Tri &t = tris[ti];
+            if(t.removed) continue;
+            for(int i = 0; i < 3; i++) {
+                if(t.v[i] == from) {
+                    t.v[i] = to;
+                    t.n[i] = toNormal;
+                }
+            }
+            verts[to].tris.push_back(ti);
+        }
+
+        Vert &vf = verts[from], &vt = verts[to];
+        vf.removed = true;
+        vf.tris.clear();
+        vt.q.Add(vf.q);
+        vt.tris.erase(std::remove_if(vt.tris.begin(), vt.tris.end(),
+                                     [&](int ti) { return tris[ti].removed; }),
+                      vt.tris.end());
+        // Only the collapses onto or away from the surviving vertex change
+        // their cost.
+        vt.version++;
+        ConsiderAround(to);
+    }
+
+    void Run(double tol) {
+        maxCost = tol*tol;
+        for(int vi = 0; vi < (int)verts.size(); vi++) {
+            if(verts[vi].locked) continue;
+            ConsiderAround(vi);
+        }
+        while(!queue.empty()) {
+            Collapse c = queue.top();
+            queue.pop();
+            const Vert &vf = verts[c.from], &vt = verts[c.to];
+            if(vf.removed || vt.removed) continue;
+            if(vf.version != c.fromVersion || vt.version != c.toVersion) continue;
+            if(!CanCollapse(c.from, c.to)) continue;
+            DoCollapse(c.from, c.to);
+        }
+    }
+
+    void MakeMeshInto(SMesh *dest) const {
+        for(const Tri &t : tris) {
+            if(t.removed) continue;
+            STriangle st = {};
+            st.meta = t.meta;
+            for(int i = 0; i < 3; i++) {
+                st.vertices[i] = verts[t.v[i]].p;
+                st.normals[i]  = t.n[i];
+            }
+            dest->AddTriangle(&st);
+        }
+    }
+};
+
+}
+
+void SMesh::MakeFromDecimationOf(const SMesh *a, double tol) {
+    ssassert(this != a, "Can't make from decimation of self");
+    MeshDecimator md = {};
+    md.Build(a);
+    md.Run(tol);
+    md.MakeMeshInto(this);
+}
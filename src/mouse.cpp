@@ -14,6 +14,13 @@ void GraphicsWindow::UpdateDraggedPoint(hEntity hp, double mx, double my) {
     SS.ScheduleShowTW();
 }
 
+void GraphicsWindow::UpdateDraggedLabel(hConstraint hc, double mx, double my) {
+    Constraint *c = SK.GetConstraint(hc);
+    UpdateDraggedNum(&(c->disp.offset), mx, my);
+    // The label is somewhere else now than where it was laid out.
+    constraintIndex.dirty = true;
+}
+
 void GraphicsWindow::UpdateDraggedNum(Vector *pos, double mx, double my) {
     *pos = pos->Plus(projRight.ScaledBy((mx - orig.mouse.x)/scale));
     *pos = pos->Plus(projUp.ScaledBy((my - orig.mouse.y)/scale));
@@ -279,8 +286,7 @@ void GraphicsWindow::MouseMoved(double x, double y, bool leftDown,
     havePainted = false;
     switch(pending.operation) {
         case Pending::DRAGGING_CONSTRAINT: {
-            Constraint *c = SK.constraint.FindById(pending.constraint);
-            UpdateDraggedNum(&(c->disp.offset), x, y);
+            UpdateDraggedLabel(pending.constraint, x, y);
             orig.mouse = mp;
             Invalidate();
             return;
@@ -5,6 +5,13 @@
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
 #include "config.h"
+#if !defined(WIN32)
+#   include <poll.h>
+#   include <signal.h>
+#   include <unistd.h>
+#   include <sys/wait.h>
+#endif
+#include <thread>
 
 static void ShowUsage(const std::string &cmd) {
     fprintf(stderr, "Usage: %s <command> <options> <filename> [filename...]", cmd.c_str());
@@ -28,6 +35,11 @@ Common options:
         For non-export commands, the unit is %%, and the default is 1.0 %%.
     -b, --bg-color <on|off>
         Whether to export the background colour in vector formats. Defaults to off.
+    --trace <file>
+        Records how long loading, regenerating, and exporting each sketch
+        took, and writes that to <file> in the Chrome trace event format,
+        which chrome://tracing or https://ui.perfetto.dev can open. In a
+        batch manifest, this can be given for each command.
 
 Commands:
     version
@@ -51,6 +63,23 @@ Commands:
         Reloads all imported files, regenerates the sketch, and saves it.
         Note that, although this is not an export command, it uses absolute
         chord tolerance, and can be used to prepare assemblies for export.
+    batch [--jobs <count>] <manifest>
+        Runs every line of <manifest> as a separate command, written like the
+        arguments that follow the program name, e.g.
+        "export-mesh --output %%.stl part.slvs". Arguments containing spaces
+        can be enclosed in double quotes. Empty lines and lines starting with
+        '#' are skipped. Up to <count> commands run at once, in worker
+        processes that are started once and reused; the default is the
+        number of processors. For every command, a line of JSON with its
+        status and duration is printed to standard output.
+        On Windows, the commands run one at a time.
+    convert --output <pattern>
+        Converts the sketch between the text (.slvs) and the binary (.slvsb)
+        forms, chosen by the extension of the output file. A binary file
+        written next to the text file it was converted from, with the same
+        name, is used as a cache: it is loaded instead of parsing the text
+        for as long as the text file is unchanged, and is kept up to date
+        whenever the text file is saved.
 )");
 
     auto FormatListFromFileFilters = [](const std::vector<Platform::FileFilter> &filters) {
@@ -86,7 +115,272 @@ File formats:
     FormatListFromFileFilters(Platform::SurfaceFileFilters).c_str());
 }
 
-static bool RunCommand(const std::vector<std::string> args) {
+static bool RunCommand(std::vector<std::string> args);
+
+//-----------------------------------------------------------------------------
+// Running many commands from a manifest, in a few long-lived processes; so
+// that starting up and loading fonts is paid once, and not for every file.
+//-----------------------------------------------------------------------------
+
+struct BatchJob {
+    size_t                   line;
+    std::vector<std::string> args;
+};
+
+// Splits a manifest line into arguments, at whitespace outside of double quotes.
+static std::vector<std::string> SplitManifestLine(const std::string &line) {
+    std::vector<std::string> args;
+    std::string arg;
+    bool inArg = false, inQuotes = false;
+    for(char c : line) {
+        if(c == '"') {
+            inQuotes = !inQuotes;
+            inArg = true;
+        } else if(!inQuotes && isspace((unsigned char)c)) {
+            if(inArg) args.push_back(arg);
+            arg.clear();
+            inArg = false;
+        } else {
+            arg += c;
+            inArg = true;
+        }
+    }
+    if(inArg) args.push_back(arg);
+    return args;
+}
+
+static bool ReadManifest(const Platform::Path &filename, const std::string &cmd,
+                         std::vector<BatchJob> *jobs) {
+    std::string data;
+    if(!ReadFile(filename, &data)) {
+        fprintf(stderr, "Cannot read '%s'!\n", filename.raw.c_str());
+        return false;
+    }
+
+    std::stringstream stream(data);
+    std::string line;
+    for(size_t lineNumber = 1; std::getline(stream, line); lineNumber++) {
+        std::vector<std::string> args = SplitManifestLine(line);
+        if(args.empty() || args[0][0] == '#') continue;
+        if(args[0] == "batch") {
+            fprintf(stderr, "Line %d of '%s' runs a batch inside a batch.\n",
+                    (int)lineNumber, filename.raw.c_str());
+            return false;
+        }
+
+        BatchJob job = {};
+        job.line = lineNumber;
+        job.args.push_back(cmd);
+        job.args.insert(job.args.end(), args.begin(), args.end());
+        jobs->push_back(job);
+    }
+    return true;
+}
+
+static std::string EscapeJson(const std::string &str) {
+    std::string result;
+    for(char c : str) {
+        if(c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if((unsigned char)c < 0x20) {
+            result += ssprintf("\\u%04x", (unsigned char)c);
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+static void PrintBatchResult(const BatchJob &job, const char *status, int64_t millis) {
+    std::string args;
+    for(size_t i = 1; i < job.args.size(); i++) {
+        if(i > 1) args += ",";
+        args += "\"" + EscapeJson(job.args[i]) + "\"";
+    }
+    printf("{\"line\":%d,\"args\":[%s],\"status\":\"%s\",\"seconds\":%.3f}\n",
+           (int)job.line, args.c_str(), status, (double)millis / 1000.0);
+    fflush(stdout);
+}
+
+#if !defined(WIN32)
+// A worker process runs the jobs whose indices it is sent, one at a time,
+// and sends back whether each succeeded.
+struct BatchWorker {
+    pid_t   pid;
+    int     jobFd;
+    int     resultFd;
+    // The job it is running, if any.
+    size_t  job;
+    bool    busy;
+    int64_t startedAt;
+};
+
+static bool StartBatchWorker(const std::vector<BatchJob> &jobs,
+                             const std::vector<BatchWorker> &workers, BatchWorker *worker) {
+    int jobPipe[2], resultPipe[2];
+    if(pipe(jobPipe) != 0) return false;
+    if(pipe(resultPipe) != 0) {
+        close(jobPipe[0]);
+        close(jobPipe[1]);
+        return false;
+    }
+
+    // Or else whatever is buffered would be written again by the worker.
+    fflush(stdout);
+    fflush(stderr);
+    pid_t pid = fork();
+    if(pid == 0) {
+        close(jobPipe[1]);
+        close(resultPipe[0]);
+        // Or else the other workers wouldn't see their pipes close.
+        for(const BatchWorker &other : workers) {
+            if(other.pid == 0) continue;
+            close(other.jobFd);
+            close(other.resultFd);
+        }
+        uint32_t index;
+        while(read(jobPipe[0], &index, sizeof(index)) == sizeof(index)) {
+            uint8_t ok = RunCommand(jobs[index].args) ? 1 : 0;
+            fflush(stderr);
+            if(write(resultPipe[1], &ok, sizeof(ok)) != sizeof(ok)) break;
+        }
+        _exit(0);
+    }
+
+    close(jobPipe[0]);
+    close(resultPipe[1]);
+    if(pid < 0) {
+        close(jobPipe[1]);
+        close(resultPipe[0]);
+        return false;
+    }
+
+    *worker = {};
+    worker->pid      = pid;
+    worker->jobFd    = jobPipe[1];
+    worker->resultFd = resultPipe[0];
+    return true;
+}
+
+static void StopBatchWorker(BatchWorker *worker) {
+    close(worker->jobFd);
+    close(worker->resultFd);
+    waitpid(worker->pid, NULL, 0);
+    worker->pid = 0;
+}
+#endif
+
+static bool RunBatch(const std::vector<BatchJob> &jobs, unsigned workerCount) {
+    bool allOk = true;
+#if !defined(WIN32)
+    // A worker that crashed while being sent a job must not take us down with it.
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<BatchWorker> workers(min((size_t)workerCount, jobs.size()));
+    size_t nextJob = 0;
+    auto startNextJob = [&](BatchWorker *worker) {
+        if(worker->pid == 0 && !StartBatchWorker(jobs, workers, worker)) return;
+
+        uint32_t index = (uint32_t)nextJob;
+        if(write(worker->jobFd, &index, sizeof(index)) != sizeof(index)) return;
+        worker->job       = nextJob++;
+        worker->busy      = true;
+        worker->startedAt = GetMilliseconds();
+    };
+
+    for(BatchWorker &worker : workers) {
+        if(nextJob < jobs.size()) startNextJob(&worker);
+    }
+
+    while(true) {
+        std::vector<pollfd> fds;
+        std::vector<BatchWorker *> polled;
+        for(BatchWorker &worker : workers) {
+            if(!worker.busy) continue;
+            fds.push_back({ worker.resultFd, POLLIN, 0 });
+            polled.push_back(&worker);
+        }
+        if(fds.empty()) break;
+
+        if(poll(&fds[0], fds.size(), -1) < 0) continue;
+        for(size_t i = 0; i < fds.size(); i++) {
+            if(fds[i].revents == 0) continue;
+
+            BatchWorker *worker = polled[i];
+            const BatchJob &job = jobs[worker->job];
+            int64_t millis = GetMilliseconds() - worker->startedAt;
+            worker->busy = false;
+
+            uint8_t ok;
+            if(read(worker->resultFd, &ok, sizeof(ok)) == sizeof(ok)) {
+                PrintBatchResult(job, ok ? "ok" : "failed", millis);
+                if(!ok) allOk = false;
+            } else {
+                // The worker is gone; start another one for the rest of the jobs.
+                PrintBatchResult(job, "crashed", millis);
+                allOk = false;
+                StopBatchWorker(worker);
+            }
+
+            if(nextJob < jobs.size()) {
+                startNextJob(worker);
+            }
+        }
+    }
+
+    // Jobs are only left over if no worker could be started for them.
+    for(; nextJob < jobs.size(); nextJob++) {
+        PrintBatchResult(jobs[nextJob], "failed", 0);
+        allOk = false;
+    }
+    for(BatchWorker &worker : workers) {
+        if(worker.pid != 0) StopBatchWorker(&worker);
+    }
+#else
+    for(const BatchJob &job : jobs) {
+        int64_t startedAt = GetMilliseconds();
+        bool ok = RunCommand(job.args);
+        PrintBatchResult(job, ok ? "ok" : "failed", GetMilliseconds() - startedAt);
+        if(!ok) allOk = false;
+    }
+#endif
+    return allOk;
+}
+
+static bool RunUntracedCommand(const std::vector<std::string> args);
+
+static bool RunCommand(std::vector<std::string> args) {
+    // Any command can be traced, so that option is taken out before the
+    // command gets to see the rest.
+    Platform::Path traceFile;
+    for(size_t argn = 1; argn + 1 < args.size(); argn++) {
+        if(args[argn] == "--trace") {
+            traceFile = Platform::Path::From(args[argn + 1]);
+            args.erase(args.begin() + argn, args.begin() + argn + 2);
+            break;
+        }
+    }
+    if(traceFile.IsEmpty()) return RunUntracedCommand(args);
+
+    Profile::Clear();
+    Profile::SetEnabled(true);
+    bool ok;
+    {
+        Profile::Scope scope("Command");
+        ok = RunUntracedCommand(args);
+    }
+    Profile::SetEnabled(false);
+
+    if(!Profile::WriteTrace(traceFile.Expand(/*fromCurrentDirectory=*/true))) {
+        fprintf(stderr, "Cannot write trace '%s'!\n", traceFile.raw.c_str());
+        return false;
+    }
+    fprintf(stderr, "Written trace '%s'.\n", traceFile.raw.c_str());
+    return ok;
+}
+
+static bool RunUntracedCommand(const std::vector<std::string> args) {
     if(args.size() < 2) return false;
 
     for(const std::string &arg : args) {
@@ -176,10 +470,40 @@ static bool RunCommand(const std::vector<std::string> args) {
         } else return false;
     };
 
+    Platform::Path absInputFile;
     unsigned width = 0, height = 0;
     if(args[1] == "version") {
         fprintf(stderr, "SolveSpace version %s \n\n", PACKAGE_VERSION);
         return false;
+    } else if(args[1] == "batch") {
+        unsigned workerCount = std::max(1u, std::thread::hardware_concurrency());
+        Platform::Path manifest;
+        for(size_t argn = 2; argn < args.size(); argn++) {
+            if(argn + 1 < args.size() && (args[argn] == "--jobs" || args[argn] == "-j")) {
+                argn++;
+                if(sscanf(args[argn].c_str(), "%u", &workerCount) != 1 || workerCount == 0) {
+                    fprintf(stderr, "Bad job count '%s'.\n", args[argn].c_str());
+                    return false;
+                }
+            } else if(args[argn][0] != '-' && manifest.IsEmpty()) {
+                manifest = Platform::Path::From(args[argn]);
+            } else {
+                fprintf(stderr, "Unrecognized option '%s'.\n", args[argn].c_str());
+                return false;
+            }
+        }
+
+        if(manifest.IsEmpty()) {
+            fprintf(stderr, "A manifest must be specified.\n");
+            return false;
+        }
+
+        std::vector<BatchJob> jobs;
+        if(!ReadManifest(manifest, args[0], &jobs)) return false;
+
+        // Loaded once here, the fonts are shared with all the workers.
+        SS.fonts.LoadAll();
+        return RunBatch(jobs, workerCount);
     } else if(args[1] == "thumbnail") {
         auto ParseSize = [&](size_t &argn) {
             if(argn + 1 < args.size() && args[argn] == "--size") {
@@ -227,15 +551,17 @@ static bool RunCommand(const std::vector<std::string> args) {
             camera.offset     = SS.GW.offset;
             SS.GenerateAll();
 
-            CairoPixmapRenderer pixmapCanvas;
-            pixmapCanvas.antialias = true;
+            RasterRenderer pixmapCanvas;
             pixmapCanvas.SetLighting(SS.GW.GetLighting());
             pixmapCanvas.SetCamera(camera);
             pixmapCanvas.Init();
 
             pixmapCanvas.StartFrame();
-            SS.GW.Draw(&pixmapCanvas);
-            pixmapCanvas.FlushFrame();
+            {
+                Profile::Scope scope("Draw");
+                SS.GW.Draw(&pixmapCanvas);
+                pixmapCanvas.FlushFrame();
+            }
             pixmapCanvas.FinishFrame();
             pixmapCanvas.ReadFrame()->WritePng(output, /*flip=*/true);
 
@@ -326,6 +652,29 @@ static bool RunCommand(const std::vector<std::string> args) {
 
             SS.SaveToFile(output);
         };
+    } else if(args[1] == "convert") {
+        for(size_t argn = 2; argn < args.size(); argn++) {
+            if(!(ParseInputFile(argn) ||
+                 ParseOutputPattern(argn))) {
+                fprintf(stderr, "Unrecognized option '%s'.\n", args[argn].c_str());
+                return false;
+            }
+        }
+
+        runner = [&](const Platform::Path &output) {
+            if(output.HasExtension(SolveSpaceUI::CACHE_EXT)) {
+                // Next to its text source, the binary file is a cache of it.
+                Platform::Path source;
+                if(absInputFile.HasExtension(SolveSpaceUI::SKETCH_EXT) &&
+                   absInputFile.WithExtension(SolveSpaceUI::CACHE_EXT).Equals(output)) {
+                    source = absInputFile;
+                }
+                SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+                SS.SaveToBinaryCache(output, source);
+            } else {
+                SS.SaveToFile(output);
+            }
+        };
     } else {
         fprintf(stderr, "Unrecognized command '%s'.\n", args[1].c_str());
         return false;
@@ -346,7 +695,7 @@ static bool RunCommand(const std::vector<std::string> args) {
     }
 
     for(const Platform::Path &inputFile : inputFiles) {
-        Platform::Path absInputFile = inputFile.Expand(/*fromCurrentDirectory=*/true);
+        absInputFile = inputFile.Expand(/*fromCurrentDirectory=*/true);
 
         Platform::Path outputFile = Platform::Path::From(outputPattern);
         size_t replaceAt = outputFile.raw.find('%');
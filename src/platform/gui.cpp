@@ -97,6 +97,7 @@ std::vector<FileFilter> RasterFileFilters = {
 std::vector<FileFilter> MeshFileFilters = {
     { CN_("file-type", "STL mesh"), { "stl" } },
     { CN_("file-type", "Wavefront OBJ mesh"), { "obj" } },
+    { CN_("file-type", "Stanford PLY mesh"), { "ply" } },
     { CN_("file-type", "Three.js-compatible mesh, with viewer"), { "html" } },
     { CN_("file-type", "Three.js-compatible mesh, mesh only"), { "js" } },
     { CN_("file-type", "VRML text file"), { "wrl" } },
@@ -129,6 +130,10 @@ std::vector<FileFilter> CsvFileFilters = {
     { CN_("file-type", "Comma-separated values"), { "csv" } },
 };
 
+std::vector<FileFilter> TraceFileFilters = {
+    { CN_("file-type", "Chrome trace"), { "json" } },
+};
+
 
 }
 }
@@ -345,6 +345,8 @@ extern std::vector<FileFilter> Vector3dFileFilters;
 extern std::vector<FileFilter> ImportFileFilters;
 // Comma-separated value, like a spreadsheet would use
 extern std::vector<FileFilter> CsvFileFilters;
+// Timings, in the format that chrome://tracing and Perfetto read
+extern std::vector<FileFilter> TraceFileFilters;
 
 // A native dialog that asks to choose a file.
 class FileDialog {
@@ -9,6 +9,8 @@
 #   include <CoreFoundation/CFURL.h>
 #   include <CoreFoundation/CFBundle.h>
 #endif
+#include <atomic>
+#include <mutex>
 #include "solvespace.h"
 #include "mimalloc.h"
 #include "config.h"
@@ -16,8 +18,12 @@
 // Conversely, include Microsoft headers after solvespace.h to avoid clashes.
 #   include <windows.h>
 #   include <shellapi.h>
+#   include <sys/types.h>
+#   include <sys/stat.h>
 #else
 #   include <unistd.h>
+#   include <fcntl.h>
+#   include <sys/mman.h>
 #   include <sys/stat.h>
 #endif
 
@@ -426,6 +432,20 @@ void RemoveFile(const Platform::Path &filename) {
 #endif
 }
 
+// Replaces the destination, if it exists, in one step; so that the destination
+// is never seen half-written.
+bool RenameFile(const Platform::Path &from, const Platform::Path &to) {
+    ssassert(from.raw.length() == strlen(from.raw.c_str()) &&
+             to.raw.length() == strlen(to.raw.c_str()),
+             "Unexpected null byte in middle of a path");
+#if defined(WIN32)
+    return MoveFileExW(Widen(from.Expand().raw).c_str(), Widen(to.Expand().raw).c_str(),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(from.raw.c_str(), to.raw.c_str()) == 0;
+#endif
+}
+
 bool ReadFile(const Platform::Path &filename, std::string *data) {
     FILE *f = OpenFile(filename, "rb");
     if(f == NULL) return false;
@@ -455,6 +475,72 @@ bool WriteFile(const Platform::Path &filename, const std::string &data) {
     return true;
 }
 
+bool MappedFile::Open(const Platform::Path &filename) {
+    ssassert(filename.raw.length() == strlen(filename.raw.c_str()),
+             "Unexpected null byte in middle of a path");
+    Close();
+
+#if defined(WIN32)
+    HANDLE file = CreateFileW(Widen(filename.Expand(/*fromCurrentDirectory=*/true).raw).c_str(),
+                              GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+    if(fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return true;
+    }
+
+    // The view keeps the file mapped after both handles are closed.
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(mapping == NULL) return false;
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if(view == NULL) return false;
+    size_t viewSize = (size_t)fileSize.QuadPart;
+#else
+    int fd = open(filename.raw.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    if(st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(view == MAP_FAILED) return false;
+    size_t viewSize = (size_t)st.st_size;
+#endif
+
+    data = (const uint8_t *)view;
+    size = viewSize;
+    return true;
+}
+
+void MappedFile::Close() {
+    if(data != NULL) {
+#if defined(WIN32)
+        UnmapViewOfFile(data);
+#else
+        munmap((void *)data, size);
+#endif
+    }
+    data = NULL;
+    size = 0;
+}
+
 //-----------------------------------------------------------------------------
 // Loading resources, on Windows.
 //-----------------------------------------------------------------------------
@@ -695,8 +781,12 @@ struct MimallocHeap {
 };
 
 static thread_local MimallocHeap TempArena;
+static thread_local TemporaryArena *CurrentArena;
 
 void *AllocTemporary(size_t size) {
+    if(CurrentArena != NULL) {
+        return CurrentArena->Alloc(size);
+    }
     if(TempArena.heap == NULL) {
         TempArena.heap = mi_heap_new();
         ssassert(TempArena.heap != NULL, "out of memory");
@@ -711,5 +801,115 @@ void FreeAllTemporary() {
     std::swap(TempArena.heap, temp.heap);
 }
 
+// An arena hands out memory from large chunks, each thread from a chunk of its
+// own, so that threads only contend when they need a new chunk. A chunk that
+// a thread was allocating from is left behind, partly unused, when that thread
+// moves on to another arena, or the arena is reset; the generation tells that
+// apart from the thread's own chunk of the arena that is current now.
+class TemporaryArena::Chunks {
+public:
+    static const size_t CHUNK_SIZE = 256 * 1024;
+
+    std::mutex          mutex;
+    std::vector<void *> chunks;
+    size_t              size = 0;
+
+    void *Add(size_t chunkSize) {
+        void *chunk = calloc(1, chunkSize);
+        ssassert(chunk != NULL, "out of memory");
+
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.push_back(chunk);
+        size += chunkSize;
+        TotalArenaSize += chunkSize;
+        return chunk;
+    }
+
+    void Free() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for(void *chunk : chunks) {
+            free(chunk);
+        }
+        chunks.clear();
+        TotalArenaSize -= size;
+        size = 0;
+    }
+
+    static std::atomic<size_t> TotalArenaSize;
+};
+
+std::atomic<size_t> TemporaryArena::Chunks::TotalArenaSize(0);
+
+static std::atomic<uint64_t> ArenaGenerations(0);
+
+struct ArenaCursor {
+    uint64_t    generation;
+    char        *next;
+    size_t      left;
+};
+
+static thread_local ArenaCursor CurrentChunk;
+
+TemporaryArena::TemporaryArena() {
+    chunks = new Chunks;
+    generation = ++ArenaGenerations;
+    outer = CurrentArena;
+    CurrentArena = this;
+}
+
+TemporaryArena::~TemporaryArena() {
+    ssassert(CurrentArena == this, "Temporary arenas must be destroyed in reverse order");
+    CurrentArena = outer;
+    chunks->Free();
+    delete chunks;
+}
+
+void *TemporaryArena::Alloc(size_t size) {
+    // Everything we allocate is a double or a pointer at most.
+    size = (size + 15) & ~(size_t)15;
+    if(size > Chunks::CHUNK_SIZE / 4) {
+        // Too big to share a chunk; it gets one of its own.
+        return chunks->Add(size);
+    }
+
+    ArenaCursor &cursor = CurrentChunk;
+    if(cursor.generation != generation || cursor.left < size) {
+        cursor.generation = generation;
+        cursor.next = (char *)chunks->Add(Chunks::CHUNK_SIZE);
+        cursor.left = Chunks::CHUNK_SIZE;
+    }
+    void *ptr = cursor.next;
+    cursor.next += size;
+    cursor.left -= size;
+    return ptr;
+}
+
+void TemporaryArena::Reset() {
+    chunks->Free();
+    generation = ++ArenaGenerations;
+}
+
+size_t TemporaryArena::Size() const {
+    std::lock_guard<std::mutex> lock(chunks->mutex);
+    return chunks->size;
+}
+
+size_t TemporaryArena::TotalSize() {
+    return Chunks::TotalArenaSize;
+}
+
+TemporaryArena *TemporaryArena::Current() {
+    return CurrentArena;
+}
+
+TemporaryArena::Use::Use(TemporaryArena *arena) {
+    outer = CurrentArena;
+    CurrentArena = arena;
+}
+
+TemporaryArena::Use::~Use() {
+    CurrentArena = outer;
+}
+
 }
 }
@@ -66,6 +66,24 @@ FILE *OpenFile(const Platform::Path &filename, const char *mode);
 bool ReadFile(const Platform::Path &filename, std::string *data);
 bool WriteFile(const Platform::Path &filename, const std::string &data);
 void RemoveFile(const Platform::Path &filename);
+bool RenameFile(const Platform::Path &from, const Platform::Path &to);
+
+// A read-only view of the whole contents of a file, mapped into memory.
+// An empty file opens successfully with no data.
+class MappedFile {
+public:
+    const uint8_t *data = NULL;
+    size_t         size = 0;
+
+    MappedFile() {}
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool Open(const Platform::Path &filename);
+    void Close();
+};
 
 // Resource loading function.
 const void *LoadResource(const std::string &name, size_t *size);
@@ -80,6 +98,54 @@ void DebugPrint(const char *fmt, ...);
 void *AllocTemporary(size_t size);
 void FreeAllTemporary();
 
+// A nested temporary arena. While it is alive, AllocTemporary on the thread that
+// created it allocates from it; when it is destroyed, all of that memory is
+// freed at once, and the arena that was current before becomes current again.
+// FreeAllTemporary only frees what was allocated outside of any such arena.
+//
+// Other threads, like the workers of a parallel loop, can allocate from it too,
+// for as long as they hold a TemporaryArena::Use of it; that memory belongs to
+// the arena just the same, and must not outlive it.
+class TemporaryArena {
+public:
+    TemporaryArena();
+    ~TemporaryArena();
+
+    TemporaryArena(const TemporaryArena &) = delete;
+    TemporaryArena &operator=(const TemporaryArena &) = delete;
+
+    void *Alloc(size_t size);
+    // Free everything allocated so far, but keep the arena current.
+    void Reset();
+
+    // How much memory this arena holds, and all of the arenas together.
+    size_t Size() const;
+    static size_t TotalSize();
+
+    // The arena that AllocTemporary on this thread allocates from, if any.
+    static TemporaryArena *Current();
+
+    // Makes an arena current on this thread until the end of the enclosing block.
+    class Use {
+    public:
+        Use(TemporaryArena *arena);
+        ~Use();
+
+        Use(const Use &) = delete;
+        Use &operator=(const Use &) = delete;
+
+    private:
+        TemporaryArena *outer;
+    };
+
+private:
+    class Chunks;
+
+    Chunks         *chunks;
+    uint64_t        generation;
+    TemporaryArena *outer;
+};
+
 }
 
 #endif
@@ -164,7 +164,7 @@ public:
     Vector AnyPoint() const;
     void OffsetInto(SPolygon *dest, double r) const;
     void UvTriangulateInto(SMesh *m, SSurface *srf);
-    void UvGridTriangulateInto(SMesh *m, SSurface *srf);
+    void UvGridTriangulateInto(SMesh *m, SSurface *srf, double chordTol);
     void TriangulateInto(SMesh *m) const;
     void InverseTransformInto(SPolygon *sp, Vector u, Vector v, Vector n) const;
 };
@@ -253,7 +253,19 @@ public:
 
 class SMesh {
 public:
+    // A run of triangles from one face; PrecomputeTransparency() puts the
+    // triangles of each face together, and finds these.
+    struct FaceRange {
+        uint32_t    face;
+        int         start;
+        int         n;
+        Vector      bbmax;
+        Vector      bbmin;
+    };
+
     List<STriangle>     l;
+    // Sorted by face; a face has two ranges if some of it is transparent.
+    std::vector<FaceRange> faceRanges;
 
     bool    flipNormal;
     bool    keepInsideOtherShell;
@@ -280,6 +292,9 @@ public:
     void MakeFromTransformationOf(SMesh *a, Vector trans,
                                   Quaternion q, double scale);
     void MakeFromAssemblyOf(SMesh *a, SMesh *b);
+    void MakeFromDecimationOf(const SMesh *a, double tol);
+
+    void SnapToVertices();
 
     void MakeEdgesInPlaneInto(SEdgeList *sel, Vector n, double d);
     void MakeOutlinesInto(SOutlineList *sol, EdgeKind type);
@@ -293,8 +308,34 @@ public:
     void RemapFaces(Group *g, int remap);
 
     uint32_t FirstIntersectionWith(Point2d mp) const;
+    uint32_t FirstIntersectionWith(const Vector &rayPoint, const Vector &rayDir,
+                                   double *faceT) const;
 
     Vector GetCenterOfMass() const;
+
+    // Call fn for each triangle from one of the given faces; that's quick
+    // once the triangles are grouped by face, and a scan otherwise.
+    template<class F>
+    void ForEachTriangleOf(const std::vector<uint32_t> &faces, F fn) const {
+        if(faces.empty()) return;
+        if(faceRanges.empty()) {
+            for(const STriangle &tr : l) {
+                if(std::find(faces.begin(), faces.end(), tr.meta.face) != faces.end()) {
+                    fn(tr);
+                }
+            }
+            return;
+        }
+        for(uint32_t face : faces) {
+            auto it = std::lower_bound(faceRanges.begin(), faceRanges.end(), face,
+                [](const FaceRange &fr, uint32_t f) { return fr.face < f; });
+            for(; it != faceRanges.end() && it->face == face; ++it) {
+                for(int i = it->start; i < it->start + it->n; i++) {
+                    fn(l[i]);
+                }
+            }
+        }
+    }
 };
 
 // A linked list of triangles
@@ -335,6 +376,8 @@ public:
         STriangle *tr;
         int        ai;
         int        bi;
+        // If not NULL, every triangle that the edge intersects goes here.
+        std::vector<STriangle *> *crossed;
     };
 
     int which;  // whether c is x, y, or z
@@ -366,6 +409,43 @@ public:
     void SnapToVertex(Vector v, SMesh *extras);
 };
 
+// Finds the naked and self-intersecting edges of a mesh, like
+// SKdNode::MakeCertainEdgesInto with EdgeKind::NAKED_OR_SELF_INTER. The
+// triangles on each edge are counted in a hash table keyed by its vertices,
+// and what was found is kept per face, so that checking a mesh again only
+// has to look at the faces that changed since the last check.
+class SMeshCheck {
+public:
+    struct Face {
+        uint64_t                digest;
+        std::vector<STriangle>  tris;
+        // The vertex indices of each triangle, three per triangle.
+        std::vector<int>        verts;
+        // The edges (3*triangle + vertex) that intersect the mesh, and the
+        // face of the triangle that they intersect.
+        std::vector<std::pair<int, uint32_t>> crossings;
+    };
+
+    struct EdgeCount {
+        // The number of triangles with this edge from the lower-numbered
+        // vertex to the higher, and from the higher to the lower.
+        int     n[2];
+    };
+
+    bool                                            coplanarIsInter;
+    std::unordered_map<uint32_t, Face>              faces;
+    std::vector<Vector>                             verts;
+    std::unordered_map<uint64_t, std::vector<int>>  cells;
+    std::unordered_map<uint64_t, EdgeCount>         edges;
+    std::unordered_set<uint64_t>                    naked;
+
+    int VertexFor(Vector p);
+    void CountEdges(const Face &f, int delta, std::vector<uint64_t> *touched);
+    void Check(SMesh *m, bool coplanarIsInter, SEdgeList *sel,
+               bool *inter, bool *leaky, int auxA = 0);
+    void Clear();
+};
+
 class PolylineBuilder {
 public:
     struct Edge;
@@ -0,0 +1,242 @@
+//-----------------------------------------------------------------------------
+// Recording scoped timers and counters, summing them up per frame, and
+// writing them out in the Chrome trace event format.
+//-----------------------------------------------------------------------------
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include "solvespace.h"
+
+namespace SolveSpace {
+namespace Profile {
+
+class Event {
+public:
+    enum class Type : uint32_t { SCOPE, COUNTER, FRAME };
+
+    Type        type;
+    const char  *name;
+    int64_t     start;
+    int64_t     micros;     // or the value, for a counter
+    int         thread;
+    int         depth;
+    uint64_t    sequence;   // in which the scopes on this thread were started
+};
+
+// A long session would otherwise keep growing this forever; a million events
+// is a few minutes of continuous regeneration of a big model.
+static const size_t MAX_EVENTS = 1 << 20;
+
+static std::atomic<bool>    enabled(false);
+static std::atomic<int>     threadCount(0);
+
+static std::mutex           mutex;
+// Everything below is guarded by the mutex.
+static std::deque<Event>    events;
+static uint64_t             eventsRecorded;
+static uint64_t             frameFirstEvent;
+static int64_t              frameStart = -1;
+static Frame                lastFrame;
+
+static thread_local int     threadId = -1;
+static thread_local int     depth;
+static thread_local uint64_t scopesStarted;
+
+static int64_t Now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - epoch).count();
+}
+
+static int ThreadId() {
+    if(threadId < 0) threadId = threadCount++;
+    return threadId;
+}
+
+static void Record(const Event &e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(events.size() == MAX_EVENTS) events.pop_front();
+    events.push_back(e);
+    eventsRecorded++;
+}
+
+bool IsEnabled() {
+    return enabled;
+}
+
+void SetEnabled(bool enable) {
+    if(enable && !enabled) {
+        std::lock_guard<std::mutex> lock(mutex);
+        frameFirstEvent = eventsRecorded;
+        frameStart = Now();
+    }
+    enabled = enable;
+}
+
+void Clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.clear();
+    frameFirstEvent = eventsRecorded;
+    frameStart = enabled ? Now() : -1;
+    lastFrame = {};
+}
+
+Scope::Scope(const char *name) : name(name), start(-1), sequence(0) {
+    if(!enabled) return;
+    start = Now();
+    sequence = scopesStarted++;
+    depth++;
+}
+
+Scope::~Scope() {
+    if(start < 0) return;
+    depth--;
+    Record({ Event::Type::SCOPE, name, start, Now() - start, ThreadId(), depth, sequence });
+}
+
+void Count(const char *name, int64_t value) {
+    if(!enabled) return;
+    Record({ Event::Type::COUNTER, name, Now(), value, ThreadId(), depth, 0 });
+}
+
+void EndFrame() {
+    if(!enabled) return;
+
+    int64_t now = Now();
+    int thread = ThreadId();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = (size_t)min<uint64_t>(eventsRecorded - frameFirstEvent, events.size());
+    std::vector<Event> scopes;
+    Frame frame = {};
+    for(auto it = events.end() - count; it != events.end(); ++it) {
+        const Event &e = *it;
+        if(e.type == Event::Type::SCOPE) {
+            if(e.thread == thread) scopes.push_back(e);
+        } else if(e.type == Event::Type::COUNTER) {
+            // Keep only the latest value of each counter.
+            auto c = std::find_if(frame.counters.begin(), frame.counters.end(),
+                [&](const Frame::Counter &c) { return !strcmp(c.name, e.name); });
+            if(c == frame.counters.end()) {
+                frame.counters.push_back({ e.name, e.micros });
+            } else {
+                c->value = e.micros;
+            }
+        }
+    }
+
+    // Scopes are recorded as they end, so children come before their parents;
+    // in order of start, each parent comes right before its children instead.
+    // Many scopes start within the same microsecond, so that order has to be
+    // counted rather than timed.
+    std::sort(scopes.begin(), scopes.end(), [](const Event &a, const Event &b) {
+        return a.sequence < b.sequence;
+    });
+
+    class Node {
+    public:
+        const char          *name;
+        int64_t             micros;
+        int                 calls;
+        std::vector<size_t> children;
+    };
+    std::vector<Node> nodes = { {} };
+    // The node of the most recently started scope at each depth, whose
+    // children any later scope one level deeper must be.
+    std::vector<size_t> open;
+    for(const Event &e : scopes) {
+        size_t parent = 0;
+        if(e.depth > 0 && (size_t)e.depth <= open.size()) parent = open[e.depth - 1];
+
+        size_t node = 0;
+        for(size_t child : nodes[parent].children) {
+            if(!strcmp(nodes[child].name, e.name)) {
+                node = child;
+                break;
+            }
+        }
+        if(node == 0) {
+            node = nodes.size();
+            nodes.push_back({ e.name, 0, 0, {} });
+            nodes[parent].children.push_back(node);
+        }
+        nodes[node].micros += e.micros;
+        nodes[node].calls++;
+
+        open.resize(min((size_t)e.depth, open.size()));
+        open.push_back(node);
+    }
+
+    std::function<void(size_t, int)> addLines = [&](size_t node, int level) {
+        for(size_t child : nodes[node].children) {
+            frame.lines.push_back({ nodes[child].name, level,
+                                    nodes[child].micros, nodes[child].calls });
+            addLines(child, level + 1);
+        }
+    };
+    addLines(0, 0);
+
+    if(frameStart < 0) frameStart = now;
+    frame.micros = now - frameStart;
+    lastFrame = std::move(frame);
+
+    // Mark the frame itself in the trace, too.
+    if(events.size() == MAX_EVENTS) events.pop_front();
+    events.push_back({ Event::Type::FRAME, "Frame", frameStart, now - frameStart, thread, -1, 0 });
+    eventsRecorded++;
+
+    frameFirstEvent = eventsRecorded;
+    frameStart = now;
+}
+
+Frame LastFrame() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lastFrame;
+}
+
+static std::string Escape(const char *s) {
+    std::string result;
+    for(; *s; s++) {
+        if(*s == '"' || *s == '\\') result += '\\';
+        result += *s;
+    }
+    return result;
+}
+
+bool WriteTrace(const Platform::Path &filename) {
+    FILE *f = OpenFile(filename, "wb");
+    if(!f) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for(const Event &e : events) {
+        if(!first) fprintf(f, ",\n");
+        first = false;
+
+        std::string name = Escape(e.name);
+        switch(e.type) {
+            case Event::Type::SCOPE:
+            case Event::Type::FRAME:
+                fprintf(f, "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                           "\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%d}",
+                        name.c_str(), e.type == Event::Type::FRAME ? "frame" : "scope",
+                        (long long)e.start, (long long)e.micros, e.thread);
+                break;
+
+            case Event::Type::COUNTER:
+                fprintf(f, "{\"name\":\"%s\",\"ph\":\"C\","
+                           "\"ts\":%lld,\"pid\":1,\"tid\":%d,\"args\":{\"value\":%lld}}",
+                        name.c_str(), (long long)e.start, e.thread, (long long)e.micros);
+                break;
+        }
+    }
+    fprintf(f, "\n]}\n");
+
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+}
+}
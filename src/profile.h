@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+// Timing how long it takes to regenerate and draw the sketch: scoped timers
+// and counters, recorded while asked for, summed up per frame, and written
+// out as a trace that chrome://tracing or https://ui.perfetto.dev can open.
+//-----------------------------------------------------------------------------
+
+#ifndef SOLVESPACE_PROFILE_H
+#define SOLVESPACE_PROFILE_H
+
+namespace Profile {
+
+// Nothing is recorded until this is turned on; until then, a scope or a
+// counter costs no more than checking the flag.
+bool IsEnabled();
+void SetEnabled(bool enabled);
+// Forgets everything recorded so far.
+void Clear();
+
+// Times the code from here to the end of the enclosing block. The name is
+// kept as a pointer, so it should be a string literal.
+class Scope {
+public:
+    const char  *name;
+    int64_t     start;      // in microseconds, or -1 if not recording
+    uint64_t    sequence;
+
+    Scope(const char *name);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+};
+
+// Records the current value of something worth keeping track of alongside
+// the timings, like the number of triangles drawn.
+void Count(const char *name, int64_t value);
+
+// What the time between two calls to EndFrame() on the same thread went to.
+// The scopes are in tree order, with repeated calls of the same scope under
+// the same parent summed together.
+class Frame {
+public:
+    class Line {
+    public:
+        const char  *name;
+        int         depth;
+        int64_t     micros;
+        int         calls;
+    };
+    class Counter {
+    public:
+        const char  *name;
+        int64_t     value;
+    };
+
+    int64_t                 micros;
+    std::vector<Line>       lines;
+    std::vector<Counter>    counters;
+};
+
+void EndFrame();
+Frame LastFrame();
+
+// Writes everything recorded, in the Chrome trace event format.
+bool WriteTrace(const Platform::Path &filename);
+
+}
+
+#endif
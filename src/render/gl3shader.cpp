@@ -8,50 +8,6 @@
 
 namespace SolveSpace {
 
-//-----------------------------------------------------------------------------
-// Floating point data structures
-//-----------------------------------------------------------------------------
-
-Vector2f Vector2f::From(float x, float y) {
-    return { x, y };
-}
-
-Vector2f Vector2f::From(double x, double y) {
-    return { (float)x, (float)y };
-}
-
-Vector2f Vector2f::FromInt(uint32_t x, uint32_t y) {
-    return { (float)x, (float)y };
-}
-
-Vector3f Vector3f::From(float x, float y, float z) {
-    return { x, y, z };
-}
-
-Vector3f Vector3f::From(const Vector &v) {
-    return { (float)v.x, (float)v.y, (float)v.z };
-}
-
-Vector3f Vector3f::From(const RgbaColor &c) {
-    return { c.redF(), c.greenF(), c.blueF() };
-}
-
-Vector4f Vector4f::From(float x, float y, float z, float w) {
-    return { x, y, z, w };
-}
-
-Vector4f Vector4f::From(const Vector &v, float w) {
-    return { (float)v.x, (float)v.y, (float)v.z, w };
-}
-
-Vector4f Vector4f::FromInt(uint32_t x, uint32_t y, uint32_t z, uint32_t w) {
-    return { (float)x, (float)y, (float)z, (float)w };
-}
-
-Vector4f Vector4f::From(const RgbaColor &c) {
-    return { c.redF(), c.greenF(), c.blueF(), c.alphaF() };
-}
-
 //-----------------------------------------------------------------------------
 // Shader manipulation
 //-----------------------------------------------------------------------------
@@ -480,101 +436,15 @@ EdgeRenderer::Handle EdgeRenderer::Add(const SEdgeList &edges, bool dynamic) {
     glBindBuffer(GL_ARRAY_BUFFER, handle.vertexBuffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle.indexBuffer);
 
-    EdgeVertex *vertices = new EdgeVertex[edges.l.n * 8];
-    uint32_t *indices = new uint32_t[edges.l.n * 6 * 3];
-    double phase = 0.0;
-    uint32_t curVertex = 0;
-    uint32_t curIndex = 0;
-    for(int i = 0; i < edges.l.n; i++) {
-        const SEdge &curr = edges.l[i];
-        const SEdge &next = edges.l[(i + 1) % edges.l.n];
-
-        // 3d positions
-        Vector3f a = Vector3f::From(curr.a);
-        Vector3f b = Vector3f::From(curr.b);
-
-        // tangent
-        Vector3f tan = Vector3f::From(curr.b.Minus(curr.a));
-
-        // length
-        double len = curr.b.Minus(curr.a).Magnitude();
-
-        // make line start cap
-        for(int j = 0; j < 2; j++) {
-            vertices[curVertex + j].pos = a;
-            vertices[curVertex + j].tan = tan;
-        }
-        vertices[curVertex + 0].loc = Vector3f::From(-1.0f, -1.0f, float(phase));
-        vertices[curVertex + 1].loc = Vector3f::From(-1.0f, +1.0f, float(phase));
-
-        indices[curIndex++] = curVertex + 0;
-        indices[curIndex++] = curVertex + 1;
-        indices[curIndex++] = curVertex + 2;
-        indices[curIndex++] = curVertex + 1;
-        indices[curIndex++] = curVertex + 2;
-        indices[curIndex++] = curVertex + 3;
-
-        curVertex += 2;
-
-        // make line body
-        vertices[curVertex +  0].pos = a;
-        vertices[curVertex +  1].pos = a;
-        vertices[curVertex +  2].pos = b;
-        vertices[curVertex +  3].pos = b;
-
-        for(int j = 0; j < 4; j++) {
-            vertices[curVertex + j].tan = tan;
-        }
-
-        vertices[curVertex +  0].loc = Vector3f::From( 0.0f, -1.0f, float(phase));
-        vertices[curVertex +  1].loc = Vector3f::From( 0.0f, +1.0f, float(phase));
-        vertices[curVertex +  2].loc = Vector3f::From( 0.0f, +1.0f, float(phase + len));
-        vertices[curVertex +  3].loc = Vector3f::From( 0.0f, -1.0f, float(phase + len));
-
-        indices[curIndex++] = curVertex + 0;
-        indices[curIndex++] = curVertex + 1;
-        indices[curIndex++] = curVertex + 2;
-        indices[curIndex++] = curVertex + 0;
-        indices[curIndex++] = curVertex + 2;
-        indices[curIndex++] = curVertex + 3;
-
-        curVertex += 4;
+    std::vector<EdgeVertex> vertices;
+    std::vector<uint32_t>   indices;
+    MakeEdgeVertices(edges, &vertices, &indices);
 
-        // make line end cap
-        for(int j = 0; j < 2; j++) {
-            vertices[curVertex + j].pos = b;
-            vertices[curVertex + j].tan = tan;
-        }
-
-        vertices[curVertex + 0].loc = Vector3f::From(+1.0, +1.0, float(phase + len));
-        vertices[curVertex + 1].loc = Vector3f::From(+1.0, -1.0, float(phase + len));
-
-        indices[curIndex++] = curVertex - 2;
-        indices[curIndex++] = curVertex - 1;
-        indices[curIndex++] = curVertex;
-        indices[curIndex++] = curVertex - 1;
-        indices[curIndex++] = curVertex;
-        indices[curIndex++] = curVertex + 1;
-
-        curVertex += 2;
-
-        // phase stitching
-        if(curr.a.EqualsExactly(next.a) ||
-           curr.a.EqualsExactly(next.b) ||
-           curr.b.EqualsExactly(next.a) ||
-           curr.b.EqualsExactly(next.b))
-        {
-            phase += len;
-        } else {
-            phase = 0.0;
-        }
-    }
-    handle.size = curIndex;
+    handle.size = (GLsizei)indices.size();
     GLenum mode = dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
-    glBufferData(GL_ARRAY_BUFFER, curVertex * sizeof(EdgeVertex), vertices, mode);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, curIndex * sizeof(uint32_t), indices, mode);
-    delete []vertices;
-    delete []indices;
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(EdgeVertex), vertices.data(), mode);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(),
+                 mode);
 
     return handle;
 }
@@ -668,115 +538,17 @@ OutlineRenderer::Handle OutlineRenderer::Add(const SOutlineList &outlines, bool
     glBindBuffer(GL_ARRAY_BUFFER, handle.vertexBuffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle.indexBuffer);
 
-    OutlineVertex *vertices = new OutlineVertex[outlines.l.n * 8];
-    uint32_t *indices = new uint32_t[outlines.l.n * 6 * 3];
-    double phase = 0.0;
-    uint32_t curVertex = 0;
-    uint32_t curIndex = 0;
-
-    for(int i = 0; i < outlines.l.n; i++) {
-        const SOutline &curr = outlines.l[i];
-        const SOutline &next = outlines.l[(i + 1) % outlines.l.n];
-
-        // 3d positions
-        Vector3f a = Vector3f::From(curr.a);
-        Vector3f b = Vector3f::From(curr.b);
-        Vector3f nl = Vector3f::From(curr.nl);
-        Vector3f nr = Vector3f::From(curr.nr);
-
-        // tangent
-        Vector3f tan = Vector3f::From(curr.b.Minus(curr.a));
-
-        // length
-        double len = curr.b.Minus(curr.a).Magnitude();
-        float tag = (float)curr.tag;
-
-        // make line start cap
-        for(int j = 0; j < 2; j++) {
-            vertices[curVertex + j].pos = a;
-            vertices[curVertex + j].nol = nl;
-            vertices[curVertex + j].nor = nr;
-            vertices[curVertex + j].tan = tan;
-        }
-
-        vertices[curVertex + 0].loc = Vector4f::From(-1.0f, -1.0f, float(phase), (float)tag);
-        vertices[curVertex + 1].loc = Vector4f::From(-1.0f, +1.0f, float(phase), (float)tag);
-
-        indices[curIndex++] = curVertex;
-        indices[curIndex++] = curVertex + 1;
-        indices[curIndex++] = curVertex + 2;
-        indices[curIndex++] = curVertex + 1;
-        indices[curIndex++] = curVertex + 2;
-        indices[curIndex++] = curVertex + 3;
-
-        curVertex += 2;
+    std::vector<OutlineVertex> vertices;
+    std::vector<uint32_t>      indices;
+    MakeOutlineVertices(outlines, &vertices, &indices);
 
-        // make line body
-        vertices[curVertex +  0].pos = a;
-        vertices[curVertex +  1].pos = a;
-        vertices[curVertex +  2].pos = b;
-        vertices[curVertex +  3].pos = b;
-
-        for(int j = 0; j < 4; j++) {
-            vertices[curVertex + j].nol = nl;
-            vertices[curVertex + j].nor = nr;
-            vertices[curVertex + j].tan = tan;
-        }
-
-        vertices[curVertex +  0].loc = Vector4f::From( 0.0f, -1.0f, float(phase), (float)tag);
-        vertices[curVertex +  1].loc = Vector4f::From( 0.0f, +1.0f, float(phase), (float)tag);
-        vertices[curVertex +  2].loc = Vector4f::From( 0.0f, +1.0f,
-                                                      float(phase + len), (float)tag);
-        vertices[curVertex +  3].loc = Vector4f::From( 0.0f, -1.0f,
-                                                      float(phase + len), (float)tag);
-
-        indices[curIndex++] = curVertex + 0;
-        indices[curIndex++] = curVertex + 1;
-        indices[curIndex++] = curVertex + 2;
-        indices[curIndex++] = curVertex + 0;
-        indices[curIndex++] = curVertex + 2;
-        indices[curIndex++] = curVertex + 3;
-
-        curVertex += 4;
-
-        // make line end cap
-        for(int j = 0; j < 2; j++) {
-            vertices[curVertex + j].pos = b;
-            vertices[curVertex + j].nol = nl;
-            vertices[curVertex + j].nor = nr;
-            vertices[curVertex + j].tan = tan;
-        }
-
-        vertices[curVertex + 0].loc = Vector4f::From(+1.0f, +1.0f, float(phase + len), (float)tag);
-        vertices[curVertex + 1].loc = Vector4f::From(+1.0f, -1.0f, float(phase + len), (float)tag);
-
-        indices[curIndex++] = curVertex - 2;
-        indices[curIndex++] = curVertex - 1;
-        indices[curIndex++] = curVertex;
-        indices[curIndex++] = curVertex - 1;
-        indices[curIndex++] = curVertex;
-        indices[curIndex++] = curVertex + 1;
-
-        curVertex += 2;
-
-        // phase stitching
-        if(curr.a.EqualsExactly(next.a) ||
-           curr.a.EqualsExactly(next.b) ||
-           curr.b.EqualsExactly(next.a) ||
-           curr.b.EqualsExactly(next.b))
-        {
-            phase += len;
-        } else {
-            phase = 0.0;
-        }
-    }
-    handle.size = curIndex;
+    handle.size = (GLsizei)indices.size();
     GLenum mode = dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
-    glBufferData(GL_ARRAY_BUFFER, curVertex * sizeof(OutlineVertex), vertices, mode);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, curIndex * sizeof(uint32_t), indices, mode);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(OutlineVertex), vertices.data(),
+                 mode);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(),
+                 mode);
 
-    delete []vertices;
-    delete []indices;
     return handle;
 }
 
@@ -29,38 +29,6 @@
 
 namespace SolveSpace {
 
-//-----------------------------------------------------------------------------
-// Floating-point data structures; the layout of these must match shaders
-//-----------------------------------------------------------------------------
-
-class Vector2f {
-public:
-    float x, y;
-
-    static Vector2f From(float x, float y);
-    static Vector2f From(double x, double y);
-    static Vector2f FromInt(uint32_t x, uint32_t y);
-};
-
-class Vector3f {
-public:
-    float x, y, z;
-
-    static Vector3f From(float x, float y, float z);
-    static Vector3f From(const Vector &v);
-    static Vector3f From(const RgbaColor &c);
-};
-
-class Vector4f {
-public:
-    float x, y, z, w;
-
-    static Vector4f From(float x, float y, float z, float w);
-    static Vector4f From(const Vector &v, float w);
-    static Vector4f FromInt(uint32_t x, uint32_t y, uint32_t z, uint32_t w);
-    static Vector4f From(const RgbaColor &c);
-};
-
 //-----------------------------------------------------------------------------
 // Wrappers for our shaders
 //-----------------------------------------------------------------------------
@@ -138,12 +106,6 @@ public:
     const GLint ATTRIB_LOC = 1;
     const GLint ATTRIB_TAN = 2;
 
-    struct EdgeVertex {
-        Vector3f    pos;
-        Vector3f    loc;
-        Vector3f    tan;
-    };
-
     struct Handle {
         GLuint      vertexBuffer;
         GLuint      indexBuffer;
@@ -176,14 +138,6 @@ public:
     const GLint ATTRIB_NOL = 3;
     const GLint ATTRIB_NOR = 4;
 
-    struct OutlineVertex {
-        Vector3f    pos;
-        Vector4f    loc;
-        Vector3f    tan;
-        Vector3f    nol;
-        Vector3f    nor;
-    };
-
     struct Handle {
         GLuint      vertexBuffer;
         GLuint      indexBuffer;
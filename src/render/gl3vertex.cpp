@@ -0,0 +1,182 @@
+//-----------------------------------------------------------------------------
+// Vertex data for the OpenGL 3 renderer, which doesn't need GL to be built.
+//-----------------------------------------------------------------------------
+#include "solvespace.h"
+
+namespace SolveSpace {
+
+//-----------------------------------------------------------------------------
+// Floating point data structures
+//-----------------------------------------------------------------------------
+
+Vector2f Vector2f::From(float x, float y) {
+    return { x, y };
+}
+
+Vector2f Vector2f::From(double x, double y) {
+    return { (float)x, (float)y };
+}
+
+Vector2f Vector2f::FromInt(uint32_t x, uint32_t y) {
+    return { (float)x, (float)y };
+}
+
+Vector3f Vector3f::From(float x, float y, float z) {
+    return { x, y, z };
+}
+
+Vector3f Vector3f::From(const Vector &v) {
+    return { (float)v.x, (float)v.y, (float)v.z };
+}
+
+Vector3f Vector3f::From(const RgbaColor &c) {
+    return { c.redF(), c.greenF(), c.blueF() };
+}
+
+Vector4f Vector4f::From(float x, float y, float z, float w) {
+    return { x, y, z, w };
+}
+
+Vector4f Vector4f::From(const Vector &v, float w) {
+    return { (float)v.x, (float)v.y, (float)v.z, w };
+}
+
+Vector4f Vector4f::FromInt(uint32_t x, uint32_t y, uint32_t z, uint32_t w) {
+    return { (float)x, (float)y, (float)z, (float)w };
+}
+
+Vector4f Vector4f::From(const RgbaColor &c) {
+    return { c.redF(), c.greenF(), c.blueF(), c.alphaF() };
+}
+
+//-----------------------------------------------------------------------------
+// Edge and outline expansion
+//-----------------------------------------------------------------------------
+
+// The stipple pattern of an edge starts where the previous edge's ended, if the
+// previous edge shares an endpoint with it. The lengths and joints are found in
+// parallel; what's left is a running sum.
+template<class T>
+static void FindStrokePhases(const List<T> &l, std::vector<double> *phases,
+                             std::vector<double> *lengths) {
+    int n = l.n;
+    phases->resize(n);
+    lengths->resize(n);
+    std::vector<uint8_t> joined(n);
+
+#pragma omp parallel for
+    for(int i = 0; i < n; i++) {
+        const T &curr = l[i];
+        const T &next = l[(i + 1) % n];
+        (*lengths)[i] = curr.b.Minus(curr.a).Magnitude();
+        joined[i] = curr.a.EqualsExactly(next.a) ||
+                    curr.a.EqualsExactly(next.b) ||
+                    curr.b.EqualsExactly(next.a) ||
+                    curr.b.EqualsExactly(next.b);
+    }
+
+    double phase = 0.0;
+    for(int i = 0; i < n; i++) {
+        (*phases)[i] = phase;
+        phase = joined[i] ? phase + (*lengths)[i] : 0.0;
+    }
+}
+
+// The start cap, the body and the end cap of an edge, as two triangles each.
+static void MakeStrokeIndices(uint32_t *indices, uint32_t v) {
+    const uint32_t pattern[18] = {
+        0, 1, 2, 1, 2, 3,
+        2, 3, 4, 2, 4, 5,
+        4, 5, 6, 5, 6, 7,
+    };
+    for(int i = 0; i < 18; i++) {
+        indices[i] = v + pattern[i];
+    }
+}
+
+void MakeEdgeVertices(const SEdgeList &edges,
+                      std::vector<EdgeVertex> *vertices, std::vector<uint32_t> *indices) {
+    std::vector<double> phases, lengths;
+    FindStrokePhases(edges.l, &phases, &lengths);
+
+    int n = edges.l.n;
+    vertices->resize((size_t)n * 8);
+    indices->resize((size_t)n * 18);
+
+#pragma omp parallel for
+    for(int i = 0; i < n; i++) {
+        const SEdge &curr = edges.l[i];
+        EdgeVertex *v = &(*vertices)[(size_t)i * 8];
+        MakeStrokeIndices(&(*indices)[(size_t)i * 18], (uint32_t)i * 8);
+
+        Vector3f a   = Vector3f::From(curr.a);
+        Vector3f b   = Vector3f::From(curr.b);
+        Vector3f tan = Vector3f::From(curr.b.Minus(curr.a));
+        float phaseA = float(phases[i]),
+              phaseB = float(phases[i] + lengths[i]);
+
+        for(int j = 0; j < 8; j++) {
+            v[j].pos = (j < 4) ? a : b;
+            v[j].tan = tan;
+        }
+
+        // start cap
+        v[0].loc = Vector3f::From(-1.0f, -1.0f, phaseA);
+        v[1].loc = Vector3f::From(-1.0f, +1.0f, phaseA);
+        // body
+        v[2].loc = Vector3f::From( 0.0f, -1.0f, phaseA);
+        v[3].loc = Vector3f::From( 0.0f, +1.0f, phaseA);
+        v[4].loc = Vector3f::From( 0.0f, +1.0f, phaseB);
+        v[5].loc = Vector3f::From( 0.0f, -1.0f, phaseB);
+        // end cap
+        v[6].loc = Vector3f::From(+1.0f, +1.0f, phaseB);
+        v[7].loc = Vector3f::From(+1.0f, -1.0f, phaseB);
+    }
+}
+
+void MakeOutlineVertices(const SOutlineList &outlines,
+                         std::vector<OutlineVertex> *vertices, std::vector<uint32_t> *indices) {
+    std::vector<double> phases, lengths;
+    FindStrokePhases(outlines.l, &phases, &lengths);
+
+    int n = outlines.l.n;
+    vertices->resize((size_t)n * 8);
+    indices->resize((size_t)n * 18);
+
+#pragma omp parallel for
+    for(int i = 0; i < n; i++) {
+        const SOutline &curr = outlines.l[i];
+        OutlineVertex *v = &(*vertices)[(size_t)i * 8];
+        MakeStrokeIndices(&(*indices)[(size_t)i * 18], (uint32_t)i * 8);
+
+        Vector3f a   = Vector3f::From(curr.a);
+        Vector3f b   = Vector3f::From(curr.b);
+        Vector3f nl  = Vector3f::From(curr.nl);
+        Vector3f nr  = Vector3f::From(curr.nr);
+        Vector3f tan = Vector3f::From(curr.b.Minus(curr.a));
+        float phaseA = float(phases[i]),
+              phaseB = float(phases[i] + lengths[i]),
+              tag    = (float)curr.tag;
+
+        for(int j = 0; j < 8; j++) {
+            v[j].pos = (j < 4) ? a : b;
+            v[j].nol = nl;
+            v[j].nor = nr;
+            v[j].tan = tan;
+        }
+
+        // start cap
+        v[0].loc = Vector4f::From(-1.0f, -1.0f, phaseA, tag);
+        v[1].loc = Vector4f::From(-1.0f, +1.0f, phaseA, tag);
+        // body
+        v[2].loc = Vector4f::From( 0.0f, -1.0f, phaseA, tag);
+        v[3].loc = Vector4f::From( 0.0f, +1.0f, phaseA, tag);
+        v[4].loc = Vector4f::From( 0.0f, +1.0f, phaseB, tag);
+        v[5].loc = Vector4f::From( 0.0f, -1.0f, phaseB, tag);
+        // end cap
+        v[6].loc = Vector4f::From(+1.0f, +1.0f, phaseB, tag);
+        v[7].loc = Vector4f::From(+1.0f, -1.0f, phaseB, tag);
+    }
+}
+
+}
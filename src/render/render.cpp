@@ -222,6 +222,38 @@ std::shared_ptr<BatchCanvas> Canvas::CreateBatch() {
     return std::shared_ptr<BatchCanvas>();
 }
 
+Vector Canvas::Placement::Transform(const Vector &p) const {
+    return q.Rotate(p).Plus(offset);
+}
+
+Vector Canvas::Placement::TransformNormal(const Vector &n) const {
+    return q.Rotate(n);
+}
+
+//-----------------------------------------------------------------------------
+// Draw the same mesh once at each placement. Canvases that can't reuse one
+// copy of the mesh for every instance just get the transformed copies.
+//-----------------------------------------------------------------------------
+void Canvas::DrawMeshInstances(const SMesh &m, const std::vector<Placement> &placements,
+                               hFill hcfFront, hFill hcfBack) {
+    SMesh instance = {};
+    for(const Placement &p : placements) {
+        instance.l.ReserveMore(m.l.n);
+        for(const STriangle &tr : m.l) {
+            STriangle tt = tr;
+            tt.a  = p.Transform(tr.a);
+            tt.b  = p.Transform(tr.b);
+            tt.c  = p.Transform(tr.c);
+            tt.an = p.TransformNormal(tr.an);
+            tt.bn = p.TransformNormal(tr.bn);
+            tt.cn = p.TransformNormal(tr.cn);
+            instance.AddTriangle(&tt);
+        }
+        DrawMesh(instance, hcfFront, hcfBack);
+        instance.Clear();
+    }
+}
+
 //-----------------------------------------------------------------------------
 // An interface for view-independent visualization
 //-----------------------------------------------------------------------------
@@ -353,6 +385,16 @@ void ObjectPicker::DoCompare(double depth, double distance, int zIndex, int comp
     }
 }
 
+void ObjectPicker::DoExtents(const Vector &p, double r) {
+    if(!hasExtents) {
+        extents       = BBox::From(p, p);
+        extentsMargin = 0.0;
+        hasExtents    = true;
+    }
+    extents.Include(p);
+    extentsMargin = std::max(extentsMargin, r);
+}
+
 void ObjectPicker::DoQuad(const Vector &a, const Vector &b, const Vector &c, const Vector &d,
                           int zIndex, int comparePosition) {
     Point2d corners[4] = {
@@ -361,6 +403,10 @@ void ObjectPicker::DoQuad(const Vector &a, const Vector &b, const Vector &c, con
         camera.ProjectPoint(c),
         camera.ProjectPoint(d)
     };
+    DoExtents(a, 0.0);
+    DoExtents(b, 0.0);
+    DoExtents(c, 0.0);
+    DoExtents(d, 0.0);
     double minNegative = VERY_NEGATIVE,
            maxPositive = VERY_POSITIVE;
     for(int i = 0; i < 4; i++) {
@@ -386,6 +432,8 @@ void ObjectPicker::DrawLine(const Vector &a, const Vector &b, hStroke hcs) {
     Point2d bp = camera.ProjectPoint(b);
     double distance = point.DistanceToLine(ap, bp.Minus(ap), /*asSegment=*/true);
     double depth = 0.5 * (camera.ProjectPoint3(a).z + camera.ProjectPoint3(b).z) ;
+    DoExtents(a, stroke->width / 2.0);
+    DoExtents(b, stroke->width / 2.0);
     DoCompare(depth, distance - stroke->width / 2.0, stroke->zIndex);
 }
 
@@ -396,6 +444,8 @@ void ObjectPicker::DrawEdges(const SEdgeList &el, hStroke hcs) {
         Point2d bp = camera.ProjectPoint(e.b);
         double distance = point.DistanceToLine(ap, bp.Minus(ap), /*asSegment=*/true);
         double depth = 0.5 * (camera.ProjectPoint3(e.a).z + camera.ProjectPoint3(e.b).z) ;
+        DoExtents(e.a, stroke->width / 2.0);
+        DoExtents(e.b, stroke->width / 2.0);
         DoCompare(depth, distance - stroke->width / 2.0, stroke->zIndex, e.auxB);
     }
 }
@@ -425,8 +475,10 @@ void ObjectPicker::DrawQuad(const Vector &a, const Vector &b, const Vector &c, c
 
 void ObjectPicker::DrawPoint(const Vector &o, Canvas::hStroke hcs) {
     Stroke *stroke = strokes.FindById(hcs);
-    double distance = point.DistanceTo(camera.ProjectPoint(o)) - stroke->width / 2;
+    Point2d op = camera.ProjectPoint(o);
+    double distance = point.DistanceTo(op) - stroke->width / 2;
     double depth = camera.ProjectPoint3(o).z;
+    DoExtents(o, stroke->width / 2);
     DoCompare(depth, distance, stroke->zIndex);
 }
 
@@ -452,6 +504,7 @@ bool ObjectPicker::Pick(const std::function<void()> &drawFn) {
     minDepth = VERY_POSITIVE;
     minDistance = VERY_POSITIVE;
     maxZIndex = INT_MIN;
+    hasExtents = false;
 
     drawFn();
     return minDistance < selRadius;
@@ -137,6 +137,17 @@ public:
         bool Equals(const Fill &other) const;
     };
 
+    // A rigid placement of one instance of a mesh: rotated by q, and then
+    // translated by offset.
+    class Placement {
+    public:
+        Vector          offset;
+        Quaternion      q;
+
+        Vector Transform(const Vector &p) const;
+        Vector TransformNormal(const Vector &n) const;
+    };
+
     IdList<Stroke, hStroke> strokes = {};
     IdList<Fill,   hFill>   fills   = {};
     BitmapFont bitmapFont = {};
@@ -164,6 +175,8 @@ public:
     virtual void DrawPolygon(const SPolygon &p, hFill hcf) = 0;
     virtual void DrawMesh(const SMesh &m, hFill hcfFront, hFill hcfBack = {}) = 0;
     virtual void DrawFaces(const SMesh &m, const std::vector<uint32_t> &faces, hFill hcf) = 0;
+    virtual void DrawMeshInstances(const SMesh &m, const std::vector<Placement> &placements,
+                                   hFill hcfFront, hFill hcfBack = {});
 
     virtual void DrawPixmap(std::shared_ptr<const Pixmap> pm,
                             const Vector &o, const Vector &u, const Vector &v,
@@ -235,6 +248,11 @@ public:
     double      minDepth    = 1e10;
     int         maxZIndex   = 0;
     uint32_t    position    = 0;
+    // Model-space extents of everything drawn during the last pick, and the
+    // widest stroke in pixels that was drawn around them.
+    BBox        extents       = {};
+    double      extentsMargin = 0.0;
+    bool        hasExtents    = false;
 
     const Camera &GetCamera() const override { return camera; }
 
@@ -259,6 +277,7 @@ public:
     void InvalidatePixmap(std::shared_ptr<const Pixmap> pm) override {}
 
     void DoCompare(double depth, double distance, int zIndex, int comparePosition = 0);
+    void DoExtents(const Vector &p, double r);
     void DoQuad(const Vector &a, const Vector &b, const Vector &c, const Vector &d,
                 int zIndex, int comparePosition = 0);
 
@@ -315,6 +334,7 @@ public:
     void CullOccludedStrokes();
 
     // Renderer operations.
+    std::vector<std::pair<Layer, int>> PaintOrder();
     void OutputInPaintOrder();
 
     virtual bool CanOutputCurves() const = 0;
@@ -376,6 +396,88 @@ public:
     std::shared_ptr<Pixmap> ReadFrame() override;
 };
 
+// A renderer that rasterizes onto a pixmap on the CPU. Instead of sorting the mesh in paint
+// order and testing every stroke against it for occlusion, it keeps a depth buffer; the screen
+// is split in tiles, which are rasterized in parallel.
+class RasterRenderer final : public SurfaceRenderer {
+public:
+    std::shared_ptr<Pixmap>  pixmap;
+
+    void Init();
+
+    void StartFrame() override {}
+    void FlushFrame() override;
+    void FinishFrame() override {}
+    std::shared_ptr<Pixmap> ReadFrame() override;
+
+    void GetIdent(const char **vendor, const char **renderer, const char **version) override;
+
+    // Everything is rasterized directly in FlushFrame, rather than output in paint order.
+    bool CanOutputCurves() const override { return false; }
+    bool CanOutputTriangles() const override { return true; }
+
+    void OutputStart() override {}
+    void OutputBezier(const SBezier &b, hStroke hcs) override {}
+    void OutputTriangle(const STriangle &tr) override {}
+    void OutputEnd() override {}
+};
+
+//-----------------------------------------------------------------------------
+// Vertex data for the OpenGL 3 renderer; the layout of these must match shaders
+//-----------------------------------------------------------------------------
+
+class Vector2f {
+public:
+    float x, y;
+
+    static Vector2f From(float x, float y);
+    static Vector2f From(double x, double y);
+    static Vector2f FromInt(uint32_t x, uint32_t y);
+};
+
+class Vector3f {
+public:
+    float x, y, z;
+
+    static Vector3f From(float x, float y, float z);
+    static Vector3f From(const Vector &v);
+    static Vector3f From(const RgbaColor &c);
+};
+
+class Vector4f {
+public:
+    float x, y, z, w;
+
+    static Vector4f From(float x, float y, float z, float w);
+    static Vector4f From(const Vector &v, float w);
+    static Vector4f FromInt(uint32_t x, uint32_t y, uint32_t z, uint32_t w);
+    static Vector4f From(const RgbaColor &c);
+};
+
+// The edges and outlines are expanded into quads with round caps in the vertex shader,
+// eight vertices per edge; the stipple phase is continued along chains of edges that share
+// endpoints. This needs no GL, and the edges are expanded in parallel.
+class EdgeVertex {
+public:
+    Vector3f    pos;
+    Vector3f    loc;
+    Vector3f    tan;
+};
+
+class OutlineVertex {
+public:
+    Vector3f    pos;
+    Vector4f    loc;
+    Vector3f    tan;
+    Vector3f    nol;
+    Vector3f    nor;
+};
+
+void MakeEdgeVertices(const SEdgeList &edges,
+                      std::vector<EdgeVertex> *vertices, std::vector<uint32_t> *indices);
+void MakeOutlineVertices(const SOutlineList &outlines,
+                         std::vector<OutlineVertex> *vertices, std::vector<uint32_t> *indices);
+
 //-----------------------------------------------------------------------------
 // Factories
 //-----------------------------------------------------------------------------
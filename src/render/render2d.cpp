@@ -170,21 +170,16 @@ void SurfaceRenderer::DrawFaces(const SMesh &m, const std::vector<uint32_t> &fac
     Vector zOffset = {};
     zOffset.z += camera.scale * fill->zIndex;
 
-    size_t facesSize = faces.size();
-    for(STriangle tr : m.l) {
-        uint32_t face = tr.meta.face;
-        for(size_t j = 0; j < facesSize; j++) {
-            if(faces[j] != face) continue;
-            if(!fill->color.IsEmpty()) {
-                tr.meta.color = fill->color;
-            }
-            mesh.AddTriangle(tr.meta,
-                ProjectPoint3RH(camera, tr.a).Plus(zOffset),
-                ProjectPoint3RH(camera, tr.b).Plus(zOffset),
-                ProjectPoint3RH(camera, tr.c).Plus(zOffset));
-            break;
+    m.ForEachTriangleOf(faces, [&](const STriangle &tr) {
+        STriMeta meta = tr.meta;
+        if(!fill->color.IsEmpty()) {
+            meta.color = fill->color;
         }
-    }
+        mesh.AddTriangle(meta,
+            ProjectPoint3RH(camera, tr.a).Plus(zOffset),
+            ProjectPoint3RH(camera, tr.b).Plus(zOffset),
+            ProjectPoint3RH(camera, tr.c).Plus(zOffset));
+    });
 }
 
 void SurfaceRenderer::DrawPixmap(std::shared_ptr<const Pixmap> pm,
@@ -301,7 +296,7 @@ void SurfaceRenderer::CullOccludedStrokes() {
     }
 }
 
-void SurfaceRenderer::OutputInPaintOrder() {
+std::vector<std::pair<Canvas::Layer, int>> SurfaceRenderer::PaintOrder() {
     // Sort our strokes in paint order.
     std::vector<std::pair<Layer, int>> paintOrder;
     paintOrder.emplace_back(Layer::NORMAL, 0); // mesh
@@ -332,6 +327,11 @@ void SurfaceRenderer::OutputInPaintOrder() {
 
     auto last = std::unique(paintOrder.begin(), paintOrder.end());
     paintOrder.erase(last, paintOrder.end());
+    return paintOrder;
+}
+
+void SurfaceRenderer::OutputInPaintOrder() {
+    std::vector<std::pair<Layer, int>> paintOrder = PaintOrder();
 
     // Output geometry in paint order.
     OutputStart();
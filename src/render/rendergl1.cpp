@@ -661,17 +661,11 @@ void OpenGl1Renderer::DrawMesh(const SMesh &m, hFill hcfFront, hFill hcfBack) {
 void OpenGl1Renderer::DrawFaces(const SMesh &m, const std::vector<uint32_t> &faces, hFill hcf) {
     SelectFill(hcf);
     SelectPrimitive(GL_TRIANGLES);
-    size_t facesSize = faces.size();
-    for(const STriangle &tr : m.l) {
-        uint32_t face = tr.meta.face;
-        for(size_t j = 0; j < facesSize; j++) {
-            if(faces[j] != face) continue;
-            ssglVertex3v(tr.a);
-            ssglVertex3v(tr.b);
-            ssglVertex3v(tr.c);
-            break;
-        }
-    }
+    m.ForEachTriangleOf(faces, [&](const STriangle &tr) {
+        ssglVertex3v(tr.a);
+        ssglVertex3v(tr.b);
+        ssglVertex3v(tr.c);
+    });
 }
 
 void OpenGl1Renderer::DrawPixmap(std::shared_ptr<const Pixmap> pm,
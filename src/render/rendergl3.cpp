@@ -79,6 +79,7 @@ public:
 
     Camera   camera;
     Lighting lighting;
+    double   modelview[16];
     // Cached OpenGL state.
     struct {
         hStroke     hcs;
@@ -529,12 +530,9 @@ void OpenGl3Renderer::DrawFaces(const SMesh &m, const std::vector<uint32_t> &fac
     Fill *fill = SelectFill(hcf);
 
     SMesh facesMesh = {};
-    for(uint32_t f : faces) {
-        for(const STriangle &t : m.l) {
-            if(f != t.meta.face) continue;
-            facesMesh.l.Add(&t);
-        }
-    }
+    m.ForEachTriangleOf(faces, [&](const STriangle &t) {
+        facesMesh.l.Add(&t);
+    });
 
     meshRenderer.UseFilled(*fill);
     meshRenderer.Draw(facesMesh);
@@ -610,7 +608,6 @@ void OpenGl3Renderer::UpdateProjection() {
         0, 0, 0,   1
     );
 
-    double modelview[16];
     MultMatrix(mat1, mat2, modelview);
 
     imeshRenderer.SetProjection(projection);
@@ -914,6 +911,89 @@ public:
     }
 };
 
+class MeshInstancesDrawCall final : public DrawCall {
+public:
+    // Key
+    Canvas::Fill                    fillFront;
+    // Data
+    MeshRenderer::Handle            handle;
+    std::vector<Canvas::Placement>  placements;
+    Canvas::Fill                    fillBack;
+    bool                            hasFillBack;
+    bool                            isShaded;
+
+    Canvas::Layer GetLayer() const override { return fillFront.layer; }
+    int GetZIndex() const override { return fillFront.zIndex; }
+
+    static std::shared_ptr<DrawCall> Create(OpenGl3Renderer *renderer, const SMesh &m,
+                                            const std::vector<Canvas::Placement> &placements,
+                                            Canvas::Fill *fillFront, Canvas::Fill *fillBack,
+                                            bool isShaded = false) {
+        MeshInstancesDrawCall *dc = new MeshInstancesDrawCall();
+        dc->fillFront       = *fillFront;
+        dc->handle          = renderer->meshRenderer.Add(m);
+        dc->placements      = placements;
+        dc->isShaded        = isShaded;
+        dc->hasFillBack     = (fillBack != NULL);
+        if(dc->hasFillBack) dc->fillBack = *fillBack;
+        return std::shared_ptr<DrawCall>(dc);
+    }
+
+    // Each instance has to look the same as the mesh would if it was drawn
+    // by itself with these fills.
+    void DrawFace(OpenGl3Renderer *renderer, GLenum cullFace, const Canvas::Fill &fill) {
+        glCullFace(cullFace);
+        ssglDepthRange(fill.layer, fill.zIndex);
+        if(fill.pattern != Canvas::FillPattern::SOLID) {
+            renderer->SelectMask(fill.pattern);
+        } else if(fill.texture) {
+            renderer->SelectTexture(fill.texture);
+        } else {
+            renderer->SelectMask(Canvas::FillPattern::SOLID);
+        }
+        if(isShaded) {
+            renderer->meshRenderer.UseShaded(renderer->lighting);
+        } else {
+            renderer->meshRenderer.UseFilled(fill);
+        }
+        renderer->meshRenderer.Draw(handle, /*useColors=*/fill.color.IsEmpty(), fill.color);
+    }
+
+    void Draw(OpenGl3Renderer *renderer) override {
+        // The vertices are uploaded once, and each instance only changes the
+        // modelview matrix; the rotation is rigid, so the normals transform
+        // the same way as the positions do.
+        glEnable(GL_CULL_FACE);
+        for(const Canvas::Placement &p : placements) {
+            Vector u = p.q.RotationU(),
+                   v = p.q.RotationV(),
+                   n = p.q.RotationN(),
+                   o = p.offset;
+            double placement[16];
+            MakeMatrix(placement,
+                u.x, v.x, n.x, o.x,
+                u.y, v.y, n.y, o.y,
+                u.z, v.z, n.z, o.z,
+                  0,   0,   0,   1
+            );
+
+            double modelview[16];
+            MultMatrix(renderer->modelview, placement, modelview);
+            renderer->meshRenderer.SetModelview(modelview);
+
+            if(hasFillBack)
+                DrawFace(renderer, GL_BACK, fillBack);
+            DrawFace(renderer, GL_FRONT, fillFront);
+        }
+        renderer->meshRenderer.SetModelview(renderer->modelview);
+        glDisable(GL_CULL_FACE);
+    }
+
+    void Remove(OpenGl3Renderer *renderer) override {
+        renderer->meshRenderer.Remove(handle);
+    }
+};
+
 struct CompareDrawCall {
     bool operator()(const std::shared_ptr<DrawCall> &a, const std::shared_ptr<DrawCall> &b) const {
         const Canvas::Layer stackup[] = {
@@ -1040,6 +1120,15 @@ public:
         ssassert(false, "Not implemented");
     }
 
+    void DrawMeshInstances(const SMesh &m, const std::vector<Placement> &placements,
+                           hFill hcfFront, hFill hcfBack = {}) override {
+        if(placements.empty()) return;
+        drawCalls.emplace(MeshInstancesDrawCall::Create(renderer, m, placements,
+                                                        fills.FindById(hcfFront),
+                                                        fills.FindByIdNoOops(hcfBack),
+                                                        /*isShaded=*/true));
+    }
+
     void DrawPixmap(std::shared_ptr<const Pixmap> pm,
                     const Vector &o, const Vector &u, const Vector &v,
                     const Point2d &ta, const Point2d &tb, hFill hcf) override {
@@ -0,0 +1,362 @@
+//-----------------------------------------------------------------------------
+// A rendering backend that rasterizes onto a pixmap on the CPU, using a depth
+// buffer, in screen tiles that are processed in parallel.
+//-----------------------------------------------------------------------------
+#include "solvespace.h"
+
+namespace SolveSpace {
+
+static const int TILE_SIZE = 64;
+
+// A triangle, set up for rasterization in pixel coordinates. A pixel is inside
+// if all three edge functions ea*x + eb*y + ec are non-negative there.
+struct RasterTriangle {
+    double      ea[3], eb[3], ec[3];
+    // The depth plane, and its steepest slope per pixel.
+    double      zx, zy, z0;
+    double      slope;
+    int         x0, y0, x1, y1;
+    // Empty if the triangle only occludes.
+    RgbaColor   color;
+};
+
+// A stroke, and the range of its segments.
+struct RasterStroke {
+    Canvas::Layer       layer;
+    RgbaColor           color;
+    double              halfWidth;
+    std::vector<double> dashes;
+    double              period;
+    uint32_t            first, last;
+};
+
+// An edge of a stroke, in pixel coordinates.
+struct RasterSegment {
+    Vector      a, b;
+    // The distance along the dash pattern at a.
+    double      phase;
+    int         x0, y0, x1, y1;
+};
+
+// Finds the pixels whose centers lie within the given bounds, if any.
+static bool PixelBounds(double minx, double miny, double maxx, double maxy,
+                        int width, int height, int *x0, int *y0, int *x1, int *y1) {
+    *x0 = max(0,          (int)ceil(minx - 0.5));
+    *y0 = max(0,          (int)ceil(miny - 0.5));
+    *x1 = min(width - 1,  (int)floor(maxx - 0.5));
+    *y1 = min(height - 1, (int)floor(maxy - 0.5));
+    return *x0 <= *x1 && *y0 <= *y1;
+}
+
+// Whether a point at the given distance along a stroke is painted. Dashes have round caps,
+// so they extend past their ends by the half width.
+static bool IsOnDash(const RasterStroke &rs, double along) {
+    if(rs.period <= 0.0) return true;
+
+    along = fmod(along, rs.period);
+    double start = 0.0;
+    for(size_t i = 0; i < rs.dashes.size(); i++) {
+        double end = start + rs.dashes[i];
+        if(i % 2 == 0) {
+            for(double shift : { -rs.period, 0.0, rs.period }) {
+                if(along + shift >= start - rs.halfWidth &&
+                   along + shift <= end + rs.halfWidth) return true;
+            }
+        }
+        start = end;
+    }
+    return false;
+}
+
+static void BlendPixel(uint8_t *p, RgbaColor c, double coverage) {
+    double a = c.alphaF() * coverage;
+    p[0] = (uint8_t)(p[0] + (c.red   - p[0]) * a + 0.5);
+    p[1] = (uint8_t)(p[1] + (c.green - p[1]) * a + 0.5);
+    p[2] = (uint8_t)(p[2] + (c.blue  - p[2]) * a + 0.5);
+    p[3] = 255;
+}
+
+void RasterRenderer::Init() {
+    Clear();
+
+    pixmap = Pixmap::Create(Pixmap::Format::RGBA, (size_t)camera.width, (size_t)camera.height);
+}
+
+void RasterRenderer::GetIdent(const char **vendor, const char **renderer, const char **version) {
+    *vendor = "SolveSpace";
+    *renderer = "Raster";
+    *version = "1.0";
+}
+
+void RasterRenderer::FlushFrame() {
+    // There is no curve primitive; strokes are rasterized from their edges.
+    ConvertBeziersToEdges();
+
+    int width  = (int)pixmap->width,
+        height = (int)pixmap->height;
+    if(width == 0 || height == 0) return;
+
+    int tilesX = (width  + TILE_SIZE - 1) / TILE_SIZE,
+        tilesY = (height + TILE_SIZE - 1) / TILE_SIZE,
+        tileCount = tilesX * tilesY;
+    auto binInto = [&](std::vector<std::vector<uint32_t>> *bins, uint32_t index,
+                       int x0, int y0, int x1, int y1) {
+        for(int ty = y0 / TILE_SIZE; ty <= y1 / TILE_SIZE; ty++) {
+            for(int tx = x0 / TILE_SIZE; tx <= x1 / TILE_SIZE; tx++) {
+                (*bins)[ty * tilesX + tx].push_back(index);
+            }
+        }
+    };
+    auto tileBounds = [&](int tile, int *x0, int *y0, int *x1, int *y1) {
+        *x0 = (tile % tilesX) * TILE_SIZE;
+        *y0 = (tile / tilesX) * TILE_SIZE;
+        *x1 = min(*x0 + TILE_SIZE, width)  - 1;
+        *y1 = min(*y0 + TILE_SIZE, height) - 1;
+    };
+
+    // The geometry was projected around the center of the screen.
+    Vector origin = Vector::From(camera.width / 2.0, camera.height / 2.0, 0.0);
+
+    // Set up the triangles, and sort them into the tiles they touch.
+    std::vector<RasterTriangle> triangles;
+    std::vector<std::vector<uint32_t>> triangleBins(tileCount);
+    triangles.reserve(mesh.l.n);
+    for(const STriangle &tr : mesh.l) {
+        Vector a = tr.a.Plus(origin),
+               b = tr.b.Plus(origin),
+               c = tr.c.Plus(origin);
+        double area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if(EXACT(area == 0.0)) continue;
+
+        RasterTriangle rt = {};
+        // Back-facing and invisible triangles are only used for occlusion.
+        if(area > 0.0) {
+            rt.color = tr.meta.color;
+        } else {
+            swap(b, c);
+            area = -area;
+        }
+        if(!PixelBounds(min(a.x, min(b.x, c.x)), min(a.y, min(b.y, c.y)),
+                        max(a.x, max(b.x, c.x)), max(a.y, max(b.y, c.y)),
+                        width, height, &rt.x0, &rt.y0, &rt.x1, &rt.y1)) continue;
+
+        const Vector *from[3] = { &b, &c, &a },
+                     *to[3]   = { &c, &a, &b };
+        for(int i = 0; i < 3; i++) {
+            rt.ea[i] = -(to[i]->y - from[i]->y);
+            rt.eb[i] =   to[i]->x - from[i]->x;
+            rt.ec[i] = (to[i]->y - from[i]->y) * from[i]->x -
+                       (to[i]->x - from[i]->x) * from[i]->y;
+        }
+        // Edge i is opposite to vertex i, so it weighs that vertex.
+        rt.zx = (rt.ea[0] * a.z + rt.ea[1] * b.z + rt.ea[2] * c.z) / area;
+        rt.zy = (rt.eb[0] * a.z + rt.eb[1] * b.z + rt.eb[2] * c.z) / area;
+        rt.z0 = (rt.ec[0] * a.z + rt.ec[1] * b.z + rt.ec[2] * c.z) / area;
+        rt.slope = max(fabs(rt.zx), fabs(rt.zy));
+
+        binInto(&triangleBins, (uint32_t)triangles.size(), rt.x0, rt.y0, rt.x1, rt.y1);
+        triangles.push_back(rt);
+    }
+
+    // Find the nearest triangle at every pixel. The inner loop is written without
+    // branches, so that the compiler evaluates the edge functions for several
+    // pixels at once.
+    std::vector<double>  depth((size_t)width * height, VERY_NEGATIVE);
+    std::vector<int32_t> nearest((size_t)width * height, -1);
+    int tile;
+#pragma omp parallel for schedule(dynamic)
+    for(tile = 0; tile < tileCount; tile++) {
+        int tx0, ty0, tx1, ty1;
+        tileBounds(tile, &tx0, &ty0, &tx1, &ty1);
+
+        for(uint32_t t : triangleBins[tile]) {
+            const RasterTriangle &rt = triangles[t];
+            int x0 = max(rt.x0, tx0), x1 = min(rt.x1, tx1),
+                y0 = max(rt.y0, ty0), y1 = min(rt.y1, ty1);
+            for(int y = y0; y <= y1; y++) {
+                double py = y + 0.5;
+                double e0 = rt.eb[0] * py + rt.ec[0],
+                       e1 = rt.eb[1] * py + rt.ec[1],
+                       e2 = rt.eb[2] * py + rt.ec[2],
+                       ez = rt.zy * py + rt.z0;
+                double  *rowDepth   = &depth[(size_t)y * width];
+                int32_t *rowNearest = &nearest[(size_t)y * width];
+                for(int x = x0; x <= x1; x++) {
+                    double px = x + 0.5;
+                    double z  = rt.zx * px + ez;
+                    bool hit = (rt.ea[0] * px + e0 >= 0.0) &
+                               (rt.ea[1] * px + e1 >= 0.0) &
+                               (rt.ea[2] * px + e2 >= 0.0) &
+                               (z > rowDepth[x]);
+                    rowDepth[x]   = hit ? z : rowDepth[x];
+                    rowNearest[x] = hit ? (int32_t)t : rowNearest[x];
+                }
+            }
+        }
+    }
+
+    // Set up the strokes in paint order, and sort their segments into the tiles they touch.
+    std::vector<std::pair<Layer, int>> paintOrder = PaintOrder();
+    std::vector<std::vector<hStroke>> strokesByStep(paintOrder.size());
+    for(auto &eit : edges) {
+        Stroke *stroke = strokes.FindById(eit.first);
+        size_t step = std::find(paintOrder.begin(), paintOrder.end(),
+                                std::make_pair(stroke->layer, stroke->zIndex)) -
+                      paintOrder.begin();
+        strokesByStep[step].push_back(eit.first);
+    }
+
+    std::vector<RasterStroke> rasterStrokes;
+    std::vector<std::vector<uint32_t>> rasterStrokesByStep(paintOrder.size());
+    std::vector<RasterSegment> segments;
+    std::vector<std::vector<uint32_t>> segmentBins(tileCount);
+    for(size_t step = 0; step < paintOrder.size(); step++) {
+        for(hStroke hcs : strokesByStep[step]) {
+            Stroke *stroke = strokes.FindById(hcs);
+
+            RasterStroke rs = {};
+            rs.layer     = stroke->layer;
+            rs.color     = stroke->color;
+            rs.halfWidth = max(0.5, stroke->WidthPx(camera) / 2.0);
+            rs.dashes    = StipplePatternDashes(stroke->stipplePattern);
+            for(double &dash : rs.dashes) {
+                dash *= stroke->StippleScalePx(camera);
+                rs.period += dash;
+            }
+            rs.first = (uint32_t)segments.size();
+
+            // The dash pattern continues across edges that are joined end to end.
+            const SEdge *prev = NULL;
+            double phase = 0.0;
+            for(const SEdge &e : edges[hcs].l) {
+                if(prev != NULL && prev->b.Equals(e.a)) {
+                    phase += prev->b.Minus(prev->a).ProjectXy().Magnitude();
+                } else {
+                    phase = 0.0;
+                }
+                prev = &e;
+
+                RasterSegment seg = {};
+                seg.a = e.a.Plus(origin);
+                seg.b = e.b.Plus(origin);
+                seg.phase = phase;
+                double r = rs.halfWidth + 1.0;
+                if(!PixelBounds(min(seg.a.x, seg.b.x) - r, min(seg.a.y, seg.b.y) - r,
+                                max(seg.a.x, seg.b.x) + r, max(seg.a.y, seg.b.y) + r,
+                                width, height, &seg.x0, &seg.y0, &seg.x1, &seg.y1)) continue;
+
+                binInto(&segmentBins, (uint32_t)segments.size(),
+                        seg.x0, seg.y0, seg.x1, seg.y1);
+                segments.push_back(seg);
+            }
+
+            rs.last = (uint32_t)segments.size();
+            rasterStrokesByStep[step].push_back((uint32_t)rasterStrokes.size());
+            rasterStrokes.push_back(rs);
+        }
+    }
+
+    // Whether a point on a stroke is in front of the nearest triangle. Edges of the mesh lie
+    // right on it, so allow for the depth varying across the pixel.
+    auto isInFront = [&](double x, double y, double z) {
+        int px = (int)floor(x), py = (int)floor(y);
+        if(px < 0 || py < 0 || px >= width || py >= height) return true;
+        size_t i = (size_t)py * width + px;
+        if(nearest[i] < 0) return true;
+        return z >= depth[i] - (1.0 + 1.5 * triangles[nearest[i]].slope);
+    };
+
+    // Now paint every tile, in paint order.
+    RgbaColor bgColor = lighting.backgroundColor;
+    std::pair<Layer, int> meshStep = std::make_pair(Layer::NORMAL, 0);
+#pragma omp parallel for schedule(dynamic)
+    for(tile = 0; tile < tileCount; tile++) {
+        int tx0, ty0, tx1, ty1;
+        tileBounds(tile, &tx0, &ty0, &tx1, &ty1);
+        auto pixelAt = [&](int x, int y) {
+            return &pixmap->data[(size_t)y * pixmap->stride + (size_t)x * 4];
+        };
+
+        for(int y = ty0; y <= ty1; y++) {
+            for(int x = tx0; x <= tx1; x++) {
+                uint8_t *p = pixelAt(x, y);
+                p[0] = bgColor.red;
+                p[1] = bgColor.green;
+                p[2] = bgColor.blue;
+                p[3] = 255;
+            }
+        }
+
+        // The coverage of a stroke is accumulated before blending it, so that pixels
+        // where its segments join aren't blended twice.
+        std::vector<double> coverage(TILE_SIZE * TILE_SIZE, 0.0);
+        const std::vector<uint32_t> &bin = segmentBins[tile];
+        size_t next = 0;
+        for(size_t step = 0; step < paintOrder.size(); step++) {
+            if(paintOrder[step] == meshStep) {
+                for(int y = ty0; y <= ty1; y++) {
+                    for(int x = tx0; x <= tx1; x++) {
+                        int32_t t = nearest[(size_t)y * width + x];
+                        if(t < 0 || triangles[t].color.IsEmpty()) continue;
+                        BlendPixel(pixelAt(x, y), triangles[t].color, 1.0);
+                    }
+                }
+            }
+
+            for(uint32_t s : rasterStrokesByStep[step]) {
+                const RasterStroke &rs = rasterStrokes[s];
+                if(next == bin.size() || bin[next] >= rs.last) continue;
+
+                for(; next < bin.size() && bin[next] < rs.last; next++) {
+                    const RasterSegment &seg = segments[bin[next]];
+                    Vector d = seg.b.Minus(seg.a);
+                    double length2 = d.x * d.x + d.y * d.y,
+                           length  = sqrt(length2);
+
+                    int x0 = max(seg.x0, tx0), x1 = min(seg.x1, tx1),
+                        y0 = max(seg.y0, ty0), y1 = min(seg.y1, ty1);
+                    for(int y = y0; y <= y1; y++) {
+                        for(int x = x0; x <= x1; x++) {
+                            double px = x + 0.5, py = y + 0.5;
+                            double t = 0.0;
+                            if(length2 > 0.0) {
+                                t = ((px - seg.a.x) * d.x + (py - seg.a.y) * d.y) / length2;
+                                t = max(0.0, min(1.0, t));
+                            }
+                            double qx = seg.a.x + d.x * t,
+                                   qy = seg.a.y + d.y * t;
+                            double c = rs.halfWidth + 0.5 - sqrt((px - qx) * (px - qx) +
+                                                                 (py - qy) * (py - qy));
+                            if(c <= 0.0) continue;
+
+                            if(!IsOnDash(rs, seg.phase + length * t)) continue;
+
+                            if(rs.layer == Layer::NORMAL || rs.layer == Layer::OCCLUDED) {
+                                bool inFront = isInFront(qx, qy, seg.a.z + d.z * t);
+                                if(inFront != (rs.layer == Layer::NORMAL)) continue;
+                            }
+
+                            double &cov = coverage[(y - ty0) * TILE_SIZE + (x - tx0)];
+                            cov = max(cov, min(1.0, c));
+                        }
+                    }
+                }
+
+                for(int y = ty0; y <= ty1; y++) {
+                    for(int x = tx0; x <= tx1; x++) {
+                        double &cov = coverage[(y - ty0) * TILE_SIZE + (x - tx0)];
+                        if(EXACT(cov == 0.0)) continue;
+                        BlendPixel(pixelAt(x, y), rs.color, cov);
+                        cov = 0.0;
+                    }
+                }
+            }
+        }
+    }
+}
+
+std::shared_ptr<Pixmap> RasterRenderer::ReadFrame() {
+    return pixmap->Copy();
+}
+
+}
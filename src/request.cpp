@@ -163,7 +163,7 @@ void Request::Generate(IdList<Entity,hEntity> *entity,
             p.param[0] = AddParam(param, h.param(16 + 3*i + 0));
             p.param[1] = AddParam(param, h.param(16 + 3*i + 1));
         }
-        entity->Add(&p);
+        entity->AddUnsorted(&p);
         e.point[i] = p.h;
         dump._Entity("  p", &p);
     }
@@ -189,7 +189,7 @@ void Request::Generate(IdList<Entity,hEntity> *entity,
         // The point determines where the normal gets displayed on-screen;
         // it's entirely cosmetic.
         n.point[0] = e.point[0];
-        entity->Add(&n);
+        entity->AddUnsorted(&n);
         e.normal = n.h;
         dump._Entity("  n", &n);
     }
@@ -201,12 +201,12 @@ void Request::Generate(IdList<Entity,hEntity> *entity,
         d.style = style;
         d.type = Entity::Type::DISTANCE;
         d.param[0] = AddParam(param, h.param(64));
-        entity->Add(&d);
+        entity->AddUnsorted(&d);
         e.distance = d.h;
         dump._Entity("  d", &d);
     }
     if(et != (Entity::Type)0) {
-        entity->Add(&e);
+        entity->AddUnsorted(&e);
         dump._Entity("  e", &e);
     }
 }
@@ -251,7 +251,7 @@ int Request::IndexOfPoint(hEntity he) const {
 hParam Request::AddParam(IdList<Param,hParam> *param, hParam hp) {
     Param pa = {};
     pa.h = hp;
-    param->Add(&pa);
+    param->AddUnsorted(&pa);
     return hp;
 }
 
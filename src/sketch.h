@@ -138,6 +138,52 @@ struct EntityKeyEqual {
 };
 typedef std::unordered_map<EntityKey, EntityId, EntityKeyHash, EntityKeyEqual> EntityMap;
 
+// The contents of a linked file. These are shared among all the groups that
+// link the same file, and never change once loaded.
+class LinkedFile {
+public:
+    // The size and a hash of the contents of the file when it was loaded.
+    uint64_t    fileSize;
+    uint64_t    fileHash;
+
+    EntityList  entity;
+    SMesh       mesh;
+    SShell      shell;
+
+    // The shell triangulated at each level of detail, and its sharp edges,
+    // in the file's own coordinates; these are made only once however many
+    // times the file is placed in an assembly, and drawn with a transform.
+    SMesh        lodMesh[SSurface::LOD_LEVELS];
+    double       lodChordTol[SSurface::LOD_LEVELS];
+    SOutlineList lodOutlines[SSurface::LOD_LEVELS];
+
+    SMesh *TriangulationForLod(int lod);
+    SOutlineList *OutlinesForLod(int lod);
+
+    ~LinkedFile();
+};
+
+// A linked file that is assembled into the model rigidly, so that it can be
+// drawn from the file's shared triangulation instead of its own copy.
+class LinkedInstance {
+public:
+    hGroup                      group;
+    std::shared_ptr<LinkedFile> file;
+    Vector                      offset;
+    Quaternion                  q;
+
+    // The range of surfaces in the running shell that came from this file.
+    int                         firstSurface;
+    int                         surfaces;
+    // The faces in the file, and the face entities they were remapped to.
+    std::map<uint32_t, uint32_t> faceRemap;
+
+    Canvas::Placement GetPlacement() const;
+    STriangle TransformTriangle(const STriangle &tr) const;
+    uint32_t FirstIntersectionWith(const Vector &rayPoint, const Vector &rayDir,
+                                   int lod, double *faceT) const;
+};
+
 // A set of requests. Every request must have an associated group.
 class Group {
 public:
@@ -235,8 +281,23 @@ public:
     SMesh           runningMesh;
 
     bool            displayDirty;
+    int             displayLod;
+    // Changes whenever the display items are regenerated with different
+    // contents; a group that only copies the previous group's shares its
+    // generation.
+    uint64_t        displayGeneration;
     SMesh           displayMesh;
     SOutlineList    displayOutlines;
+    // The running mesh, decimated for the coarser levels of detail; a
+    // decimatedLod of zero means that there's nothing cached.
+    int             decimatedLod;
+    SMesh           decimatedMesh;
+    // The linked files in the running shell that are drawn as instances, and
+    // so are left out of the displayMesh; and the displayMesh with them put
+    // back in, flattened only when something needs every triangle.
+    std::vector<LinkedInstance> runningInstances;
+    bool            flatDisplayValid;
+    SMesh           flatDisplayMesh;
 
     enum class CombineAs : uint32_t {
         UNION           = 0,
@@ -246,14 +307,13 @@ public:
     };
     CombineAs meshCombine;
 
-    bool forceToMesh;
+    // Saved as an int, so it has to be one, or saving reads past it.
+    int  forceToMesh;
 
     EntityMap remap;
 
     Platform::Path linkFile;
-    SMesh       impMesh;
-    SShell      impShell;
-    EntityList  impEntity;
+    std::shared_ptr<LinkedFile> impFile;
 
     std::string     name;
 
@@ -262,6 +322,7 @@ public:
     std::string DescriptionString() const;
     std::string Group::TypeToString() const;
     void Clear();
+    Group CopyWithoutGeneratedData() const;
 
     static void AddParam(ParamList *param, hParam hp, double v);
     void Generate(EntityList *entity, ParamList *param);
@@ -317,9 +378,15 @@ public:
     template<class T> void GenerateForStepAndRepeat(T *steps, T *outs, Group::CombineAs forWhat);
     template<class T> void GenerateForBoolean(T *a, T *b, T *o, Group::CombineAs how);
     void GenerateDisplayItems();
+    void AddRunningMeshToDisplayMesh(int lod);
+    void GenerateRunningInstances(Group *srcg, Group *prevg);
+    SMesh *GetDisplayMesh();
+    uint32_t FirstFaceIntersectionWith(Point2d mp);
 
     enum class DrawMeshAs { DEFAULT, HOVERED, SELECTED };
     void DrawMesh(DrawMeshAs how, Canvas *canvas);
+    void DrawInstanceFaces(const std::vector<uint32_t> &faces, Canvas::hFill hcf,
+                           Canvas *canvas);
     void Draw(Canvas *canvas);
     void DrawPolyError(Canvas *canvas);
     void DrawFilledPaths(Canvas *canvas);
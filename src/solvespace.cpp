@@ -207,6 +207,8 @@ bool SolveSpaceUI::Load(const Platform::Path &filename) {
 }
 
 void SolveSpaceUI::Exit() {
+    FinishBackgroundSave();
+
     Platform::SettingsRef settings = Platform::GetSettings();
 
     GW.window->FreezePosition(settings, "GraphicsWindow");
@@ -467,6 +469,8 @@ void SolveSpaceUI::AfterNewFile() {
     traced.path.l.Clear();
     // and the naked edges
     nakedEdges.Clear();
+    showingNakedEdges = false;
+    meshCheck.Clear();
 
     // Quit export mode
     justExportedInfo.draw = false;
@@ -546,12 +550,15 @@ void SolveSpaceUI::Autosave()
     ScheduleAutosave();
 
     if(!saveFile.IsEmpty() && unsaved) {
-        SaveToFile(saveFile.WithExtension(BACKUP_EXT));
+        SaveToFileInBackground(saveFile.WithExtension(BACKUP_EXT));
     }
 }
 
 void SolveSpaceUI::RemoveAutosave()
 {
+    // Or else an autosave still being written would put it back.
+    FinishBackgroundSave();
+
     Platform::Path autosaveFile = saveFile.WithExtension(BACKUP_EXT);
     RemoveFile(autosaveFile);
 }
@@ -794,13 +801,15 @@ void SolveSpaceUI::MenuAnalyze(Command id) {
 
         case Command::NAKED_EDGES: {
             ShowNakedEdges(/*reportOnlyWhenNotOkay=*/false);
+            SS.showingNakedEdges = true;
             break;
         }
 
         case Command::INTERFERENCE: {
             SS.nakedEdges.Clear();
+            SS.showingNakedEdges = false;
 
-            SMesh *m = &(SK.GetGroup(SS.GW.activeGroup)->displayMesh);
+            SMesh *m = SK.GetGroup(SS.GW.activeGroup)->GetDisplayMesh();
             SKdNode *root = SKdNode::From(m);
             bool inters, leaks;
             root->MakeCertainEdgesInto(&(SS.nakedEdges),
@@ -826,7 +835,7 @@ void SolveSpaceUI::MenuAnalyze(Command id) {
 
         case Command::VOLUME: {
             Group *g = SK.GetGroup(SS.GW.activeGroup);
-            double totalVol = g->displayMesh.CalculateVolume();
+            double totalVol = g->GetDisplayMesh()->CalculateVolume();
             std::string msg = ssprintf(
                 _("The volume of the solid model is:\n\n"
                   "    %s"),
@@ -856,7 +865,7 @@ void SolveSpaceUI::MenuAnalyze(Command id) {
                 std::vector<uint32_t> faces;
                 faces.push_back(gs.face[0].v);
                 if(gs.faces > 1) faces.push_back(gs.face[1].v);
-                double area = g->displayMesh.CalculateSurfaceArea(faces);
+                double area = g->GetDisplayMesh()->CalculateSurfaceArea(faces);
                 Message(_("The surface area of the selected faces is:\n\n"
                           "    %s\n\n"
                           "Curves have been approximated as piecewise linear.\n"
@@ -957,19 +966,51 @@ void SolveSpaceUI::MenuAnalyze(Command id) {
             break;
         }
 
+        case Command::SHOW_TIMINGS:
+            // Each time they're shown, the timings are recorded afresh.
+            SS.GW.showTimings = !SS.GW.showTimings;
+            if(SS.GW.showTimings) Profile::Clear();
+            Profile::SetEnabled(SS.GW.showTimings);
+            SS.GW.EnsureValidActives();
+            SS.GW.Invalidate();
+            break;
+
+        case Command::EXPORT_TRACE: {
+            if(!SS.GW.showTimings) {
+                Message(_("Timings are recorded only while they're shown. Choose "
+                          "Analyze -> Show Timings, then do whatever is slow, and "
+                          "export the trace after that."));
+                break;
+            }
+            Platform::FileDialogRef dialog = Platform::CreateSaveFileDialog(SS.GW.window);
+            dialog->AddFilters(Platform::TraceFileFilters);
+            dialog->ThawChoices(settings, "Timings");
+            dialog->SuggestFilename(SS.saveFile);
+            if(dialog->RunModal()) {
+                dialog->FreezeChoices(settings, "Timings");
+                if(!Profile::WriteTrace(dialog->GetFilename())) {
+                    Error(_("Couldn't write to '%s'"), dialog->GetFilename().raw.c_str());
+                }
+            }
+            break;
+        }
+
         default: ssassert(false, "Unexpected menu ID");
     }
 }
 
+void SolveSpaceUI::CheckNakedEdges(bool *inters, bool *leaks) {
+    SMesh *m = SK.GetGroup(SS.GW.activeGroup)->GetDisplayMesh();
+    SS.meshCheck.Check(m, /*coplanarIsInter=*/true, &(SS.nakedEdges), inters, leaks);
+}
+
 void SolveSpaceUI::ShowNakedEdges(bool reportOnlyWhenNotOkay) {
     SS.nakedEdges.Clear();
 
     Group *g = SK.GetGroup(SS.GW.activeGroup);
-    SMesh *m = &(g->displayMesh);
-    SKdNode *root = SKdNode::From(m);
+    SMesh *m = g->GetDisplayMesh();
     bool inters, leaks;
-    root->MakeCertainEdgesInto(&(SS.nakedEdges),
-        EdgeKind::NAKED_OR_SELF_INTER, /*coplanarIsInter=*/true, &inters, &leaks);
+    CheckNakedEdges(&inters, &leaks);
 
     if(reportOnlyWhenNotOkay && !inters && !leaks && SS.nakedEdges.l.IsEmpty()) {
         return;
@@ -985,7 +1026,7 @@ void SolveSpaceUI::ShowNakedEdges(bool reportOnlyWhenNotOkay) {
 
     std::string cntMsg = ssprintf(
         _("\n\nThe model contains %d triangles, from %d surfaces."),
-        g->displayMesh.l.n, g->runningShell.surface.n);
+        m->l.n, g->runningShell.surface.n);
 
     if(SS.nakedEdges.l.IsEmpty()) {
         Message(_("%s\n\n%s\n\nZero problematic edges, good.%s"),
@@ -1025,10 +1066,8 @@ PACKAGE_VERSION, 2021);
 
 void SolveSpaceUI::Clear() {
     sys.Clear();
-    for(int i = 0; i < MAX_UNDO; i++) {
-        if(i < undo.cnt) undo.d[i].Clear();
-        if(i < redo.cnt) redo.d[i].Clear();
-    }
+    UndoClearStack(&undo);
+    UndoClearStack(&redo);
     TW.window = NULL;
     GW.openRecentMenu = NULL;
     GW.linkRecentMenu = NULL;
@@ -1038,6 +1077,7 @@ void SolveSpaceUI::Clear() {
     GW.showToolbarMenuItem = NULL;
     GW.showTextWndMenuItem = NULL;
     GW.fullScreenMenuItem = NULL;
+    GW.showTimingsMenuItem = NULL;
     GW.unitsMmMenuItem = NULL;
     GW.unitsMetersMenuItem = NULL;
     GW.unitsInchesMenuItem = NULL;
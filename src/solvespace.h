@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <chrono>
 #include <functional>
+#include <future>
 #include <locale>
 #include <map>
 #include <memory>
@@ -125,9 +126,11 @@ static constexpr double VERY_NEGATIVE = -1e10;
 #include "platform/platform.h"
 #include "platform/gui.h"
 #include "resource.h"
+#include "profile.h"
 
 using Platform::AllocTemporary;
 using Platform::FreeAllTemporary;
+using Platform::TemporaryArena;
 
 class Expr;
 class ExprVector;
@@ -153,6 +156,7 @@ class SSurface;
 
 class Entity;
 class hEntity;
+class SlvsLineReader;
 class Param;
 class hParam;
 typedef IdList<Entity,hEntity> EntityList;
@@ -235,6 +239,10 @@ public:
 
         // The corresponding parameter for each column
         hParam      param[MAX_UNKNOWNS];
+        // and its value; the expressions in A.sym and B.sym read these
+        // directly, and NewtonSolve steps them, writing them back to the
+        // params only once it's done.
+        double      val[MAX_UNKNOWNS];
 
         // We're solving AX = B
         int m, n;
@@ -470,6 +478,63 @@ public:
     bool CanOutputMesh() const override { return false; }
 };
 
+// Triangle mesh output, for the formats that can be written one triangle at
+// a time; the output goes through our own buffer, and the whole mesh never
+// needs to be in memory at once.
+class MeshFileWriter {
+public:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    FILE *f;
+    Platform::Path filename;
+    uint32_t triangleCount;
+    std::vector<char> buffer;
+
+    static MeshFileWriter *ForFile(const Platform::Path &filename);
+
+    void OutputShell(SShell *sh);
+    void OutputMesh(SMesh *sm);
+
+    void Write(const void *data, size_t size);
+    void Printf(const char *fmt, ...);
+    void Flush();
+
+    virtual bool StartFile() = 0;
+    virtual void Triangle(const STriangle &tr) = 0;
+    virtual void FinishAndCloseFile() = 0;
+};
+class StlFileWriter : public MeshFileWriter {
+public:
+    bool StartFile() override;
+    void Triangle(const STriangle &tr) override;
+    void FinishAndCloseFile() override;
+};
+class ObjFileWriter : public MeshFileWriter {
+public:
+    FILE *fMtl;
+    std::unordered_map<Vector, uint32_t, VectorHash, VectorPred> vertices;
+    std::unordered_map<Vector, uint32_t, VectorHash, VectorPred> normals;
+    std::map<RgbaColor, std::string, RgbaColorCompare> colors;
+    RgbaColor currentColor;
+
+    uint32_t IndexOf(std::unordered_map<Vector, uint32_t, VectorHash, VectorPred> *indices,
+                     const char *keyword, Vector v);
+
+    bool StartFile() override;
+    void Triangle(const STriangle &tr) override;
+    void FinishAndCloseFile() override;
+};
+class PlyFileWriter : public MeshFileWriter {
+public:
+    FILE *fFaces;
+    std::unordered_map<Vector, uint32_t, VectorHash, VectorPred> vertices;
+    long vertexCountAt, faceCountAt;
+
+    bool StartFile() override;
+    void Triangle(const STriangle &tr) override;
+    void FinishAndCloseFile() override;
+};
+
 #ifdef LIBRARY
 #   define ENTITY EntityBase
 #   define CONSTRAINT ConstraintBase
@@ -512,7 +577,9 @@ public:
     TextWindow                 &TW;
     GraphicsWindow              GW;
 
-    // The state for undo/redo
+    // The state for undo/redo. Only the newest state on each stack is kept
+    // in full; every older one is kept as the elements that have to be put
+    // back, or removed, to turn the state pushed after it into that one.
     typedef struct UndoState {
         IdList<Group,hGroup>            group;
         List<hGroup>                    groupOrder;
@@ -524,15 +591,45 @@ public:
 
         void Clear() {
             group.Clear();
+            groupOrder.Clear();
             request.Clear();
             constraint.Clear();
             param.Clear();
             style.Clear();
         }
     } UndoState;
+    template<class T, class H>
+    struct UndoChanges {
+        IdList<T,H>                     restore;
+        List<H>                         remove;
+
+        void Clear() {
+            restore.Clear();
+            remove.Clear();
+        }
+    };
+    typedef struct UndoDelta {
+        UndoChanges<Group,hGroup>           group;
+        List<hGroup>                        groupOrder;
+        UndoChanges<Request,hRequest>       request;
+        UndoChanges<Constraint,hConstraint> constraint;
+        UndoChanges<Param,hParam>           param;
+        UndoChanges<Style,hStyle>           style;
+        hGroup                              activeGroup;
+
+        void Clear() {
+            group.Clear();
+            groupOrder.Clear();
+            request.Clear();
+            constraint.Clear();
+            param.Clear();
+            style.Clear();
+        }
+    } UndoDelta;
     enum { MAX_UNDO = 100 };
     typedef struct {
-        UndoState   d[MAX_UNDO];
+        UndoState   top;
+        UndoDelta   d[MAX_UNDO];
         int         cnt;
         int         write;
     } UndoStack;
@@ -543,13 +640,16 @@ public:
     bool ReloadLinkedImage(const Platform::Path &saveFile, Platform::Path *filename,
                            bool canCancel);
 
+    // Every linked file that some group still refers to, by absolute path.
+    std::map<Platform::Path, std::weak_ptr<LinkedFile>, Platform::PathLess> linkedFiles;
+    std::shared_ptr<LinkedFile> FindLinkedFile(const Platform::Path &filename);
+
     void UndoEnableMenus();
     void UndoRemember();
     void UndoUndo();
     void UndoRedo();
     void PushFromCurrentOnto(UndoStack *uk);
     void PopOntoCurrentFrom(UndoStack *uk);
-    void UndoClearState(UndoState *ut);
     void UndoClearStack(UndoStack *uk);
 
     // Little bits of extra configuration state
@@ -649,8 +749,10 @@ public:
         void       *ptr;
     } SaveTable;
     static const SaveTable SAVED[];
-    void SaveUsingTable(const Platform::Path &filename, int type);
-    void LoadUsingTable(const Platform::Path &filename, char *key, char *val);
+    static void SaveUsingTable(FILE *fh, const Platform::Path &filename, int type,
+                               const void *elem);
+    void LoadUsingTable(const Platform::Path &filename, char *key, char *val,
+                        SlvsLineReader *lines);
     struct {
         Group        g;
         Request      r;
@@ -665,6 +767,7 @@ public:
     static constexpr size_t MAX_RECENT = 8;
     static constexpr const char *SKETCH_EXT = "slvs";
     static constexpr const char *BACKUP_EXT = "slvs~";
+    static constexpr const char *CACHE_EXT  = "slvsb";
     std::vector<Platform::Path> recentFiles;
     bool Load(const Platform::Path &filename);
     bool GetFilenameAndSave(bool saveAs);
@@ -674,8 +777,22 @@ public:
     void ClearExisting();
     void NewFile();
     bool SaveToFile(const Platform::Path &filename);
+    // A copy of everything that goes into a saved file, so that it can be
+    // written out on another thread while the sketch goes on changing.
+    class SaveSnapshot;
+    std::shared_ptr<SaveSnapshot> TakeSaveSnapshot(const Platform::Path &filename);
+    static bool WriteSaveSnapshot(SaveSnapshot *snapshot, const Platform::Path &filename);
+    std::future<bool> backgroundSave;
+    Platform::Path    backgroundSaveFile;
+    void SaveToFileInBackground(const Platform::Path &filename);
+    void FinishBackgroundSave();
     bool LoadAutosaveFor(const Platform::Path &filename);
     bool LoadFromFile(const Platform::Path &filename, bool canCancel = false);
+    bool SaveToBinaryCache(const Platform::Path &filename,
+                           const Platform::Path &source = Platform::Path());
+    bool LoadFromBinaryCache(const Platform::Path &filename, const Platform::Path &source,
+                             const std::function<void(char)> &addRecord,
+                             SMesh *m, SShell *sh);
     void UpgradeLegacyData();
     bool LoadEntitiesFromFile(const Platform::Path &filename, EntityList *le,
                               SMesh *m, SShell *sh);
@@ -685,8 +802,6 @@ public:
     // And the various export options
     void ExportAsPngTo(const Platform::Path &filename);
     void ExportMeshTo(const Platform::Path &filename);
-    void ExportMeshAsStlTo(FILE *f, SMesh *sm);
-    void ExportMeshAsObjTo(FILE *fObj, FILE *fMtl, SMesh *sm);
     void ExportMeshAsThreeJsTo(FILE *f, const Platform::Path &filename,
                                SMesh *sm, SOutlineList *sol);
     void ExportMeshAsVrmlTo(FILE *f, const Platform::Path &filename, SMesh *sm);
@@ -708,6 +823,10 @@ public:
         hEntity     point;
     } traced;
     SEdgeList nakedEdges;
+    // While the naked edges are shown, they're found again after every
+    // regeneration; the check remembers the mesh, so that's incremental.
+    bool       showingNakedEdges;
+    SMeshCheck meshCheck;
     struct {
         bool        draw;
         Vector      ptA;
@@ -753,12 +872,14 @@ public:
     bool PruneRequests(hGroup hg);
     bool PruneConstraints(hGroup hg);
     static void ShowNakedEdges(bool reportOnlyWhenNotOkay);
+    static void CheckNakedEdges(bool *inters, bool *leaks);
 
     enum class Generate : uint32_t {
         DIRTY,
         ALL,
         REGEN,
         UNTIL_ACTIVE,
+        DIRTY_ALL,
     };
 
     void GenerateAll(Generate type = Generate::DIRTY, bool andFindFree = false,
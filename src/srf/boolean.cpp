@@ -202,8 +202,10 @@ SCurve SCurve::MakeCopySplitAgainst(SShell *agnstA, SShell *agnstB,
 }
 
 void SShell::CopyCurvesSplitAgainst(bool opA, SShell *agnst, SShell *into) {
+    TemporaryArena *arena = TemporaryArena::Current();
 #pragma omp parallel for
     for(int i=0; i<curve.n; i++) {
+        TemporaryArena::Use use(arena);
         SCurve *sc = &curve[i];
         SCurve scn = sc->MakeCopySplitAgainst(agnst, NULL,
                                 surface.FindById(sc->surfA),
@@ -508,6 +510,9 @@ SSurface SSurface::MakeCopyTrimAgainst(SShell *parent,
     // The returned surface is identical, just the trim curves change
     ret = *this;
     ret.trim = {};
+    for(SMesh &m : ret.lodMesh) {
+        m = {};
+    }
 
     // First, build a list of the existing trim curves; update them to use
     // the split curves.
@@ -723,9 +728,11 @@ SSurface SSurface::MakeCopyTrimAgainst(SShell *parent,
 
 void SShell::CopySurfacesTrimAgainst(SShell *sha, SShell *shb, SShell *into, SSurface::CombineAs type) {
     std::vector <SSurface> ssn(surface.n);
+    TemporaryArena *arena = TemporaryArena::Current();
 #pragma omp parallel for
     for (int i = 0; i < surface.n; i++)
     {
+        TemporaryArena::Use use(arena);
         SSurface *ss = &surface[i];
         ssn[i] = ss->MakeCopyTrimAgainst(this, sha, shb, into, type, i);
     }
@@ -738,8 +745,10 @@ void SShell::CopySurfacesTrimAgainst(SShell *sha, SShell *shb, SShell *into, SSu
 }
 
 void SShell::MakeIntersectionCurvesAgainst(SShell *agnst, SShell *into) {
+    TemporaryArena *arena = TemporaryArena::Current();
 #pragma omp parallel for
     for(int i = 0; i< surface.n; i++) {
+        TemporaryArena::Use use(arena);
         SSurface *sa = &surface[i];
 
         for(SSurface &sb : agnst->surface){
@@ -822,51 +831,66 @@ void SShell::MakeFromAssemblyOf(SShell *a, SShell *b) {
 }
 
 void SShell::MakeFromBoolean(SShell *a, SShell *b, SSurface::CombineAs type) {
+    Profile::Scope scope("Boolean");
     dump._MakeFromBoolean("Shell.MakeFromBoolean", a, b, this, type);
     booleanFailed = false;
 
-    a->MakeClassifyingBsps(NULL);
-    b->MakeClassifyingBsps(NULL);
+    // The classifying BSPs and everything else built as a calculation aid
+    // are only needed until the result is complete. The parallel loops below
+    // have their workers allocate from it too.
+    TemporaryArena arena;
 
-    // Copy over all the original curves, splitting them so that a
-    // piecwise linear segment never crosses a surface from the other
-    // shell.
-    a->CopyCurvesSplitAgainst(/*opA=*/true,  b, this);
-    dump._Shell("Shell CopyCurvesSplitAgainst ab", this);
-    b->CopyCurvesSplitAgainst(/*opA=*/false, a, this);
-    dump._Shell("Shell CopyCurvesSplitAgainst ba", this);
+    {
+        Profile::Scope stage("Split curves");
+        a->MakeClassifyingBsps(NULL);
+        b->MakeClassifyingBsps(NULL);
+
+        // Copy over all the original curves, splitting them so that a
+        // piecwise linear segment never crosses a surface from the other
+        // shell.
+        a->CopyCurvesSplitAgainst(/*opA=*/true,  b, this);
+        dump._Shell("Shell CopyCurvesSplitAgainst ab", this);
+        b->CopyCurvesSplitAgainst(/*opA=*/false, a, this);
+        dump._Shell("Shell CopyCurvesSplitAgainst ba", this);
+    }
 
-    // Generate the intersection curves for each surface in A against all
-    // the surfaces in B (which is all of the intersection curves).
-    a->MakeIntersectionCurvesAgainst(b, this);
-    dump._Shell("Shell MakeIntersectionCurvesAgainst", this);
+    {
+        Profile::Scope stage("Intersect surfaces");
+        // Generate the intersection curves for each surface in A against all
+        // the surfaces in B (which is all of the intersection curves).
+        a->MakeIntersectionCurvesAgainst(b, this);
+        dump._Shell("Shell MakeIntersectionCurvesAgainst", this);
 
-    for(SCurve &sc : curve) {
-        SSurface *srfA = sc.GetSurfaceA(a, b),
-                 *srfB = sc.GetSurfaceB(a, b);
+        for(SCurve &sc : curve) {
+            SSurface *srfA = sc.GetSurfaceA(a, b),
+                     *srfB = sc.GetSurfaceB(a, b);
 
-        sc.RemoveShortSegments(srfA, srfB);
+            sc.RemoveShortSegments(srfA, srfB);
+        }
     }
 
-    // And clean up the piecewise linear things we made as a calculation aid
-    a->CleanupAfterBoolean();
-    dump._Shell("Shell a.CleanupAfterBoolean", a);
-    b->CleanupAfterBoolean();
-    dump._Shell("Shell b.CleanupAfterBoolean", b);
-    // Remake the classifying BSPs with the split (and short-segment-removed)
-    // curves
-    a->MakeClassifyingBsps(this);
-    b->MakeClassifyingBsps(this);
-
-    if(b->surface.IsEmpty() || a->surface.IsEmpty()) {
-        I = 1000000;
-    } else {
-        I = 0;
+    {
+        Profile::Scope stage("Trim surfaces");
+        // And clean up the piecewise linear things we made as a calculation aid
+        a->CleanupAfterBoolean();
+        dump._Shell("Shell a.CleanupAfterBoolean", a);
+        b->CleanupAfterBoolean();
+        dump._Shell("Shell b.CleanupAfterBoolean", b);
+        // Remake the classifying BSPs with the split (and short-segment-removed)
+        // curves
+        a->MakeClassifyingBsps(this);
+        b->MakeClassifyingBsps(this);
+
+        if(b->surface.IsEmpty() || a->surface.IsEmpty()) {
+            I = 1000000;
+        } else {
+            I = 0;
+        }
+        // Then trim and copy the surfaces
+        a->CopySurfacesTrimAgainst(a, b, this, type);
+        b->CopySurfacesTrimAgainst(a, b, this, type);
+        dump._Shell("  CopySurfacesTrimAgainst", this);
     }
-    // Then trim and copy the surfaces
-    a->CopySurfacesTrimAgainst(a, b, this, type);
-    b->CopySurfacesTrimAgainst(a, b, this, type);
-    dump._Shell("  CopySurfacesTrimAgainst", this);
 
     // Now that we've copied the surfaces, we know their new hSurfaces, so
     // rewrite the curves to refer to the surfaces by their handles in the
@@ -877,14 +901,24 @@ void SShell::MakeFromBoolean(SShell *a, SShell *b, SSurface::CombineAs type) {
     a->CleanupAfterBoolean();
     b->CleanupAfterBoolean();
     dump._Shell("  result", this);
+
+    // The BSPs are freed along with the arena, so don't leave them dangling.
+    for(SShell *sh : { a, b, this }) {
+        for(SSurface &srf : sh->surface) {
+            srf.bsp = NULL;
+        }
+    }
 }
 
 //-----------------------------------------------------------------------------
 // All of the BSP routines that we use to perform and accelerate polygon ops.
 //-----------------------------------------------------------------------------
 void SShell::MakeClassifyingBsps(SShell *useCurvesFrom) {
+    // The BSPs outlive the loop, so they can't go in the workers' own memory.
+    TemporaryArena *arena = TemporaryArena::Current();
  #pragma omp parallel for
     for(int i = 0; i<surface.n; i++) {
+        TemporaryArena::Use use(arena);
         surface[i].MakeClassifyingBsp(this, useCurvesFrom);
     }
 }
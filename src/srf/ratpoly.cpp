@@ -223,11 +223,32 @@ void SBezier::MakePwlInto(List<Vector> *l, double chordTol, double max_dt) const
     if((deg == 1) && (max_dt >= 1.0)) {
         l->Add(&(ctrl[1]));
     } else {
-        MakePwlInitialWorker(l, 0.0, 0.5, chordTol, max_dt);
-        MakePwlInitialWorker(l, 0.5, 1.0, chordTol, max_dt);
+        MakePwlInitialWorker(l, NULL, 0.0, 0.5, chordTol, max_dt);
+        MakePwlInitialWorker(l, NULL, 0.5, 1.0, chordTol, max_dt);
     }
 }
-void SBezier::MakePwlWorker(List<Vector> *l, double ta, double tb, double chordTol, double max_dt) const
+// The same split, but for the parameters of all the points after the first one,
+// so that it can be repeated on copies of this curve that are moved and scaled,
+// with the chord tolerance scaled the same.
+void SBezier::MakePwlParamsInto(std::vector<double> *params, double chordTol,
+                                double max_dt) const {
+    if(EXACT(chordTol == 0)) {
+        chordTol = SS.ChordTolMm();
+    }
+    if (EXACT(max_dt == 0.0)) {
+        max_dt = (deg == 1) ? 1.0 : 0.25;
+    }
+    if((deg == 1) && (max_dt >= 1.0)) {
+        params->push_back(1.0);
+    } else {
+        List<Vector> l = {};
+        MakePwlInitialWorker(&l, params, 0.0, 0.5, chordTol, max_dt);
+        MakePwlInitialWorker(&l, params, 0.5, 1.0, chordTol, max_dt);
+        l.Clear();
+    }
+}
+void SBezier::MakePwlWorker(List<Vector> *l, std::vector<double> *params,
+                            double ta, double tb, double chordTol, double max_dt) const
 {
     Vector pa = PointAt(ta);
     Vector pb = PointAt(tb);
@@ -239,13 +260,15 @@ void SBezier::MakePwlWorker(List<Vector> *l, double ta, double tb, double chordT
     if(((tb - ta) < step || d < chordTol) && ((tb-ta) <= max_dt) ) {
         // A previous call has already added the beginning of our interval.
         l->Add(&pb);
+        if(params) params->push_back(tb);
     } else {
         double tm = (ta + tb) / 2;
-        MakePwlWorker(l, ta, tm, chordTol, max_dt);
-        MakePwlWorker(l, tm, tb, chordTol, max_dt);
+        MakePwlWorker(l, params, ta, tm, chordTol, max_dt);
+        MakePwlWorker(l, params, tm, tb, chordTol, max_dt);
     }
 }
-void SBezier::MakePwlInitialWorker(List<Vector> *l, double ta, double tb, double chordTol, double max_dt) const
+void SBezier::MakePwlInitialWorker(List<Vector> *l, std::vector<double> *params,
+                                   double ta, double tb, double chordTol, double max_dt) const
 {
     Vector pa = PointAt(ta);
     Vector pb = PointAt(tb);
@@ -269,10 +292,11 @@ void SBezier::MakePwlInitialWorker(List<Vector> *l, double ta, double tb, double
     if( ((tb - ta) < step || d < chordTol) && ((tb-ta) <= max_dt) ) {
         // A previous call has already added the beginning of our interval.
         l->Add(&pb);
+        if(params) params->push_back(tb);
     } else {
         double tm = (ta + tb) / 2;
-        MakePwlWorker(l, ta, tm, chordTol, max_dt);
-        MakePwlWorker(l, tm, tb, chordTol, max_dt);
+        MakePwlWorker(l, params, ta, tm, chordTol, max_dt);
+        MakePwlWorker(l, params, tm, tb, chordTol, max_dt);
     }
 }
 
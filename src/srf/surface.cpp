@@ -412,7 +412,7 @@ void SSurface::MakeSectionEdgesInto(SShell *shell, SEdgeList *sel, SBezierList *
     }
 }
 
-void SSurface::TriangulateInto(SShell *shell, SMesh *sm) {
+void SSurface::TriangulateInto(SShell *shell, SMesh *sm, double chordTol) {
     SEdgeList el = {};
 
     MakeEdgesInto(shell, &el, MakeAs::UV);
@@ -433,7 +433,7 @@ void SSurface::TriangulateInto(SShell *shell, SMesh *sm) {
         } else {
             // A surface with compound curvature. So we must overlay a
             // two-dimensional grid, and triangulate around that.
-            poly.UvGridTriangulateInto(sm, this);
+            poly.UvGridTriangulateInto(sm, this, chordTol);
         }
 
         STriMeta meta = { face, color };
@@ -488,8 +488,27 @@ void SSurface::ScaleSelfBy(double s) {
     }
 }
 
+//-----------------------------------------------------------------------------
+// Return our triangulation at the given level of detail, reusing the cached
+// one unless the chord tolerance for that level has changed since.
+//-----------------------------------------------------------------------------
+SMesh *SSurface::TriangulationForLod(SShell *shell, int lod) {
+    ssassert(lod >= 0 && lod < LOD_LEVELS, "Unexpected level of detail");
+    double chordTol = SShell::LodChordTol(lod);
+    SMesh *m = &lodMesh[lod];
+    if(m->IsEmpty() || lodChordTol[lod] != chordTol) {
+        m->Clear();
+        TriangulateInto(shell, m, chordTol);
+        lodChordTol[lod] = chordTol;
+    }
+    return m;
+}
+
 void SSurface::Clear() {
     trim.Clear();
+    for(SMesh &m : lodMesh) {
+        m.Clear();
+    }
 }
 
 typedef struct {
@@ -771,7 +790,7 @@ void SShell::MakeFromHelicalRevolutionOf(SBezierLoopSet *sbls, Vector pt, Vector
                 double ps = 0.0;
                 t_values.Add(&ps);
                 (surface.FindById(revs[0]))->MakeTriangulationGridInto(
-                        &t_values, 0.0, 1.0, true, 0);
+                        &t_values, 0.0, 1.0, true, 0, SS.ChordTolMm());
             }
             // we generate one more curve than we did surfaces
             for(j = 0; j <= sections; j++) {
@@ -1097,18 +1116,74 @@ void SShell::MakeSectionEdgesInto(Vector n, double d, SEdgeList *sel, SBezierLis
     }
 }
 
+const double SShell::LOD_CHORD_TOL_RATIO = 4.0;
+const double SShell::LOD_MAX_PIXEL_ERROR = 1.0;
+
+double SShell::LodChordTol(int lod) {
+    return SS.ChordTolMm() * pow(LOD_CHORD_TOL_RATIO, lod);
+}
+
+//-----------------------------------------------------------------------------
+// Pick the coarsest level of detail whose chord error, at the given scale in
+// pixels per mm, is still within LOD_MAX_PIXEL_ERROR on screen.
+//-----------------------------------------------------------------------------
+int SShell::LodForScale(double scale) {
+    int lod = 0;
+    while(lod + 1 < SSurface::LOD_LEVELS &&
+          LodChordTol(lod + 1) * scale <= LOD_MAX_PIXEL_ERROR) {
+        lod++;
+    }
+    return lod;
+}
+
 void SShell::TriangulateInto(SMesh *sm) {
+    TriangulateInto(sm, SS.ChordTolMm());
+}
+
+void SShell::TriangulateInto(SMesh *sm, double chordTol) {
+    Profile::Scope scope("Triangulate");
+    // Each surface is triangulated into its own mesh, and the results are
+    // concatenated in surface order afterwards, so that the output doesn't
+    // depend on how the surfaces were scheduled across threads.
+    std::vector<SMesh> meshes(surface.n);
 #pragma omp parallel for
     for(int i=0; i<surface.n; i++) {
-        SSurface *s = &surface[i];
-        SMesh m;
-        s->TriangulateInto(this, &m);
-        #pragma omp critical
+        surface[i].TriangulateInto(this, &meshes[i], chordTol);
+    }
+
+    int n = 0;
+    for(const SMesh &m : meshes) {
+        n += m.l.n;
+    }
+    sm->l.ReserveMore(n);
+    for(SMesh &m : meshes) {
         sm->MakeFromCopyOf(&m);
         m.Clear();
     }
 }
 
+void SShell::TriangulateLodInto(SMesh *sm, int lod, const std::vector<bool> *skip) {
+    Profile::Scope scope("Triangulate");
+    // Same as above, but the per-surface meshes are kept with the surfaces,
+    // so that coming back to a level of detail costs only the copy. Surfaces
+    // marked in skip are drawn some other way, and so left out.
+    std::vector<SMesh *> meshes(surface.n);
+#pragma omp parallel for
+    for(int i=0; i<surface.n; i++) {
+        if(skip && (*skip)[i]) continue;
+        meshes[i] = surface[i].TriangulationForLod(this, lod);
+    }
+
+    int n = 0;
+    for(const SMesh *m : meshes) {
+        if(m) n += m->l.n;
+    }
+    sm->l.ReserveMore(n);
+    for(SMesh *m : meshes) {
+        if(m) sm->MakeFromCopyOf(m);
+    }
+}
+
 bool SShell::IsEmpty() const {
     return surface.IsEmpty();
 }
@@ -96,8 +96,11 @@ public:
     void MakePwlInto(List<SCurvePt> *l, double chordTol=0, double max_dt=0.0) const;
     void MakePwlInto(SContour *sc, double chordTol=0, double max_dt=0.0) const;
     void MakePwlInto(List<Vector> *l, double chordTol=0, double max_dt=0.0) const;
-    void MakePwlWorker(List<Vector> *l, double ta, double tb, double chordTol, double max_dt) const;
-    void MakePwlInitialWorker(List<Vector> *l, double ta, double tb, double chordTol, double max_dt) const;
+    void MakePwlParamsInto(std::vector<double> *params, double chordTol=0, double max_dt=0.0) const;
+    void MakePwlWorker(List<Vector> *l, std::vector<double> *params,
+                       double ta, double tb, double chordTol, double max_dt) const;
+    void MakePwlInitialWorker(List<Vector> *l, std::vector<double> *params,
+                              double ta, double tb, double chordTol, double max_dt) const;
     void MakeNonrationalCubicInto(SBezierList *bl, double tolerance, int depth = 0) const;
 
     void AllIntersectionsWith(const SBezier *sbb, SPointList *spl) const;
@@ -284,6 +287,12 @@ public:
     // a point into our surface.
     Point2d         cached;
 
+    // For caching our display triangulation at each level of detail, along
+    // with the chord tolerance that it was made with.
+    static const int LOD_LEVELS = 3;
+    SMesh           lodMesh[LOD_LEVELS];
+    double          lodChordTol[LOD_LEVELS];
+
     static SSurface FromExtrusionOf(SBezier *spc, Vector t0, Vector t1);
     static SSurface FromRevolutionOf(SBezier *sb, Vector pt, Vector axis, double thetas,
                                      double thetaf, double dists, double distf);
@@ -348,7 +357,8 @@ public:
     bool IsCylinder(Vector *axis, Vector *center, double *r,
                         Vector *start, Vector *finish) const;
 
-    void TriangulateInto(SShell *shell, SMesh *sm);
+    void TriangulateInto(SShell *shell, SMesh *sm, double chordTol);
+    SMesh *TriangulationForLod(SShell *shell, int lod);
 
     // these are intended as bitmasks, even though there's just one now
     enum class MakeAs : uint32_t {
@@ -365,7 +375,7 @@ public:
     void MakeClassifyingBsp(SShell *shell, SShell *useCurvesFrom);
     double ChordToleranceForEdge(Vector a, Vector b) const;
     void MakeTriangulationGridInto(List<double> *l, double vs, double vf,
-                                    bool swapped, int depth) const;
+                                    bool swapped, int depth, double chordTol) const;
     Vector PointAtMaybeSwapped(double u, double v, bool swapped) const;
     Vector NormalAtMaybeSwapped(double u, double v, bool swapped) const;
 
@@ -427,7 +437,17 @@ public:
     void MakeFromAssemblyOf(SShell *a, SShell *b);
     void MergeCoincidentSurfaces();
 
+    // Levels of detail for display triangulations; level 0 is made with the
+    // configured chord tolerance, and each further level is coarser by
+    // LOD_CHORD_TOL_RATIO.
+    static const double LOD_CHORD_TOL_RATIO;
+    static const double LOD_MAX_PIXEL_ERROR;
+    static double LodChordTol(int lod);
+    static int LodForScale(double scale);
+
     void TriangulateInto(SMesh *sm);
+    void TriangulateInto(SMesh *sm, double chordTol);
+    void TriangulateLodInto(SMesh *sm, int lod, const std::vector<bool> *skip = NULL);
     void MakeEdgesInto(SEdgeList *sel);
     void MakeSectionEdgesInto(Vector n, double d, SEdgeList *sel, SBezierList *sbl);
     bool IsEmpty() const;
@@ -542,7 +542,7 @@ Vector SSurface::NormalAtMaybeSwapped(double u, double v, bool swapped) const {
 }
 
 void SSurface::MakeTriangulationGridInto(List<double> *l, double vs, double vf,
-                                         bool swapped, int depth) const
+                                         bool swapped, int depth, double chordTol) const
 {
     double worst = 0;
 
@@ -577,16 +577,16 @@ void SSurface::MakeTriangulationGridInto(List<double> *l, double vs, double vf,
     }
 
     double step = 1.0/SS.GetMaxSegments();
-    if( ((vf - vs) < step || worst < SS.ChordTolMm())
+    if( ((vf - vs) < step || worst < chordTol)
         && ((worst_twist > 0.999) || (depth > 3)) ) {
         l->Add(&vf);
     } else {
-        MakeTriangulationGridInto(l, vs, (vs+vf)/2, swapped, depth+1);
-        MakeTriangulationGridInto(l, (vs+vf)/2, vf, swapped, depth+1);
+        MakeTriangulationGridInto(l, vs, (vs+vf)/2, swapped, depth+1, chordTol);
+        MakeTriangulationGridInto(l, (vs+vf)/2, vf, swapped, depth+1, chordTol);
     }
 }
 
-void SPolygon::UvGridTriangulateInto(SMesh *mesh, SSurface *srf) {
+void SPolygon::UvGridTriangulateInto(SMesh *mesh, SSurface *srf, double chordTol) {
     SEdgeList orig = {};
     MakeEdgesInto(&orig);
 
@@ -602,9 +602,9 @@ void SPolygon::UvGridTriangulateInto(SMesh *mesh, SSurface *srf) {
     lj = {};
     double v[5] = {0.0, 0.25, 0.5, 0.75, 1.0};
     li.Add(&v[0]);
-    srf->MakeTriangulationGridInto(&li, 0, 1, /*swapped=*/true, 0);
+    srf->MakeTriangulationGridInto(&li, 0, 1, /*swapped=*/true, 0, chordTol);
     lj.Add(&v[0]);
-    srf->MakeTriangulationGridInto(&lj, 0, 1, /*swapped=*/false, 0);
+    srf->MakeTriangulationGridInto(&lj, 0, 1, /*swapped=*/false, 0, chordTol);
     dump._DoubleList("  li", &li);
     dump._DoubleList("  lj", &lj);
 
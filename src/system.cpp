@@ -20,6 +20,9 @@ const double System::RANK_MAG_TOLERANCE = 1e-4;
 const double System::CONVERGE_TOLERANCE = (LENGTH_EPS/(1e2));
 
 bool System::WriteJacobian(int tag) {
+    // The unknowns get evaluated from a contiguous array of their values,
+    // instead of through pointers scattered over the param table.
+    std::unordered_map<const Param *, double *> vals;
 
     int j = 0;
     for(auto &p : param) {
@@ -29,6 +32,8 @@ bool System::WriteJacobian(int tag) {
         if(p.tag != tag)
             continue;
         mat.param[j] = p.h;
+        mat.val[j] = p.val;
+        vals[&p] = &mat.val[j];
         j++;
     }
     mat.n = j;
@@ -55,11 +60,13 @@ bool System::WriteJacobian(int tag) {
                 pd = f->PartialWrt(mat.param[j]);
                 pd = pd->FoldConstants();
                 pd = pd->DeepCopyWithParamsAsPointers(&param, &(SK.param));
+                pd->ParamPointersToValues(vals);
             } else {
                 pd = Expr::From(0.0);
             }
             mat.A.sym[i][j] = pd;
         }
+        f->ParamPointersToValues(vals);
         mat.B.sym[i] = f;
         i++;
     }
@@ -276,6 +283,7 @@ bool System::NewtonSolve(int tag) {
 
     int iter = 0;
     bool converged = false;
+    bool diverged = false;
     int i;
 
     // Evaluate the functions at our operating point.
@@ -291,13 +299,14 @@ bool System::NewtonSolve(int tag) {
         // Take the Newton step;
         //      J(x_n) (x_{n+1} - x_n) = 0 - F(x_n)
         for(i = 0; i < mat.n; i++) {
-            Param *p = param.FindById(mat.param[i]);
-            p->val -= mat.X[i];
-            if(IsReasonable(p->val)) {
+            mat.val[i] -= mat.X[i];
+            if(IsReasonable(mat.val[i])) {
                 // Very bad, and clearly not convergent
-                return false;
+                diverged = true;
+                break;
             }
         }
+        if(diverged) break;
 
         // Re-evalute the functions, since the params have just changed.
         for(i = 0; i < mat.m; i++) {
@@ -307,16 +316,22 @@ bool System::NewtonSolve(int tag) {
         converged = true;
         for(i = 0; i < mat.m; i++) {
             if(IsReasonable(mat.B.num[i])) {
-                return false;
+                diverged = true;
+                break;
             }
             if(fabs(mat.B.num[i]) > CONVERGE_TOLERANCE) {
                 converged = false;
                 break;
             }
         }
-    } while(iter++ < 50 && !converged);
+    } while(!diverged && iter++ < 50 && !converged);
+
+    // Write the unknowns back in to the param table.
+    for(i = 0; i < mat.n; i++) {
+        param.FindById(mat.param[i])->val = mat.val[i];
+    }
 
-    return converged;
+    return converged && !diverged;
 }
 
 void System::WriteEquationsExceptFor(hConstraint hc, Group *g) {
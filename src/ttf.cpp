@@ -123,6 +123,19 @@ void TtfFontList::PlotString(const std::string &font, const std::string &str,
     }
 }
 
+void TtfFontList::PlotEdges(const std::string &font, const std::string &str,
+                            SEdgeList *el, int auxA, Vector origin, Vector u, Vector v)
+{
+    TtfFont *tf = LoadFont(font);
+    if(!str.empty() && tf != NULL) {
+        tf->PlotEdges(str, el, auxA, origin, u, v);
+    } else {
+        // The same big X as PlotString() draws.
+        el->AddEdge(origin, origin.Plus(u).Plus(v), auxA, 0);
+        el->AddEdge(origin.Plus(v), origin.Plus(u), auxA, 1);
+    }
+}
+
 double TtfFontList::AspectRatio(const std::string &font, const std::string &str)
 {
     TtfFont *tf = LoadFont(font);
@@ -269,18 +282,20 @@ bool TtfFont::ExtractTTFData(bool keepOpen) {
 }
 
 typedef struct OutlineData {
-    Vector       origin, u, v; // input parameters
-    SBezierList *beziers;      // output bezier list
-    float        factor;       // ratio between freetype and solvespace coordinates
-    FT_Pos       bx;           // x offset of the current glyph
-    FT_Pos       px, py;       // current point
+    TtfFont::Glyph *glyph;     // output glyph
+    FT_Pos          px, py;    // current point
 } OutlineData;
 
-static Vector Transform(OutlineData *data, FT_Pos x, FT_Pos y) {
-    Vector r = data->origin;
-    r = r.Plus(data->u.ScaledBy((float)(data->bx + x) * data->factor));
-    r = r.Plus(data->v.ScaledBy((float)y * data->factor));
-    return r;
+static void AddCurve(OutlineData *data, int deg, const FT_Vector *p[]) {
+    TtfFont::Glyph::Curve curve = {};
+    curve.deg = deg;
+    curve.ctrl[0] = Point2d::From((double)data->px, (double)data->py);
+    for(int i = 1; i <= deg; i++) {
+        curve.ctrl[i] = Point2d::From((double)p[i - 1]->x, (double)p[i - 1]->y);
+    }
+    data->glyph->curves.push_back(curve);
+    data->px = p[deg - 1]->x;
+    data->py = p[deg - 1]->y;
 }
 
 static int MoveTo(const FT_Vector *p, void *cc)
@@ -293,47 +308,73 @@ static int MoveTo(const FT_Vector *p, void *cc)
 
 static int LineTo(const FT_Vector *p, void *cc)
 {
-    OutlineData *data = (OutlineData *) cc;
-    SBezier sb = SBezier::From(
-        Transform(data, data->px, data->py),
-        Transform(data, p->x,     p->y));
-    data->beziers->l.Add(&sb);
-    data->px = p->x;
-    data->py = p->y;
+    const FT_Vector *ps[] = { p };
+    AddCurve((OutlineData *) cc, 1, ps);
     return 0;
 }
 
 static int ConicTo(const FT_Vector *c, const FT_Vector *p, void *cc)
 {
-    OutlineData *data = (OutlineData *) cc;
-    SBezier sb = SBezier::From(
-        Transform(data, data->px, data->py),
-        Transform(data, c->x,     c->y),
-        Transform(data, p->x,     p->y));
-    data->beziers->l.Add(&sb);
-    data->px = p->x;
-    data->py = p->y;
+    const FT_Vector *ps[] = { c, p };
+    AddCurve((OutlineData *) cc, 2, ps);
     return 0;
 }
 
 static int CubicTo(const FT_Vector *c1, const FT_Vector *c2, const FT_Vector *p, void *cc)
 {
-    OutlineData *data = (OutlineData *) cc;
-    SBezier sb = SBezier::From(
-        Transform(data, data->px, data->py),
-        Transform(data, c1->x,    c1->y),
-        Transform(data, c2->x,    c2->y),
-        Transform(data, p->x,     p->y));
-    data->beziers->l.Add(&sb);
-    data->px = p->x;
-    data->py = p->y;
+    const FT_Vector *ps[] = { c1, c2, p };
+    AddCurve((OutlineData *) cc, 3, ps);
     return 0;
 }
 
-void TtfFont::PlotString(const std::string &str,
-                         SBezierList *sbl, Vector origin, Vector u, Vector v)
-{
+//-----------------------------------------------------------------------------
+// Get the outline of a glyph, decomposing it the first time it's asked for.
+// If FreeType can't load it, it's returned with loaded cleared.
+//-----------------------------------------------------------------------------
+const TtfFont::Glyph &TtfFont::GetGlyph(uint32_t gid) {
+    auto it = glyphs.find(gid);
+    if(it != glyphs.end()) {
+        return it->second;
+    }
+
     ssassert(fontFace != NULL, "Expected font face to be loaded");
+    Glyph *glyph = &glyphs[gid];
+    glyph->loaded = false;
+
+    /*
+     * Stupid hacks:
+     *  - if we want fake-bold, use FT_Outline_Embolden(). This actually looks
+     *    quite good.
+     *  - if we want fake-italic, apply a shear transform [1 s s 1 0 0] here using
+     *    FT_Set_Transform. This looks decent at small font sizes and bad at larger
+     *    ones, antialiasing mitigates this considerably though.
+     */
+    if(int fterr = FT_Load_Glyph(fontFace, gid, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING)) {
+        dbp("freetype: cannot load glyph for GID 0x%04x in file '%s': %s",
+            gid, fontFile.raw.c_str(), ft_error_string(fterr));
+        return *glyph;
+    }
+
+    /* A point that has x = xMin should be plotted at (dx0 + lsb); fix up
+     * our x-position so that the curve-generating code will put stuff
+     * at the right place.
+     *
+     * There's no point in getting the glyph BBox here - not only can it be
+     * needlessly slow sometimes, but because we're about to render a single glyph,
+     * what we want actually *is* the CBox.
+     *
+     * This is notwithstanding that this makes extremely little sense, this
+     * looks like a workaround for either mishandling the start glyph on a line,
+     * or as a really hacky pseudo-track-kerning (in which case it works better than
+     * one would expect! especially since most fonts don't set track kerning).
+     */
+    FT_BBox cbox;
+    FT_Outline_Get_CBox(&fontFace->glyph->outline, &cbox);
+    // Yes, this is what FreeType calls left-side bearing.
+    // Then interchangeably uses that with "left-side bearing". Sigh.
+    glyph->offset  = (double)(fontFace->glyph->metrics.horiBearingX - cbox.xMin);
+    glyph->advance = (double)fontFace->glyph->advance.x;
+    glyph->loaded  = true;
 
     FT_Outline_Funcs outlineFuncs;
     outlineFuncs.move_to  = MoveTo;
@@ -343,65 +384,152 @@ void TtfFont::PlotString(const std::string &str,
     outlineFuncs.shift    = 0;
     outlineFuncs.delta    = 0;
 
-    FT_Pos dx = 0;
+    OutlineData data = {};
+    data.glyph = glyph;
+    if(int fterr = FT_Outline_Decompose(&fontFace->glyph->outline, &outlineFuncs, &data)) {
+        dbp("freetype: bezier decomposition failed for GID 0x%4x in file '%s': %s",
+            gid, fontFile.raw.c_str(), ft_error_string(fterr));
+    }
+    return *glyph;
+}
+
+uint32_t TtfFont::GetGlyphIndex(char32_t cid) {
+    uint32_t gid = FT_Get_Char_Index(fontFace, cid);
+    if (gid == 0) {
+        dbp("freetype: CID-to-GID mapping for CID 0x%04x in file '%s' failed: %s; "
+            "using CID as GID",
+            cid, fontFile.raw.c_str(), ft_error_string(gid));
+        gid = cid;
+    }
+    return gid;
+}
+
+// The factor between font units and the u and v vectors is applied in single
+// precision, as it always has been.
+static Vector Transform(const Vector &origin, const Vector &u, const Vector &v,
+                        float factor, double bx, const Point2d &p) {
+    Vector r = origin;
+    r = r.Plus(u.ScaledBy((float)(bx + p.x) * factor));
+    r = r.Plus(v.ScaledBy((float)p.y * factor));
+    return r;
+}
+
+static SBezier TransformCurve(const TtfFont::Glyph::Curve &curve,
+                              const Vector &origin, const Vector &u, const Vector &v,
+                              float factor, double bx) {
+    Vector ctrl[4];
+    for(int i = 0; i <= curve.deg; i++) {
+        ctrl[i] = Transform(origin, u, v, factor, bx, curve.ctrl[i]);
+    }
+    switch(curve.deg) {
+        case 1: return SBezier::From(ctrl[0], ctrl[1]);
+        case 2: return SBezier::From(ctrl[0], ctrl[1], ctrl[2]);
+        case 3: return SBezier::From(ctrl[0], ctrl[1], ctrl[2], ctrl[3]);
+    }
+    ssassert(false, "Unexpected degree of curve");
+}
+
+void TtfFont::PlotString(const std::string &str,
+                         SBezierList *sbl, Vector origin, Vector u, Vector v)
+{
+    ssassert(fontFace != NULL, "Expected font face to be loaded");
+
+    float factor = (float)(1.0 / capHeight);
+    double dx = 0;
     for(char32_t cid : ReadUTF8(str)) {
-        uint32_t gid = FT_Get_Char_Index(fontFace, cid);
-        if (gid == 0) {
-            dbp("freetype: CID-to-GID mapping for CID 0x%04x in file '%s' failed: %s; "
-                "using CID as GID",
-                cid, fontFile.raw.c_str(), ft_error_string(gid));
-            gid = cid;
+        const Glyph &glyph = GetGlyph(GetGlyphIndex(cid));
+        if(!glyph.loaded) return;
+
+        for(const Glyph::Curve &curve : glyph.curves) {
+            SBezier sb = TransformCurve(curve, origin, u, v, factor, dx + glyph.offset);
+            sbl->l.Add(&sb);
         }
 
-        /*
-         * Stupid hacks:
-         *  - if we want fake-bold, use FT_Outline_Embolden(). This actually looks
-         *    quite good.
-         *  - if we want fake-italic, apply a shear transform [1 s s 1 0 0] here using
-         *    FT_Set_Transform. This looks decent at small font sizes and bad at larger
-         *    ones, antialiasing mitigates this considerably though.
-         */
-        if(int fterr = FT_Load_Glyph(fontFace, gid, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING)) {
-            dbp("freetype: cannot load glyph for GID 0x%04x in file '%s': %s",
-                gid, fontFile.raw.c_str(), ft_error_string(fterr));
-            return;
+        // And we're done, so advance our position by the requested advance
+        // width, plus the user-requested extra advance.
+        dx += glyph.advance;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Make the same curves as PlotString() piecewise linear, the same as if each
+// was split on its own. Each glyph is split only once for a chord tolerance
+// and size, and then the curves are just evaluated where it was split.
+//-----------------------------------------------------------------------------
+void TtfFont::PlotEdges(const std::string &str, SEdgeList *el, int auxA,
+                        Vector origin, Vector u, Vector v)
+{
+    ssassert(fontFace != NULL, "Expected font face to be loaded");
+
+    float factor = (float)(1.0 / capHeight);
+    double chordTol = SS.ChordTolMm();
+    int maxSegments = SS.GetMaxSegments();
+
+    // The split in font units is the split in place only when the glyphs are
+    // scaled uniformly, as they are for text entities.
+    double size = u.Magnitude();
+    bool uniform = fabs(size - v.Magnitude()) < 1e-9 * size &&
+                   fabs(u.Dot(v)) < 1e-9 * size * size;
+    double fontChordTol = chordTol / (size * factor);
+
+    int i = 0;
+    double dx = 0;
+    for(char32_t cid : ReadUTF8(str)) {
+        uint32_t gid = GetGlyphIndex(cid);
+        const Glyph &glyph = GetGlyph(gid);
+        if(!glyph.loaded) return;
+
+        const Glyph::Pwl *pwl = NULL;
+        if(uniform) {
+            Glyph *cached = &glyphs[gid];
+            for(const Glyph::Pwl &p : cached->pwls) {
+                if(EXACT(p.chordTol == fontChordTol) && p.maxSegments == maxSegments) {
+                    pwl = &p;
+                    break;
+                }
+            }
+            if(pwl == NULL) {
+                // Keep only a few sizes of text around.
+                if(cached->pwls.size() == 4) {
+                    cached->pwls.erase(cached->pwls.begin());
+                }
+                Glyph::Pwl newPwl = {};
+                newPwl.chordTol    = fontChordTol;
+                newPwl.maxSegments = maxSegments;
+                for(const Glyph::Curve &curve : cached->curves) {
+                    // In font units.
+                    SBezier sb = TransformCurve(curve, Vector::From(0, 0, 0),
+                                                Vector::From(1, 0, 0), Vector::From(0, 1, 0),
+                                                1.0f, 0.0);
+                    newPwl.params.emplace_back();
+                    sb.MakePwlParamsInto(&newPwl.params.back(), fontChordTol);
+                }
+                cached->pwls.push_back(std::move(newPwl));
+                pwl = &cached->pwls.back();
+            }
         }
 
-        /* A point that has x = xMin should be plotted at (dx0 + lsb); fix up
-         * our x-position so that the curve-generating code will put stuff
-         * at the right place.
-         *
-         * There's no point in getting the glyph BBox here - not only can it be
-         * needlessly slow sometimes, but because we're about to render a single glyph,
-         * what we want actually *is* the CBox.
-         *
-         * This is notwithstanding that this makes extremely little sense, this
-         * looks like a workaround for either mishandling the start glyph on a line,
-         * or as a really hacky pseudo-track-kerning (in which case it works better than
-         * one would expect! especially since most fonts don't set track kerning).
-         */
-        FT_BBox cbox;
-        FT_Outline_Get_CBox(&fontFace->glyph->outline, &cbox);
-        FT_Pos bx = dx - cbox.xMin;
-        // Yes, this is what FreeType calls left-side bearing.
-        // Then interchangeably uses that with "left-side bearing". Sigh.
-        bx += fontFace->glyph->metrics.horiBearingX;
-
-        OutlineData data = {};
-        data.origin  = origin;
-        data.u       = u;
-        data.v       = v;
-        data.beziers = sbl;
-        data.factor  = (float)(1.0 / capHeight);
-        data.bx      = bx;
-        if(int fterr = FT_Outline_Decompose(&fontFace->glyph->outline, &outlineFuncs, &data)) {
-            dbp("freetype: bezier decomposition failed for GID 0x%4x in file '%s': %s",
-                gid, fontFile.raw.c_str(), ft_error_string(fterr));
+        for(size_t j = 0; j < glyph.curves.size(); j++, i++) {
+            SBezier sb = TransformCurve(glyph.curves[j], origin, u, v, factor,
+                                        dx + glyph.offset);
+            if(pwl != NULL) {
+                Vector prev = sb.ctrl[0];
+                for(double t : pwl->params[j]) {
+                    Vector p = sb.PointAt(t);
+                    el->AddEdge(prev, p, auxA, i);
+                    prev = p;
+                }
+            } else {
+                List<Vector> lv = {};
+                sb.MakePwlInto(&lv);
+                for(int k = 1; k < lv.n; k++) {
+                    el->AddEdge(lv[k-1], lv[k], auxA, i);
+                }
+                lv.Clear();
+            }
         }
 
-        // And we're done, so advance our position by the requested advance
-        // width, plus the user-requested extra advance.
-        dx += fontFace->glyph->advance.x;
+        dx += glyph.advance;
     }
 }
 
@@ -418,13 +546,10 @@ double TtfFont::AspectRatio(const std::string &str) {
                 chr, fontFile.raw.c_str(), ft_error_string(gid));
         }
 
-        if(int fterr = FT_Load_Glyph(fontFace, gid, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING)) {
-            dbp("freetype: cannot load glyph for GID 0x%04x in file '%s': %s",
-                gid, fontFile.raw.c_str(), ft_error_string(fterr));
-            break;
-        }
+        const Glyph &glyph = GetGlyph(gid);
+        if(!glyph.loaded) break;
 
-        dx += (double)fontFace->glyph->advance.x / capHeight;
+        dx += glyph.advance / capHeight;
     }
 
     return dx;
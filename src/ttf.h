@@ -11,10 +11,38 @@
 
 class TtfFont {
 public:
+    // The outline of a glyph as FreeType decomposes it, in font units, so that
+    // strings can be plotted without going back to FreeType.
+    class Glyph {
+    public:
+        class Curve {
+        public:
+            int         deg;
+            Point2d     ctrl[4];
+        };
+        // Where the curves were split into line segments, for a few recently
+        // used chord tolerances in font units.
+        class Pwl {
+        public:
+            double                           chordTol;
+            int                              maxSegments;
+            std::vector<std::vector<double>> params;
+        };
+
+        bool                loaded;
+        std::vector<Curve>  curves;
+        // From the pen position to the origin of the font units, and from
+        // there to the next pen position.
+        double              offset;
+        double              advance;
+        std::vector<Pwl>    pwls;
+    };
+
     Platform::Path  fontFile; // or resource path/name as res://<path>
     std::string     name;
     FT_FaceRec_    *fontFace;
     double          capHeight;
+    std::map<uint32_t, Glyph> glyphs;
 
     void SetResourceID(const std::string &resource);
     bool IsResource() const;
@@ -23,8 +51,12 @@ public:
     bool LoadFromFile(FT_LibraryRec_ *fontLibrary, bool keepOpen = false);
     bool LoadFromResource(FT_LibraryRec_ *fontLibrary, bool keepOpen = false);
 
+    uint32_t GetGlyphIndex(char32_t cid);
+    const Glyph &GetGlyph(uint32_t gid);
     void PlotString(const std::string &str,
                     SBezierList *sbl, Vector origin, Vector u, Vector v);
+    void PlotEdges(const std::string &str, SEdgeList *el, int auxA,
+                   Vector origin, Vector u, Vector v);
     double AspectRatio(const std::string &str);
 
     bool ExtractTTFData(bool keepOpen);
@@ -44,6 +76,8 @@ public:
 
     void PlotString(const std::string &font, const std::string &str,
                     SBezierList *sbl, Vector origin, Vector u, Vector v);
+    void PlotEdges(const std::string &font, const std::string &str,
+                   SEdgeList *el, int auxA, Vector origin, Vector u, Vector v);
     double AspectRatio(const std::string &font, const std::string &str);
 };
 
@@ -167,6 +167,8 @@ enum class Command : uint32_t {
     TRACE_PT,
     STOP_TRACING,
     STEP_DIM,
+    SHOW_TIMINGS,
+    EXPORT_TRACE,
     // Help
     LOCALE,
     WEBSITE,
@@ -538,6 +540,7 @@ public:
     Platform::MenuItemRef showToolbarMenuItem;
     Platform::MenuItemRef showTextWndMenuItem;
     Platform::MenuItemRef fullScreenMenuItem;
+    Platform::MenuItemRef showTimingsMenuItem;
 
     Platform::MenuItemRef unitsMmMenuItem;
     Platform::MenuItemRef unitsMetersMenuItem;
@@ -550,8 +553,29 @@ public:
     Platform::MenuItemRef redoMenuItem;
 
     std::shared_ptr<ViewportCanvas> canvas;
-    std::shared_ptr<BatchCanvas>    persistentCanvas;
+    // The things that don't change when we rotate are kept on the GPU in
+    // batches: the active group's mesh, the entities of each group, and the
+    // filled paths. Each batch remembers a fingerprint of what went into it,
+    // so after a regeneration only the batches that changed are drawn again.
+    class PersistentBatch {
+    public:
+        std::shared_ptr<BatchCanvas> canvas;
+        uint64_t                     key;
+        // For the batches of entities, the bounds of what's in them, as for
+        // picking; a batch that's entirely off the screen isn't drawn.
+        bool                         bounded;
+        BBox                         bbox;
+        double                       margin;
+    };
+    PersistentBatch                         persistentSolid;
+    std::map<uint32_t, PersistentBatch>     persistentEntities;
+    PersistentBatch                         persistentFills;
+    // Everything must be drawn again, e.g. because a style changed.
     bool persistentDirty;
+    // Only the batches whose fingerprints changed must be drawn again.
+    bool persistentRegenerated;
+    // The level of detail at which the display meshes are triangulated.
+    int meshLod;
 
     // These parameters define the map from 2d screen coordinates to the
     // coordinates of the 3d sketch points. We will use an axonometric
@@ -733,6 +757,70 @@ public:
         Selection   selection;
     };
 
+    // A bounding volume hierarchy over the things that can be hovered, so
+    // that hit testing draws only those that might be near the cursor.
+    class PickIndex {
+    public:
+        class Item {
+        public:
+            BBox        bbox;
+            // Extra slop in pixels, for parts drawn at a fixed screen size.
+            double      margin;
+            uint32_t    v;
+        };
+        class Node {
+        public:
+            BBox        bbox;
+            double      margin;
+            // For leaves, the range of items; for inner nodes, count is zero,
+            // the left child follows this node and first is the right child.
+            int         first;
+            int         count;
+        };
+
+        std::vector<Item>       items;
+        std::vector<Node>       nodes;
+        // Things with no useful bounds, which must always be tested.
+        std::vector<uint32_t>   unbounded;
+        // The handles of everything that was considered, in order.
+        std::vector<uint32_t>   source;
+        bool                    dirty;
+
+        void Clear();
+        void Build();
+        void Refit();
+        void Query(const std::function<bool(const BBox &, double)> &isNear,
+                   std::vector<uint32_t> *found) const;
+    };
+    // All are indexed in model space. The entities don't depend on the view,
+    // so their index survives changes to it; the constraints are laid out in
+    // pixels, so their index survives only panning. The normals and workplanes
+    // are drawn anew every frame, so they're indexed apart from the entities
+    // drawn once into the persistent batches; entityIndex holds its dirty flag
+    // and the handles of all the entities.
+    PickIndex entityIndex;
+    PickIndex viewEntityIndex;
+    PickIndex constraintIndex;
+    struct {
+        Vector  projRight;
+        Vector  projUp;
+        double  scale;
+    }       constraintIndexView;
+    void UpdateEntityIndex();
+    bool ConstraintIndexIsCurrent(const Camera &camera);
+    void UpdateConstraintIndex(const Camera &camera);
+
+    // What the last call to Draw() skipped, because it was off the screen
+    // or smaller than a pixel.
+    struct {
+        int     entities;
+        int     entitiesCulled;
+        int     batches;
+        int     batchesCulled;
+        int     constraints;
+        int     constraintsCulled;
+    }       cullStats;
+
     List<Hover> hoverList;
     Selection hover;
     bool hoverWasSelectedOnMousedown;
@@ -808,15 +896,25 @@ public:
     bool    dimSolidModel;
     void DrawSnapGrid(Canvas *canvas);
 
+    // The breakdown of where the time of the last frame went, drawn over
+    // the sketch while timings are being recorded.
+    bool    showTimings;
+    void DrawTimings(UiCanvas *canvas);
+
     void AddPointToDraggedList(hEntity hp);
     void StartDraggingByEntity(hEntity he);
     void StartDraggingBySelection();
     void UpdateDraggedNum(Vector *pos, double mx, double my);
     void UpdateDraggedPoint(hEntity hp, double mx, double my);
+    void UpdateDraggedLabel(hConstraint hc, double mx, double my);
 
     void Invalidate(bool clearPersistent = false);
     void DrawEntities(Canvas *canvas, bool persistent);
     void DrawPersistent(Canvas *canvas);
+    uint64_t PersistentSolidKey();
+    void PersistentEntityKeys(std::map<uint32_t, uint64_t> *keys);
+    uint64_t PersistentFillsKey();
+    void UpdatePersistent();
     void Draw(Canvas *canvas);
     void Paint();
 
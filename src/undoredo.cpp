@@ -31,70 +31,219 @@ void SolveSpaceUI::UndoRedo() {
 }
 
 void SolveSpaceUI::UndoEnableMenus() {
+    if(!SS.GW.window) return;
+
     SS.GW.undoMenuItem->SetEnabled(undo.cnt > 0);
     SS.GW.redoMenuItem->SetEnabled(redo.cnt > 0);
 }
 
+//-----------------------------------------------------------------------------
+// Whether two versions of an element are the same as far as undo is
+// concerned; that's everything that gets saved, and nothing that gets
+// regenerated.
+//-----------------------------------------------------------------------------
+static bool SameForUndo(const EntityMap &a, const EntityMap &b) {
+    if(a.size() != b.size()) return false;
+    for(const auto &it : a) {
+        auto jt = b.find(it.first);
+        if(jt == b.end() || !(jt->second == it.second)) return false;
+    }
+    return true;
+}
+
+static bool SameForUndo(const Group &a, const Group &b) {
+    return a.type == b.type && a.order == b.order &&
+        a.opA == b.opA && a.opB == b.opB &&
+        a.visible == b.visible && a.suppress == b.suppress &&
+        a.relaxConstraints == b.relaxConstraints &&
+        a.allowRedundant == b.allowRedundant &&
+        a.allDimsReference == b.allDimsReference && a.scale == b.scale &&
+        a.activeWorkplane == b.activeWorkplane &&
+        a.valA == b.valA && a.valB == b.valB && a.valC == b.valC &&
+        a.color.Equals(b.color) && a.subtype == b.subtype &&
+        a.skipFirst == b.skipFirst &&
+        a.predef.q.w == b.predef.q.w && a.predef.q.vx == b.predef.q.vx &&
+        a.predef.q.vy == b.predef.q.vy && a.predef.q.vz == b.predef.q.vz &&
+        a.predef.origin == b.predef.origin &&
+        a.predef.entityB == b.predef.entityB &&
+        a.predef.entityC == b.predef.entityC &&
+        a.predef.swapUV == b.predef.swapUV &&
+        a.predef.negateU == b.predef.negateU &&
+        a.predef.negateV == b.predef.negateV &&
+        a.meshCombine == b.meshCombine && a.forceToMesh == b.forceToMesh &&
+        a.name == b.name && a.linkFile.Equals(b.linkFile) &&
+        a.impFile == b.impFile && SameForUndo(a.remap, b.remap);
+}
+
+static bool SameForUndo(const Request &a, const Request &b) {
+    return a.type == b.type && a.extraPoints == b.extraPoints &&
+        a.workplane == b.workplane && a.group == b.group && a.style == b.style &&
+        a.construction == b.construction && a.str == b.str && a.font == b.font &&
+        a.file.Equals(b.file) && a.aspectRatio == b.aspectRatio;
+}
+
+static bool SameForUndo(const Constraint &a, const Constraint &b) {
+    return a.Equals(b) && a.disp.offset.EqualsExactly(b.disp.offset) &&
+        a.disp.style == b.disp.style;
+}
+
+static bool SameForUndo(const Param &a, const Param &b) {
+    return a.val == b.val && a.known == b.known && a.free == b.free;
+}
+
+static bool SameForUndo(const Style &a, const Style &b) {
+    return a.name == b.name && a.width == b.width && a.widthAs == b.widthAs &&
+        a.textHeight == b.textHeight && a.textHeightAs == b.textHeightAs &&
+        a.textOrigin == b.textOrigin && a.textAngle == b.textAngle &&
+        a.color.Equals(b.color) && a.filled == b.filled &&
+        a.fillColor.Equals(b.fillColor) && a.visible == b.visible &&
+        a.exportable == b.exportable && a.stippleType == b.stippleType &&
+        a.stippleScale == b.stippleScale && a.zIndex == b.zIndex;
+}
+
+//-----------------------------------------------------------------------------
+// The copy of an element that the undo stack keeps. Tags are cleared, since
+// they're used to remove elements from the kept copy.
+//-----------------------------------------------------------------------------
+template<class T>
+static T CopyForUndo(const T &src) {
+    T dest(src);
+    dest.tag = 0;
+    return dest;
+}
+
+static Group CopyForUndo(const Group &src) {
+    // Undoing doesn't have to load the linked file again, since the undo
+    // state shares it.
+    return src.CopyWithoutGeneratedData();
+}
+
+template<class T, class H>
+static void CopyListForUndo(IdList<T,H> *src, IdList<T,H> *dest) {
+    dest->ReserveMore(src->n);
+    for(const T &t : *src) {
+        T copy = CopyForUndo(t);
+        dest->AddUnsorted(&copy);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Compare the current list against the newest state kept on the stack, which
+// are both sorted by handle. Record in changes what it takes to go back from
+// the current list to the kept one, and then bring the kept one up to date.
+// Only the elements that differ get copied.
+//-----------------------------------------------------------------------------
+template<class T, class H>
+static void PushChanges(IdList<T,H> *cur, IdList<T,H> *top,
+                        SolveSpaceUI::UndoChanges<T,H> *changes) {
+    std::vector<const T *> changed;
+    bool anyRemoved = false;
+
+    auto ci = cur->begin(), ce = cur->end();
+    auto ti = top->begin(), te = top->end();
+    while(ci != ce || ti != te) {
+        if(ti == te || (ci != ce && ci->h.v < ti->h.v)) {
+            // Added since; undoing removes it.
+            H h = ci->h;
+            changes->remove.Add(&h);
+            changed.push_back(&*ci);
+            ++ci;
+        } else if(ci == ce || ti->h.v < ci->h.v) {
+            // Removed since; undoing puts it back.
+            changes->restore.AddUnsorted(&*ti);
+            (*ti).tag = 1;
+            anyRemoved = true;
+            ++ti;
+        } else {
+            if(!SameForUndo(*ci, *ti)) {
+                changes->restore.AddUnsorted(&*ti);
+                changed.push_back(&*ci);
+            }
+            ++ci;
+            ++ti;
+        }
+    }
+
+    if(anyRemoved) top->RemoveTagged();
+    for(const T *t : changed) {
+        T copy = CopyForUndo(*t);
+        T *old = top->FindByIdNoOops(t->h);
+        if(old) {
+            *old = copy;
+        } else {
+            top->AddUnsorted(&copy);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Undo the changes recorded above, turning the newest kept state back into
+// the one before it.
+//-----------------------------------------------------------------------------
+template<class T, class H>
+static void PopChanges(IdList<T,H> *top, SolveSpaceUI::UndoChanges<T,H> *changes) {
+    if(!changes->remove.IsEmpty()) {
+        for(const H &h : changes->remove) {
+            top->FindById(h)->tag = 1;
+        }
+        top->RemoveTagged();
+    }
+    for(T &t : changes->restore) {
+        T *old = top->FindByIdNoOops(t.h);
+        if(old) {
+            *old = t;
+        } else {
+            top->AddUnsorted(&t);
+        }
+    }
+    changes->Clear();
+}
+
 void SolveSpaceUI::PushFromCurrentOnto(UndoStack *uk) {
+    UndoState *top = &uk->top;
+    if(uk->cnt == 0) {
+        CopyListForUndo(&SK.group, &top->group);
+        CopyListForUndo(&SK.request, &top->request);
+        CopyListForUndo(&SK.constraint, &top->constraint);
+        CopyListForUndo(&SK.param, &top->param);
+        CopyListForUndo(&SK.style, &top->style);
+        for(auto &gh : SK.groupOrder) { top->groupOrder.Add(&gh); }
+        top->activeGroup = SS.GW.activeGroup;
+        uk->cnt = 1;
+        return;
+    }
+
     if(uk->cnt == MAX_UNDO) {
-        UndoClearState(&(uk->d[uk->write]));
-        // And then write in to this one again
+        // Forget the oldest state; the newest is kept in full, so there's
+        // one delta fewer than there are states.
+        UndoDelta *oldest = &(uk->d[WRAP(uk->write - (uk->cnt - 1), MAX_UNDO)]);
+        oldest->Clear();
+        *oldest = {};
     } else {
         (uk->cnt)++;
     }
 
-    UndoState *ut = &(uk->d[uk->write]);
-    *ut = {};
-    ut->group.ReserveMore(SK.group.n);
-    for(Group &src : SK.group) {
-        // Shallow copy
-        Group dest(src);
-        // And then clean up all the stuff that needs to be a deep copy,
-        // and zero out all the dynamic stuff that will get regenerated.
-        dest.clean = false;
-        dest.solved = {};
-        dest.polyLoops = {};
-        dest.bezierLoops = {};
-        dest.bezierOpens = {};
-        dest.polyError = {};
-        dest.thisMesh = {};
-        dest.runningMesh = {};
-        dest.thisShell = {};
-        dest.runningShell = {};
-        dest.displayMesh = {};
-        dest.displayOutlines = {};
-
-        dest.remap = src.remap;
-
-        dest.impMesh = {};
-        dest.impShell = {};
-        dest.impEntity = {};
-        ut->group.Add(&dest);
-    }
-    for(auto &src : SK.groupOrder) { ut->groupOrder.Add(&src); }
-    ut->request.ReserveMore(SK.request.n);
-    for(auto &src : SK.request) { ut->request.Add(&src); }
-    ut->constraint.ReserveMore(SK.constraint.n);
-    for(auto &src : SK.constraint) {
-        // Shallow copy
-        Constraint dest(src);
-        ut->constraint.Add(&dest);
-    }
-    ut->param.ReserveMore(SK.param.n);
-    for(auto &src : SK.param) { ut->param.Add(&src); }
-    ut->style.ReserveMore(SK.style.n);
-    for(auto &src : SK.style) { ut->style.Add(&src); }
-    ut->activeGroup = SS.GW.activeGroup;
+    UndoDelta *ud = &(uk->d[uk->write]);
+    *ud = {};
+    PushChanges(&SK.group, &top->group, &ud->group);
+    PushChanges(&SK.request, &top->request, &ud->request);
+    PushChanges(&SK.constraint, &top->constraint, &ud->constraint);
+    PushChanges(&SK.param, &top->param, &ud->param);
+    PushChanges(&SK.style, &top->style, &ud->style);
+
+    // The group order and active group are tiny, so just swap them over.
+    ud->groupOrder = top->groupOrder;
+    ud->activeGroup = top->activeGroup;
+    top->groupOrder = {};
+    for(auto &gh : SK.groupOrder) { top->groupOrder.Add(&gh); }
+    top->activeGroup = SS.GW.activeGroup;
 
     uk->write = WRAP(uk->write + 1, MAX_UNDO);
 }
 
 void SolveSpaceUI::PopOntoCurrentFrom(UndoStack *uk) {
     ssassert(uk->cnt > 0, "Cannot pop from empty undo stack");
-    (uk->cnt)--;
-    uk->write = WRAP(uk->write - 1, MAX_UNDO);
-
-    UndoState *ut = &(uk->d[uk->write]);
+    UndoState *top = &uk->top;
 
     // Free everything in the main copy of the program before replacing it
     for(hGroup hg : SK.groupOrder) {
@@ -108,17 +257,34 @@ void SolveSpaceUI::PopOntoCurrentFrom(UndoStack *uk) {
     SK.param.Clear();
     SK.style.Clear();
 
-    // And then do a shallow copy of the state from the undo list
-    ut->group.MoveSelfInto(&(SK.group));
-    for(auto &gh : ut->groupOrder) { SK.groupOrder.Add(&gh); }
-    ut->request.MoveSelfInto(&(SK.request));
-    ut->constraint.MoveSelfInto(&(SK.constraint));
-    ut->param.MoveSelfInto(&(SK.param));
-    ut->style.MoveSelfInto(&(SK.style));
-    SS.GW.activeGroup = ut->activeGroup;
+    // And then copy the newest state over; it has to stay on the stack, as
+    // the older states are only kept as their differences from it.
+    top->group.DeepCopyInto(&(SK.group));
+    for(auto &gh : top->groupOrder) { SK.groupOrder.Add(&gh); }
+    top->request.DeepCopyInto(&(SK.request));
+    top->constraint.DeepCopyInto(&(SK.constraint));
+    top->param.DeepCopyInto(&(SK.param));
+    top->style.DeepCopyInto(&(SK.style));
+    SS.GW.activeGroup = top->activeGroup;
 
-    // No need to free it, since a shallow copy was made above
-    *ut = {};
+    (uk->cnt)--;
+    if(uk->cnt == 0) {
+        top->Clear();
+        *top = {};
+    } else {
+        // The state before that one becomes the newest.
+        uk->write = WRAP(uk->write - 1, MAX_UNDO);
+        UndoDelta *ud = &(uk->d[uk->write]);
+        PopChanges(&top->group, &ud->group);
+        PopChanges(&top->request, &ud->request);
+        PopChanges(&top->constraint, &ud->constraint);
+        PopChanges(&top->param, &ud->param);
+        PopChanges(&top->style, &ud->style);
+        top->groupOrder.Clear();
+        top->groupOrder = ud->groupOrder;
+        top->activeGroup = ud->activeGroup;
+        *ud = {};
+    }
 
     // And reset the state everywhere else in the program, since the
     // sketch just changed a lot.
@@ -134,21 +300,11 @@ void SolveSpaceUI::PopOntoCurrentFrom(UndoStack *uk) {
 }
 
 void SolveSpaceUI::UndoClearStack(UndoStack *uk) {
-    while(uk->cnt > 0) {
+    while(uk->cnt > 1) {
         uk->write = WRAP(uk->write - 1, MAX_UNDO);
         (uk->cnt)--;
-        UndoClearState(&(uk->d[uk->write]));
+        uk->d[uk->write].Clear();
     }
+    uk->top.Clear();
     *uk = {}; // for good measure
 }
-
-void SolveSpaceUI::UndoClearState(UndoState *ut) {
-    for(auto &g : ut->group) { g.remap.clear(); }
-    ut->group.Clear();
-    ut->request.Clear();
-    ut->constraint.Clear();
-    ut->param.Clear();
-    ut->style.Clear();
-    *ut = {};
-}
-
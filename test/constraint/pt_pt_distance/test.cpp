@@ -47,3 +47,100 @@ TEST_CASE(reference_migrate_from_v22) {
     CHECK_LOAD("reference_v22.slvs");
     CHECK_SAVE("reference.slvs");
 }
+
+static void DrawFrame(const Camera &camera) {
+    CairoPixmapRenderer pixmapCanvas;
+    pixmapCanvas.SetLighting(SS.GW.GetLighting());
+    pixmapCanvas.SetCamera(camera);
+    pixmapCanvas.Init();
+
+    pixmapCanvas.StartFrame();
+    SS.GW.Draw(&pixmapCanvas);
+    pixmapCanvas.FlushFrame();
+    pixmapCanvas.FinishFrame();
+    pixmapCanvas.Clear();
+}
+
+TEST_CASE(normal_culled_off_screen) {
+    CHECK_LOAD("normal.slvs");
+
+    Camera camera = {};
+    camera.pixelRatio = 1;
+    camera.gridFit    = true;
+    camera.width      = 600;
+    camera.height     = 600;
+    camera.projUp     = SS.GW.projUp;
+    camera.projRight  = SS.GW.projRight;
+    camera.scale      = SS.GW.scale;
+
+    // Nothing is left out where everything can be seen.
+    SS.GW.UpdateConstraintIndex(camera);
+    DrawFrame(camera);
+    CHECK_TRUE(SS.GW.cullStats.entities > 0);
+    CHECK_TRUE(SS.GW.cullStats.entitiesCulled == 0);
+    CHECK_TRUE(SS.GW.cullStats.constraints == 1);
+    CHECK_TRUE(SS.GW.cullStats.constraintsCulled == 0);
+
+    // Panned far away, the points and the label are all left out; the
+    // constraint doesn't have to be laid out again for that.
+    camera.offset = camera.projRight.ScaledBy(10.0 * camera.width / camera.scale);
+    DrawFrame(camera);
+    CHECK_TRUE(SS.GW.cullStats.entitiesCulled >= 2);
+    CHECK_TRUE(SS.GW.cullStats.constraintsCulled == 1);
+
+    // Zoomed in, the label is laid out again, so it's drawn regardless.
+    camera.scale *= 2.0;
+    DrawFrame(camera);
+    CHECK_TRUE(SS.GW.cullStats.constraintsCulled == 0);
+}
+
+TEST_CASE(normal_hover_moved_label) {
+    CHECK_LOAD("normal.slvs");
+
+    hConstraint hc = SK.constraint[0].h;
+    std::vector<Vector> refs;
+    SK.GetConstraint(hc)->GetReferencePoints(SS.GW.GetCamera(), &refs);
+    Point2d label = SS.GW.ProjectPoint(refs[0]);
+
+    // Hovering lays the constraints out, with the label where it is now.
+    SS.GW.HitTestMakeSelection(label);
+    CHECK_TRUE(SS.GW.hover.constraint == hc);
+
+    // Dragged away, it's found where it was dragged to.
+    Point2d moved = label.Plus(Point2d::From(0, 50));
+    SS.GW.orig.mouse = label;
+    SS.GW.UpdateDraggedLabel(hc, moved.x, moved.y);
+    SS.GW.HitTestMakeSelection(moved);
+    CHECK_TRUE(SS.GW.hover.constraint == hc);
+}
+
+TEST_CASE(normal_moved_label_not_culled) {
+    CHECK_LOAD("normal.slvs");
+
+    Camera camera = {};
+    camera.pixelRatio = 1;
+    camera.gridFit    = true;
+    camera.width      = 600;
+    camera.height     = 600;
+    camera.projUp     = SS.GW.projUp;
+    camera.projRight  = SS.GW.projRight;
+    camera.scale      = SS.GW.scale;
+    SS.GW.UpdateConstraintIndex(camera);
+
+    // Drag the label well off the screen, and then pan over to it; it's
+    // drawn, even though where it was laid out is now off the screen.
+    hConstraint hc = SK.constraint[0].h;
+    double distance = 2.0 * camera.width;
+    SS.GW.orig.mouse = Point2d::From(0, 0);
+    SS.GW.UpdateDraggedLabel(hc, distance, 0);
+    camera.offset = camera.projRight.ScaledBy(-distance / camera.scale);
+    DrawFrame(camera);
+    CHECK_TRUE(SS.GW.cullStats.constraints == 1);
+    CHECK_TRUE(SS.GW.cullStats.constraintsCulled == 0);
+
+    // Once laid out again, it is left out when panned away from.
+    SS.GW.UpdateConstraintIndex(camera);
+    camera.offset = camera.projRight.ScaledBy(distance / camera.scale);
+    DrawFrame(camera);
+    CHECK_TRUE(SS.GW.cullStats.constraintsCulled == 1);
+}
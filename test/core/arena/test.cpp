@@ -0,0 +1,78 @@
+#include "harness.h"
+
+// Big enough to get a chunk of its own, so that the size of the arena grows
+// by exactly this much.
+static const size_t BIG = 1 << 20;
+
+TEST_CASE(freed_on_scope_exit) {
+    size_t before = TemporaryArena::TotalSize();
+    {
+        TemporaryArena arena;
+        char *p = (char *)AllocTemporary(BIG);
+        CHECK_TRUE(p[0] == 0 && p[BIG - 1] == 0);
+        CHECK_TRUE(arena.Size() == BIG);
+        CHECK_TRUE(TemporaryArena::TotalSize() == before + BIG);
+
+        // Small allocations share chunks.
+        AllocTemporary(16);
+        size_t size = arena.Size();
+        for(int i = 0; i < 100; i++) {
+            AllocTemporary(16);
+        }
+        CHECK_TRUE(arena.Size() == size);
+    }
+    CHECK_TRUE(TemporaryArena::TotalSize() == before);
+}
+
+TEST_CASE(freed_on_reset) {
+    size_t before = TemporaryArena::TotalSize();
+    TemporaryArena arena;
+    AllocTemporary(BIG);
+    AllocTemporary(16);
+    CHECK_TRUE(arena.Size() > BIG);
+    arena.Reset();
+    CHECK_TRUE(arena.Size() == 0);
+    CHECK_TRUE(TemporaryArena::TotalSize() == before);
+
+    // And it is still current.
+    CHECK_TRUE(TemporaryArena::Current() == &arena);
+    char *p = (char *)AllocTemporary(16);
+    CHECK_TRUE(p[0] == 0 && p[15] == 0);
+    CHECK_TRUE(arena.Size() > 0);
+}
+
+TEST_CASE(nested) {
+    TemporaryArena outer;
+    AllocTemporary(BIG);
+    {
+        TemporaryArena inner;
+        CHECK_TRUE(TemporaryArena::Current() == &inner);
+        AllocTemporary(BIG);
+        CHECK_TRUE(inner.Size() == BIG);
+        CHECK_TRUE(outer.Size() == BIG);
+    }
+    CHECK_TRUE(TemporaryArena::Current() == &outer);
+    AllocTemporary(BIG);
+    CHECK_TRUE(outer.Size() == 2 * BIG);
+}
+
+TEST_CASE(used_by_workers) {
+    size_t before = TemporaryArena::TotalSize();
+    {
+        TemporaryArena arena;
+        const int n = 64;
+        std::vector<char *> ptrs(n);
+#pragma omp parallel for
+        for(int i = 0; i < n; i++) {
+            TemporaryArena::Use use(&arena);
+            ptrs[i] = (char *)AllocTemporary(BIG);
+            ptrs[i][0] = (char)i;
+        }
+        CHECK_TRUE(TemporaryArena::Current() == &arena);
+        CHECK_TRUE(arena.Size() == n * BIG);
+        for(int i = 0; i < n; i++) {
+            CHECK_TRUE(ptrs[i][0] == (char)i);
+        }
+    }
+    CHECK_TRUE(TemporaryArena::TotalSize() == before);
+}
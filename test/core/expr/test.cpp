@@ -110,3 +110,51 @@ TEST_CASE(errors) {
   CHECK_PARSE_ERR("(",
                   "Expected ')'");
 }
+
+TEST_CASE(solve_through_values) {
+  // A circle and a line, x^2 + y^2 = r and x - y = 1, solved for x and y
+  // from near (4, 3); r isn't an unknown, so it's still read from the param.
+  std::unique_ptr<System> sys(new System());
+  uint32_t tags[] = { 0, 0, 1 };
+  double vals[] = { 5, 1, 25 };
+  for(uint32_t i = 0; i < 3; i++) {
+    Param p = {};
+    p.h.v = i + 1;
+    p.tag = tags[i];
+    p.val = vals[i];
+    sys->param.Add(&p);
+  }
+  Expr *x = Expr::From(hParam { 1 }),
+       *y = Expr::From(hParam { 2 }),
+       *r = Expr::From(hParam { 3 });
+  Expr *eqs[] = {
+    x->Square()->Plus(y->Square())->Minus(r),
+    x->Minus(y)->Minus(Expr::From(1.0)),
+  };
+  for(uint32_t i = 0; i < 2; i++) {
+    Equation e = {};
+    e.h.v = i + 1;
+    e.e = eqs[i];
+    sys->eq.Add(&e);
+  }
+
+  // Read through the params, and through the unknowns' values, the
+  // equations are the same.
+  CHECK_TRUE(sys->WriteJacobian(0));
+  CHECK_TRUE(sys->mat.n == 2 && sys->mat.m == 2);
+  Expr *ref[2];
+  for(int i = 0; i < 2; i++) {
+    ref[i] = eqs[i]->DeepCopyWithParamsAsPointers(&sys->param, &sys->param);
+    CHECK_TRUE(sys->mat.B.sym[i]->Eval() == ref[i]->Eval());
+  }
+
+  CHECK_TRUE(sys->NewtonSolve(0));
+  CHECK_EQ_EPS(sys->param.FindById(hParam { 1 })->val, 4);
+  CHECK_EQ_EPS(sys->param.FindById(hParam { 2 })->val, 3);
+  CHECK_TRUE(sys->param.FindById(hParam { 3 })->val == 25);
+  for(int i = 0; i < 2; i++) {
+    CHECK_TRUE(fabs(ref[i]->Eval()) < System::CONVERGE_TOLERANCE);
+    CHECK_TRUE(sys->mat.B.sym[i]->Eval() == ref[i]->Eval());
+  }
+  sys->Clear();
+}
@@ -0,0 +1,152 @@
+#include "harness.h"
+
+static Param MakeParam(uint32_t v) {
+    Param p = {};
+    p.h.v = v;
+    p.val = (double)v;
+    return p;
+}
+
+// Every element can be found by its id, and iterating gives them in order
+// of id.
+static bool IsConsistent(IdList<Param, hParam> *l, const std::vector<uint32_t> &ids) {
+    std::vector<uint32_t> sorted = ids;
+    std::sort(sorted.begin(), sorted.end());
+    if(l->n != (int)sorted.size()) return false;
+
+    for(uint32_t v : sorted) {
+        Param *p = l->FindByIdNoOops(hParam { v });
+        if(p == nullptr || p->h.v != v || p->val != (double)v) return false;
+    }
+    size_t i = 0;
+    for(Param &p : *l) {
+        if(i >= sorted.size() || p.h.v != sorted[i]) return false;
+        i++;
+    }
+    return i == sorted.size();
+}
+
+TEST_CASE(add) {
+    IdList<Param, hParam> l = {};
+    std::vector<uint32_t> ids;
+    for(uint32_t v : { 5, 1, 9, 3, 7 }) {
+        Param p = MakeParam(v);
+        l.Add(&p);
+        ids.push_back(v);
+        CHECK_TRUE(IsConsistent(&l, ids));
+    }
+    CHECK_TRUE(l.FindByIdNoOops(hParam { 2 }) == nullptr);
+
+    Param p = {};
+    hParam h = l.AddAndAssignId(&p);
+    CHECK_TRUE(h.v == 10);
+    CHECK_TRUE(l.FindById(h)->h.v == 10);
+    l.Clear();
+}
+
+TEST_CASE(add_unsorted) {
+    IdList<Param, hParam> l = {};
+    std::vector<uint32_t> ids;
+    for(uint32_t v = 100; v > 3; v -= 3) {
+        Param p = MakeParam(v);
+        l.AddUnsorted(&p);
+        ids.push_back(v);
+        // Found by id right away, before being sorted into place.
+        CHECK_TRUE(l.FindByIdNoOops(p.h) != nullptr);
+    }
+    // Iterating sorts them.
+    CHECK_TRUE(IsConsistent(&l, ids));
+    CHECK_TRUE(l.MaximumId() == 100);
+    l.Clear();
+}
+
+TEST_CASE(remove_tagged_reuses_freed) {
+    IdList<Param, hParam> l = {};
+    std::vector<uint32_t> ids;
+    for(uint32_t v = 1; v <= 20; v++) {
+        Param p = MakeParam(v);
+        l.Add(&p);
+    }
+    l.ClearTags();
+    std::set<Param *> freed;
+    for(uint32_t v = 1; v <= 20; v++) {
+        if(v % 3 == 0) {
+            l.Tag(hParam { v }, 1);
+            freed.insert(l.FindById(hParam { v }));
+        } else {
+            ids.push_back(v);
+        }
+    }
+    l.RemoveTagged();
+    CHECK_TRUE(IsConsistent(&l, ids));
+    for(uint32_t v = 3; v <= 18; v += 3) {
+        CHECK_TRUE(l.FindByIdNoOops(hParam { v }) == nullptr);
+    }
+
+    // The freed elements are used again, by both kinds of add.
+    for(uint32_t v = 30; v < 36; v++) {
+        Param p = MakeParam(v);
+        if(v % 2 == 0) {
+            l.Add(&p);
+        } else {
+            l.AddUnsorted(&p);
+        }
+        ids.push_back(v);
+        CHECK_TRUE(freed.count(l.FindById(p.h)) == 1);
+    }
+    CHECK_TRUE(IsConsistent(&l, ids));
+
+    l.RemoveById(hParam { 31 });
+    ids.erase(std::find(ids.begin(), ids.end(), 31));
+    CHECK_TRUE(IsConsistent(&l, ids));
+    l.Clear();
+}
+
+TEST_CASE(find_across_growth) {
+    // Enough elements to grow the hash table many times over, with ids that
+    // differ only in their high bits, like the handles of entities do.
+    IdList<Param, hParam> l = {};
+    std::vector<uint32_t> ids;
+    for(uint32_t i = 0; i < 5000; i++) {
+        Param p = MakeParam((i << 16) | 1);
+        if(i % 2 == 0) {
+            l.Add(&p);
+        } else {
+            l.AddUnsorted(&p);
+        }
+        ids.push_back(p.h.v);
+        CHECK_TRUE(l.FindByIdNoOops(p.h) != nullptr);
+        CHECK_TRUE(l.FindByIdNoOops(hParam { p.h.v + 1 }) == nullptr);
+    }
+    CHECK_TRUE(IsConsistent(&l, ids));
+    l.Clear();
+}
+
+TEST_CASE(add_mixed_then_iterate) {
+    // Sorted adds in between unsorted ones sort those first; and lookups,
+    // which don't sort, find everything either way.
+    IdList<Param, hParam> l = {};
+    std::vector<uint32_t> ids;
+    uint32_t v = 1;
+    for(int round = 0; round < 10; round++) {
+        for(int i = 0; i < 7; i++) {
+            v = (v * 37) % 1009;
+            Param p = MakeParam(v);
+            if(i == 3) {
+                l.Add(&p);
+            } else {
+                l.AddUnsorted(&p);
+            }
+            ids.push_back(v);
+        }
+        for(uint32_t id : ids) {
+            CHECK_TRUE(l.FindByIdNoOops(hParam { id }) != nullptr);
+        }
+        if(round % 3 == 0) {
+            CHECK_TRUE(IsConsistent(&l, ids));
+        }
+    }
+    CHECK_TRUE(IsConsistent(&l, ids));
+    CHECK_TRUE(l.MaximumId() == *std::max_element(ids.begin(), ids.end()));
+    l.Clear();
+}
@@ -0,0 +1,397 @@
+#include "harness.h"
+
+static void AddTriangle(SMesh *m, double ax, double ay, double bx, double by,
+                        double cx, double cy) {
+    STriMeta meta = { 1, RGBi(255, 255, 255) };
+    m->AddTriangle(meta, Vector::From(ax, ay, 0), Vector::From(bx, by, 0),
+                   Vector::From(cx, cy, 0));
+}
+
+// The reference, which searches the kd-tree for every vertex.
+static void SnapWithKdTree(SMesh *m, SMesh *dest) {
+    SKdNode *root = SKdNode::From(m);
+    root->SnapToMesh(m);
+    root->ClearTags();
+    root->MakeMeshInto(dest);
+}
+
+static double Area(const SMesh &m) {
+    double area = 0.0;
+    for(const STriangle &tr : m.l) {
+        area += tr.Area();
+    }
+    return area;
+}
+
+// No vertex may lie on an edge of any triangle, other than at its ends.
+static bool IsVertexToVertex(const SMesh &m) {
+    for(const STriangle &tr : m.l) {
+        for(int i = 0; i < 3; i++) {
+            Vector a = tr.vertices[i], b = tr.vertices[(i + 1) % 3];
+            for(const STriangle &other : m.l) {
+                for(const Vector &v : other.vertices) {
+                    if(v.Equals(a) || v.Equals(b)) continue;
+                    if(v.OnLineSegment(a, b)) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static bool ContainsTriangle(const SMesh &m, const STriangle &tr) {
+    for(const STriangle &other : m.l) {
+        for(int i = 0; i < 3; i++) {
+            if(other.a.Equals(tr.vertices[i]) &&
+               other.b.Equals(tr.vertices[(i + 1) % 3]) &&
+               other.c.Equals(tr.vertices[(i + 2) % 3])) return true;
+        }
+    }
+    return false;
+}
+
+TEST_CASE(snap_t_junction) {
+    // A square, with the vertex in the middle of the diagonal only on one
+    // side of it.
+    SMesh m = {};
+    AddTriangle(&m, 0, 0, 2, 0, 0, 2);
+    AddTriangle(&m, 2, 0, 2, 2, 1, 1);
+    AddTriangle(&m, 1, 1, 2, 2, 0, 2);
+
+    SMesh ref = {}, snapped = {};
+    snapped.MakeFromCopyOf(&m);
+    SnapWithKdTree(&m, &ref);
+    snapped.SnapToVertices();
+
+    CHECK_TRUE(snapped.l.n == 4);
+    CHECK_TRUE(ref.l.n == snapped.l.n);
+    for(const STriangle &tr : ref.l) {
+        CHECK_TRUE(ContainsTriangle(snapped, tr));
+    }
+    CHECK_TRUE(IsVertexToVertex(snapped));
+}
+
+TEST_CASE(snap_many_on_edge) {
+    SMesh m = {};
+    AddTriangle(&m, 0, 0, 4, 0, 0, 4);
+    AddTriangle(&m, 4, 0, 4, 4, 3, 1);
+    AddTriangle(&m, 3, 1, 4, 4, 2, 2);
+    AddTriangle(&m, 2, 2, 4, 4, 1, 3);
+    AddTriangle(&m, 1, 3, 4, 4, 0, 4);
+    // And one more, with a vertex that's within LENGTH_EPS of another.
+    AddTriangle(&m, 4, 0, 8, 0, 4, 4 + LENGTH_EPS / 10);
+
+    SMesh ref = {}, snapped = {};
+    snapped.MakeFromCopyOf(&m);
+    SnapWithKdTree(&m, &ref);
+    snapped.SnapToVertices();
+
+    CHECK_TRUE(ref.l.n == snapped.l.n);
+    CHECK_EQ_EPS(Area(snapped), Area(ref));
+    CHECK_TRUE(IsVertexToVertex(ref));
+    CHECK_TRUE(IsVertexToVertex(snapped));
+    for(const STriangle &tr : snapped.l) {
+        for(const Vector &v : tr.vertices) {
+            if(v.Equals(Vector::From(4, 4, 0))) {
+                CHECK_TRUE(v.EqualsExactly(Vector::From(4, 4, 0)));
+            }
+        }
+    }
+}
+
+// A box from lo to hi, two triangles to each side. The sides are faces
+// face to face + 5, and side skip is left out.
+static void AddBox(SMesh *m, Vector lo, Vector hi, uint32_t face, int skip = -1) {
+    for(int s = 0; s < 6; s++) {
+        if(s == skip) continue;
+        int ax = s / 2, u = (ax + 1) % 3, v = (ax + 2) % 3;
+        bool top = (s % 2 == 1);
+        Vector p[4];
+        for(int i = 0; i < 4; i++) {
+            double e[3];
+            e[ax] = top ? hi.Element(ax) : lo.Element(ax);
+            e[u]  = (i == 1 || i == 2) ? hi.Element(u) : lo.Element(u);
+            e[v]  = (i >= 2) ? hi.Element(v) : lo.Element(v);
+            p[i] = Vector::From(e[0], e[1], e[2]);
+        }
+        STriMeta meta = { face + s, RGBi(255, 255, 255) };
+        if(top) {
+            m->AddTriangle(meta, p[0], p[1], p[2]);
+            m->AddTriangle(meta, p[0], p[2], p[3]);
+        } else {
+            m->AddTriangle(meta, p[0], p[2], p[1]);
+            m->AddTriangle(meta, p[0], p[3], p[2]);
+        }
+    }
+}
+
+static bool ContainsEdge(const SEdgeList &el, const SEdge &e) {
+    for(const SEdge &other : el.l) {
+        if(other.a.Equals(e.a) && other.b.Equals(e.b)) return true;
+    }
+    return false;
+}
+
+// The mesh check must find the same edges as the kd-tree does.
+static bool CheckMatchesKdTree(SMesh *m, SMeshCheck *mc) {
+    SEdgeList ref = {}, sel = {};
+    bool refInter, refLeaky, inter, leaky;
+    SKdNode::From(m)->MakeCertainEdgesInto(&ref, EdgeKind::NAKED_OR_SELF_INTER,
+        /*coplanarIsInter=*/true, &refInter, &refLeaky);
+    mc->Check(m, /*coplanarIsInter=*/true, &sel, &inter, &leaky);
+
+    bool ok = (ref.l.n == sel.l.n && refInter == inter && refLeaky == leaky);
+    for(const SEdge &e : ref.l) {
+        if(!ContainsEdge(sel, e)) ok = false;
+    }
+    ref.Clear();
+    sel.Clear();
+    return ok;
+}
+
+TEST_CASE(check_naked_and_intersecting) {
+    SMeshCheck mc = {};
+    SMesh m = {};
+    AddBox(&m, Vector::From(0, 0, 0), Vector::From(10, 10, 10), 10);
+    CHECK_TRUE(CheckMatchesKdTree(&m, &mc));
+    CHECK_TRUE(mc.naked.empty());
+
+    // A second box through the first, and then one side of the first
+    // missing, checked starting from what was found before.
+    AddBox(&m, Vector::From(5, 5, 5), Vector::From(15, 15, 15), 20);
+    CHECK_TRUE(CheckMatchesKdTree(&m, &mc));
+
+    SMesh moved = {};
+    AddBox(&moved, Vector::From(0, 0, 0), Vector::From(10, 10, 10), 10, /*skip=*/3);
+    AddBox(&moved, Vector::From(5, -2, 5), Vector::From(15, 4, 15), 20);
+    CHECK_TRUE(CheckMatchesKdTree(&moved, &mc));
+    CHECK_TRUE(!mc.naked.empty());
+
+    // Moving the second box away leaves only the naked edges.
+    SMesh away = {};
+    AddBox(&away, Vector::From(0, 0, 0), Vector::From(10, 10, 10), 10, /*skip=*/3);
+    AddBox(&away, Vector::From(20, 20, 20), Vector::From(25, 25, 25), 20);
+    CHECK_TRUE(CheckMatchesKdTree(&away, &mc));
+    mc.Clear();
+    CHECK_TRUE(CheckMatchesKdTree(&away, &mc));
+
+    m.Clear();
+    moved.Clear();
+    away.Clear();
+}
+
+TEST_CASE(face_ranges) {
+    // Two boxes, with the triangles of their faces interleaved, and one of
+    // them transparent.
+    SMesh a = {}, b = {}, m = {};
+    AddBox(&a, Vector::From(0, 0, 0), Vector::From(10, 10, 10), 10);
+    AddBox(&b, Vector::From(20, 0, 0), Vector::From(30, 10, 10), 20);
+    for(int i = 0; i < a.l.n; i++) {
+        m.AddTriangle(&a.l[i]);
+        STriangle tr = b.l[i];
+        tr.meta.color = RgbaColor::From(255, 0, 0, 128);
+        m.AddTriangle(&tr);
+    }
+    SMesh unindexed = {};
+    unindexed.MakeFromCopyOf(&m);
+
+    m.PrecomputeTransparency();
+    CHECK_TRUE(m.isTransparent);
+    CHECK_TRUE(m.faceRanges.size() == 12);
+    for(int i = 0; i < m.l.n; i++) {
+        CHECK_TRUE((m.l[i].meta.color.alpha == 255) == (i < a.l.n));
+    }
+
+    std::vector<uint32_t> faces = { 11, 23 };
+    int n = 0;
+    m.ForEachTriangleOf(faces, [&](const STriangle &tr) {
+        CHECK_TRUE(tr.meta.face == 11 || tr.meta.face == 23);
+        n++;
+    });
+    CHECK_TRUE(n == 4);
+
+    // Picking through the face ranges finds what testing every triangle does.
+    for(double x = -5; x < 35; x += 2.5) {
+        Vector rayPoint = Vector::From(x, 3, 50),
+               rayDir   = Vector::From(0.1, 0.05, -1);
+        double t = VERY_NEGATIVE, refT = VERY_NEGATIVE;
+        uint32_t face    = m.FirstIntersectionWith(rayPoint, rayDir, &t),
+                 refFace = unindexed.FirstIntersectionWith(rayPoint, rayDir, &refT);
+        CHECK_TRUE(face == refFace);
+        CHECK_TRUE(t == refT);
+    }
+
+    a.Clear();
+    b.Clear();
+    m.Clear();
+    unindexed.Clear();
+}
+
+// Writes the mesh out the way exporting it as a triangle mesh does.
+static bool ExportMesh(SMesh *m, const Platform::Path &path) {
+    MeshFileWriter *out = MeshFileWriter::ForFile(path);
+    if(!out) return false;
+    if(!out->StartFile()) {
+        fclose(out->f);
+        return false;
+    }
+    out->OutputMesh(m);
+    out->FinishAndCloseFile();
+    return true;
+}
+
+static std::vector<std::string> LinesStartingWith(const std::string &data,
+                                                  const std::string &prefix) {
+    std::vector<std::string> lines;
+    size_t pos = 0;
+    while(pos < data.size()) {
+        size_t end = data.find('\n', pos);
+        if(end == std::string::npos) end = data.size();
+        std::string line = data.substr(pos, end - pos);
+        if(line.compare(0, prefix.size(), prefix) == 0) lines.push_back(line);
+        pos = end + 1;
+    }
+    return lines;
+}
+
+static bool FloatsAre(const char *data, Vector v) {
+    float w[3];
+    memcpy(w, data, sizeof(w));
+    return w[0] == (float)v.x && w[1] == (float)v.y && w[2] == (float)v.z;
+}
+
+TEST_CASE(export_stl_obj_ply) {
+    // A box has 12 triangles, 8 vertices and, shaded flat, 6 normals.
+    SMesh m = {};
+    AddBox(&m, Vector::From(0, 0, 0), Vector::From(10, 20, 30), 10);
+    const STriangle &first = m.l[0];
+    Vector normal = first.Normal().WithMagnitude(1);
+    SS.exportScale = 1.0;
+
+    Platform::Path stlPath = helper->GetAssetPath(__FILE__, "box.stl", "out");
+    std::string stl;
+    CHECK_TRUE(ExportMesh(&m, stlPath));
+    CHECK_TRUE(ReadFile(stlPath, &stl));
+    RemoveFile(stlPath);
+    CHECK_TRUE(stl.size() == 84 + 12 * 50);
+    uint32_t stlCount;
+    memcpy(&stlCount, &stl[80], 4);
+    CHECK_TRUE(stlCount == 12);
+    CHECK_TRUE(FloatsAre(&stl[84], normal));
+    CHECK_TRUE(FloatsAre(&stl[84 + 12], first.a));
+    CHECK_TRUE(FloatsAre(&stl[84 + 24], first.b));
+    CHECK_TRUE(FloatsAre(&stl[84 + 36], first.c));
+
+    Platform::Path objPath = helper->GetAssetPath(__FILE__, "box.obj", "out"),
+                   mtlPath = objPath.WithExtension("mtl");
+    std::string obj, mtl;
+    CHECK_TRUE(ExportMesh(&m, objPath));
+    CHECK_TRUE(ReadFile(objPath, &obj));
+    CHECK_TRUE(ReadFile(mtlPath, &mtl));
+    RemoveFile(objPath);
+    RemoveFile(mtlPath);
+    std::vector<std::string> v  = LinesStartingWith(obj, "v "),
+                             vn = LinesStartingWith(obj, "vn "),
+                             f  = LinesStartingWith(obj, "f "),
+                             mtllib = LinesStartingWith(obj, "mtllib ");
+    CHECK_TRUE(v.size() == 8);
+    CHECK_TRUE(vn.size() == 6);
+    CHECK_TRUE(f.size() == 12);
+    CHECK_TRUE(mtllib.size() == 1);
+    CHECK_EQ_STR(mtllib[0], "mtllib " + mtlPath.FileName());
+    CHECK_EQ_STR(v[0], ssprintf("v %.10f %.10f %.10f", CO(first.a)));
+    CHECK_EQ_STR(vn[0], ssprintf("vn %.10f %.10f %.10f", CO(normal)));
+    CHECK_EQ_STR(f[0], "f 1//1 2//1 3//1");
+    CHECK_TRUE(LinesStartingWith(obj, "usemtl ").size() == 1);
+    CHECK_TRUE(LinesStartingWith(mtl, "newmtl hffffff").size() == 1);
+
+    Platform::Path plyPath = helper->GetAssetPath(__FILE__, "box.ply", "out");
+    std::string ply;
+    CHECK_TRUE(ExportMesh(&m, plyPath));
+    CHECK_TRUE(ReadFile(plyPath, &ply));
+    RemoveFile(plyPath);
+    CHECK_TRUE(LinesStartingWith(ply, "element vertex ").size() == 1);
+    CHECK_EQ_STR(LinesStartingWith(ply, "element vertex ")[0],
+                 "element vertex 0000000008");
+    CHECK_EQ_STR(LinesStartingWith(ply, "element face ")[0],
+                 "element face 0000000012");
+    size_t body = ply.find("end_header\n");
+    CHECK_TRUE(body != std::string::npos);
+    body += strlen("end_header\n");
+    CHECK_TRUE(ply.size() == body + 8 * 12 + 12 * 16);
+    CHECK_TRUE(FloatsAre(&ply[body], first.a));
+    CHECK_TRUE(FloatsAre(&ply[body + 12], first.b));
+    CHECK_TRUE(FloatsAre(&ply[body + 24], first.c));
+    const char *face = &ply[body + 8 * 12];
+    uint32_t vi[3];
+    memcpy(vi, face + 1, sizeof(vi));
+    CHECK_TRUE(face[0] == 3);
+    CHECK_TRUE(vi[0] == 0 && vi[1] == 1 && vi[2] == 2);
+    CHECK_TRUE((uint8_t)face[13] == 255 && (uint8_t)face[14] == 255 &&
+               (uint8_t)face[15] == 255);
+
+    m.Clear();
+}
+
+// A height field over a square grid of n by n cells, each of size step.
+static void AddHeightField(SMesh *m, int n, double step,
+                           std::function<double(double, double)> height) {
+    auto at = [&](int i, int j) {
+        double x = i * step, y = j * step;
+        return Vector::From(x, y, height(x, y));
+    };
+    STriMeta meta = { 1, RGBi(255, 255, 255) };
+    for(int i = 0; i < n; i++) {
+        for(int j = 0; j < n; j++) {
+            m->AddTriangle(meta, at(i, j), at(i + 1, j), at(i + 1, j + 1));
+            m->AddTriangle(meta, at(i, j), at(i + 1, j + 1), at(i, j + 1));
+        }
+    }
+}
+
+// How far above or below the decimated height field the vertex is.
+static double HeightAbove(const SMesh &m, Vector p) {
+    Vector z = Vector::From(0, 0, 1);
+    for(const STriangle &tr : m.l) {
+        if(!tr.ContainsPointProjd(z, p)) continue;
+        Vector n = tr.Normal();
+        double h = tr.a.z - (n.x * (p.x - tr.a.x) + n.y * (p.y - tr.a.y)) / n.z;
+        return fabs(p.z - h);
+    }
+    return VERY_POSITIVE;
+}
+
+TEST_CASE(decimate) {
+    const double tol = 0.01;
+
+    // A flat grid keeps only its boundary, which is naked.
+    SMesh flat = {}, flatDecimated = {};
+    AddHeightField(&flat, 10, 1.0, [](double x, double y) { return 0.0; });
+    flatDecimated.MakeFromDecimationOf(&flat, tol);
+    CHECK_TRUE(flatDecimated.l.n < flat.l.n / 4);
+    CHECK_EQ_EPS(Area(flatDecimated), Area(flat));
+
+    // A gently curved one loses fewer triangles, and no vertex of either
+    // mesh may end up farther than the tolerance from the other.
+    SMesh curved = {}, curvedDecimated = {};
+    AddHeightField(&curved, 20, 0.5,
+                   [](double x, double y) { return 0.01 * (x * x + y * y); });
+    curvedDecimated.MakeFromDecimationOf(&curved, tol);
+    CHECK_TRUE(curvedDecimated.l.n < curved.l.n);
+    CHECK_TRUE(curvedDecimated.l.n > flatDecimated.l.n);
+    for(const STriangle &tr : curved.l) {
+        for(const Vector &v : tr.vertices) {
+            CHECK_TRUE(HeightAbove(curvedDecimated, v) < tol + LENGTH_EPS);
+        }
+    }
+    for(const STriangle &tr : curvedDecimated.l) {
+        for(const Vector &v : tr.vertices) {
+            CHECK_TRUE(HeightAbove(curved, v) < LENGTH_EPS);
+        }
+    }
+
+    flat.Clear();
+    flatDecimated.Clear();
+    curved.Clear();
+    curvedDecimated.Clear();
+}
@@ -0,0 +1,91 @@
+#include "harness.h"
+
+static void Solve() {
+    Profile::Scope scope("Solve");
+}
+
+static void Generate() {
+    Profile::Scope scope("Generate");
+    for(int i = 0; i < 3; i++) {
+        Solve();
+    }
+    Profile::Count("triangles", 12);
+    Profile::Count("triangles", 42);
+}
+
+TEST_CASE(nothing_recorded_unless_enabled) {
+    Profile::SetEnabled(false);
+    Profile::Clear();
+    Generate();
+    Profile::EndFrame();
+    CHECK_TRUE(Profile::LastFrame().lines.empty());
+}
+
+TEST_CASE(frame_breakdown) {
+    Profile::SetEnabled(true);
+    Profile::Clear();
+    Generate();
+    {
+        Profile::Scope scope("Draw");
+    }
+    Profile::EndFrame();
+    Profile::SetEnabled(false);
+
+    Profile::Frame frame = Profile::LastFrame();
+    CHECK_TRUE(frame.lines.size() == 3);
+    CHECK_EQ_STR(frame.lines[0].name, "Generate");
+    CHECK_TRUE(frame.lines[0].depth == 0 && frame.lines[0].calls == 1);
+    CHECK_EQ_STR(frame.lines[1].name, "Solve");
+    CHECK_TRUE(frame.lines[1].depth == 1 && frame.lines[1].calls == 3);
+    CHECK_TRUE(frame.lines[1].micros <= frame.lines[0].micros);
+    CHECK_EQ_STR(frame.lines[2].name, "Draw");
+    CHECK_TRUE(frame.lines[2].depth == 0 && frame.lines[2].calls == 1);
+    CHECK_TRUE(frame.lines[0].micros + frame.lines[2].micros <= frame.micros);
+
+    CHECK_TRUE(frame.counters.size() == 1);
+    CHECK_EQ_STR(frame.counters[0].name, "triangles");
+    CHECK_TRUE(frame.counters[0].value == 42);
+}
+
+TEST_CASE(frames_are_separate) {
+    Profile::SetEnabled(true);
+    Profile::Clear();
+    Generate();
+    Profile::EndFrame();
+    Solve();
+    Profile::EndFrame();
+    Profile::SetEnabled(false);
+
+    Profile::Frame frame = Profile::LastFrame();
+    CHECK_TRUE(frame.lines.size() == 1);
+    CHECK_EQ_STR(frame.lines[0].name, "Solve");
+    CHECK_TRUE(frame.lines[0].depth == 0 && frame.lines[0].calls == 1);
+    CHECK_TRUE(frame.counters.empty());
+}
+
+TEST_CASE(same_scope_under_different_parents) {
+    // All of these start within a few microseconds of each other, many of
+    // them within the same one; each Solve still goes under its own parent.
+    Profile::SetEnabled(true);
+    Profile::Clear();
+    for(int i = 0; i < 100; i++) {
+        Generate();
+        {
+            Profile::Scope scope("Draw");
+            Solve();
+        }
+    }
+    Profile::EndFrame();
+    Profile::SetEnabled(false);
+
+    Profile::Frame frame = Profile::LastFrame();
+    CHECK_TRUE(frame.lines.size() == 4);
+    CHECK_EQ_STR(frame.lines[0].name, "Generate");
+    CHECK_TRUE(frame.lines[0].depth == 0 && frame.lines[0].calls == 100);
+    CHECK_EQ_STR(frame.lines[1].name, "Solve");
+    CHECK_TRUE(frame.lines[1].depth == 1 && frame.lines[1].calls == 300);
+    CHECK_EQ_STR(frame.lines[2].name, "Draw");
+    CHECK_TRUE(frame.lines[2].depth == 0 && frame.lines[2].calls == 100);
+    CHECK_EQ_STR(frame.lines[3].name, "Solve");
+    CHECK_TRUE(frame.lines[3].depth == 1 && frame.lines[3].calls == 100);
+}
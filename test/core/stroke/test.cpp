@@ -0,0 +1,115 @@
+#include "harness.h"
+
+// The reference, which expands the edges one after another, carrying the
+// stipple phase along.
+static void MakeEdgeVerticesSerially(const SEdgeList &edges,
+                                     std::vector<EdgeVertex> *vertices,
+                                     std::vector<uint32_t> *indices) {
+    double phase = 0.0;
+    for(int i = 0; i < edges.l.n; i++) {
+        const SEdge &curr = edges.l[i];
+        const SEdge &next = edges.l[(i + 1) % edges.l.n];
+
+        Vector3f a   = Vector3f::From(curr.a);
+        Vector3f b   = Vector3f::From(curr.b);
+        Vector3f tan = Vector3f::From(curr.b.Minus(curr.a));
+        double len = curr.b.Minus(curr.a).Magnitude();
+
+        uint32_t v = (uint32_t)vertices->size();
+        const float locs[8][3] = {
+            { -1.0f, -1.0f, float(phase) },       { -1.0f, +1.0f, float(phase) },
+            {  0.0f, -1.0f, float(phase) },       {  0.0f, +1.0f, float(phase) },
+            {  0.0f, +1.0f, float(phase + len) }, {  0.0f, -1.0f, float(phase + len) },
+            { +1.0f, +1.0f, float(phase + len) }, { +1.0f, -1.0f, float(phase + len) },
+        };
+        for(int j = 0; j < 8; j++) {
+            EdgeVertex ev;
+            ev.pos = (j < 4) ? a : b;
+            ev.loc = Vector3f::From(locs[j][0], locs[j][1], locs[j][2]);
+            ev.tan = tan;
+            vertices->push_back(ev);
+        }
+        for(uint32_t k : { 0, 1, 2, 1, 2, 3,  2, 3, 4, 2, 4, 5,  4, 5, 6, 5, 6, 7 }) {
+            indices->push_back(v + k);
+        }
+
+        if(curr.a.EqualsExactly(next.a) || curr.a.EqualsExactly(next.b) ||
+           curr.b.EqualsExactly(next.a) || curr.b.EqualsExactly(next.b)) {
+            phase += len;
+        } else {
+            phase = 0.0;
+        }
+    }
+}
+
+// Chains of random length, some closed, with some lone edges in between.
+static void MakeChains(SEdgeList *el, int count) {
+    srand(1);
+    auto random = []() { return (double)(rand() % 2000) / 100.0 - 10.0; };
+    while(el->l.n < count) {
+        int length = rand() % 6 + 1;
+        Vector first = Vector::From(random(), random(), random()),
+               prev  = first;
+        for(int i = 0; i < length; i++) {
+            Vector next = (i == length - 1 && length > 2 && rand() % 2)
+                          ? first : Vector::From(random(), random(), random());
+            el->AddEdge(prev, next);
+            prev = next;
+        }
+    }
+}
+
+static bool SameVector(const Vector3f &a, const Vector3f &b) {
+    return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+TEST_CASE(edges_match_serial) {
+    for(int count : { 0, 1, 2, 1000, 20000 }) {
+        SEdgeList el = {};
+        MakeChains(&el, count);
+
+        std::vector<EdgeVertex> vertices, refVertices;
+        std::vector<uint32_t>   indices,  refIndices;
+        MakeEdgeVertices(el, &vertices, &indices);
+        MakeEdgeVerticesSerially(el, &refVertices, &refIndices);
+
+        CHECK_TRUE(vertices.size() == refVertices.size());
+        CHECK_TRUE(indices == refIndices);
+        bool same = true;
+        for(size_t i = 0; i < vertices.size(); i++) {
+            same = same && SameVector(vertices[i].pos, refVertices[i].pos) &&
+                           SameVector(vertices[i].loc, refVertices[i].loc) &&
+                           SameVector(vertices[i].tan, refVertices[i].tan);
+        }
+        CHECK_TRUE(same);
+        el.Clear();
+    }
+}
+
+TEST_CASE(outlines_match_edges) {
+    SEdgeList el = {};
+    MakeChains(&el, 5000);
+    SOutlineList ol = {};
+    for(const SEdge &e : el.l) {
+        ol.AddEdge(e.a, e.b, Vector::From(0, 0, 1), Vector::From(1, 0, 0), 3);
+    }
+
+    std::vector<EdgeVertex>    edgeVertices;
+    std::vector<OutlineVertex> vertices;
+    std::vector<uint32_t>      edgeIndices, indices;
+    MakeEdgeVertices(el, &edgeVertices, &edgeIndices);
+    MakeOutlineVertices(ol, &vertices, &indices);
+
+    CHECK_TRUE(indices == edgeIndices);
+    bool same = true;
+    for(size_t i = 0; i < vertices.size(); i++) {
+        const OutlineVertex &v = vertices[i];
+        const EdgeVertex &ev = edgeVertices[i];
+        same = same && SameVector(v.pos, ev.pos) && SameVector(v.tan, ev.tan) &&
+                       v.loc.x == ev.loc.x && v.loc.y == ev.loc.y && v.loc.z == ev.loc.z &&
+                       v.loc.w == 3.0f && v.nol.z == 1.0f && v.nor.x == 1.0f;
+    }
+    CHECK_TRUE(same);
+    el.Clear();
+    ol.Clear();
+}
@@ -15,3 +15,60 @@ TEST_CASE(normal_migrate_from_v22) {
     CHECK_LOAD("normal_v22.slvs");
     CHECK_SAVE("normal.slvs");
 }
+
+// How wide the linked sketch's points are spread.
+static double LinkedWidth(hGroup hg) {
+    double minX = VERY_POSITIVE, maxX = VERY_NEGATIVE;
+    for(Entity &e : SK.entity) {
+        if(e.group != hg || !e.IsPoint()) continue;
+        double x = e.PointGetNum().x;
+        minX = min(minX, x);
+        maxX = max(maxX, x);
+    }
+    return maxX - minX;
+}
+
+TEST_CASE(normal_reload_same_size) {
+    CHECK_LOAD("normal.slvs");
+
+    std::string data, changed;
+    CHECK_TRUE(ReadFile(helper->GetAssetPath(__FILE__, "rect_v20.slvs"), &data));
+    changed = data;
+    for(const char *from : { "actPoint.x=5.", "actPoint.x=-5." }) {
+        std::string to = from;
+        to[to.size() - 2] = '7';
+        for(size_t at = changed.find(from); at != std::string::npos;
+            at = changed.find(from, at + 1)) {
+            changed.replace(at, to.size(), to);
+        }
+    }
+    CHECK_TRUE(changed.size() == data.size() && changed != data);
+
+    Platform::Path linkPath = helper->GetAssetPath(__FILE__, "rect_v20.slvs", "linked");
+    CHECK_TRUE(WriteFile(linkPath, data));
+    Group *g = SK.GetGroup(*SK.groupOrder.Last());
+    CHECK_TRUE(g->type == Group::Type::LINKED);
+    hGroup hg = g->h;
+    g->linkFile = linkPath;
+    // Keep what was loaded alive, as another group linking the same file or
+    // an undo state would, so that a reload may find it instead.
+    std::shared_ptr<LinkedFile> held;
+    auto reload = [&]() {
+        held = SK.GetGroup(hg)->impFile;
+        SS.ReloadAllLinked(SS.saveFile);
+        SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    };
+    reload();
+    CHECK_EQ_EPS(LinkedWidth(hg), 10.0);
+
+    // An edit that keeps the size, made right away, is still picked up, and
+    // so is putting the old file back.
+    CHECK_TRUE(WriteFile(linkPath, changed));
+    reload();
+    CHECK_EQ_EPS(LinkedWidth(hg), 14.0);
+    CHECK_TRUE(WriteFile(linkPath, data));
+    reload();
+    CHECK_EQ_EPS(LinkedWidth(hg), 10.0);
+
+    RemoveFile(linkPath);
+}
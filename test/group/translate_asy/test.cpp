@@ -27,3 +27,251 @@ TEST_CASE(normal_inters) {
     // The assembly is supposed to interfere.
     CHECK_TRUE(inters);
 }
+
+TEST_CASE(persistent_keys) {
+    CHECK_LOAD("normal.slvs");
+
+    std::map<uint32_t, uint64_t> keys, keysAfter;
+    SS.GW.PersistentEntityKeys(&keys);
+    uint64_t solidKey = SS.GW.PersistentSolidKey();
+
+    // Regenerating without solving changes nothing that's drawn.
+    SS.GenerateAll(SolveSpaceUI::Generate::REGEN);
+    SS.GW.PersistentEntityKeys(&keysAfter);
+    CHECK_TRUE(keysAfter == keys);
+    CHECK_TRUE(SS.GW.PersistentSolidKey() == solidKey);
+
+    // Moving the translated copy changes only the last group's entities.
+    Group *g = SK.GetGroup(*SK.groupOrder.Last());
+    SK.GetParam(g->h.param(0))->val += 5.0;
+    SS.MarkGroupDirty(g->h);
+    SS.GenerateAll();
+    SS.GW.PersistentEntityKeys(&keysAfter);
+    CHECK_TRUE(keysAfter.size() == keys.size());
+    for(auto &it : keys) {
+        if(it.first == g->h.v) {
+            CHECK_TRUE(keysAfter[it.first] != it.second);
+        } else {
+            CHECK_TRUE(keysAfter[it.first] == it.second);
+        }
+    }
+    CHECK_TRUE(SS.GW.PersistentSolidKey() != solidKey);
+}
+
+TEST_CASE(normal_save_in_background) {
+    CHECK_LOAD("normal.slvs");
+
+    Platform::Path refPath = helper->GetAssetPath(__FILE__, "normal.slvs", "out"),
+                   bgPath  = helper->GetAssetPath(__FILE__, "normal.slvs", "bg");
+    CHECK_TRUE(SS.SaveToFile(refPath));
+
+    // Edit the sketch while the snapshot is being written; the file should
+    // still be what it was when the save was started.
+    SS.SaveToFileInBackground(bgPath);
+    Group *g = SK.GetGroup(*SK.groupOrder.Last());
+    SK.GetParam(g->h.param(0))->val += 5.0;
+    SS.MarkGroupDirty(g->h);
+    SS.GenerateAll();
+    SS.FinishBackgroundSave();
+
+    std::string refData, bgData;
+    CHECK_TRUE(ReadFile(refPath, &refData));
+    CHECK_TRUE(ReadFile(bgPath, &bgData));
+    RemoveFile(refPath);
+    RemoveFile(bgPath);
+    CHECK_TRUE(refData == bgData);
+    CHECK_FALSE(FileExists(Platform::Path::From(bgPath.raw + ".tmp")));
+}
+
+TEST_CASE(normal_load_through_cache) {
+    CHECK_LOAD("normal.slvs");
+
+    Platform::Path srcPath   = helper->GetAssetPath(__FILE__, "normal.slvs", "cached"),
+                   cachePath = srcPath.WithExtension(SolveSpaceUI::CACHE_EXT),
+                   refPath   = helper->GetAssetPath(__FILE__, "normal.slvs", "out");
+    CHECK_TRUE(SS.SaveToFile(srcPath));
+    CHECK_TRUE(SS.SaveToBinaryCache(cachePath, srcPath));
+
+    // The text file alone, the cache alone, and the text file with its cache
+    // next to it should all load the same sketch.
+    std::string textData, cacheData, bothData;
+    RemoveFile(cachePath);
+    CHECK_TRUE(SS.LoadFromFile(srcPath));
+    CHECK_TRUE(SS.SaveToFile(refPath));
+    CHECK_TRUE(ReadFile(refPath, &textData));
+
+    CHECK_TRUE(SS.SaveToBinaryCache(cachePath, srcPath));
+    CHECK_TRUE(SS.LoadFromFile(cachePath));
+    CHECK_TRUE(SS.SaveToFile(refPath));
+    CHECK_TRUE(ReadFile(refPath, &cacheData));
+    CHECK_TRUE(cacheData == textData);
+
+    CHECK_TRUE(SS.LoadFromFile(srcPath));
+    CHECK_TRUE(SS.SaveToFile(refPath));
+    CHECK_TRUE(ReadFile(refPath, &bothData));
+    CHECK_TRUE(bothData == textData);
+
+    // A change that keeps the size still makes the cache stale, whether or
+    // not the file's modification time has moved on since.
+    std::string srcData;
+    CHECK_TRUE(ReadFile(srcPath, &srcData));
+    size_t at = srcData.find("Group.name=translate");
+    CHECK_TRUE(at != std::string::npos);
+    srcData.replace(at, strlen("Group.name=translate"), "Group.name=translatX");
+    CHECK_TRUE(WriteFile(srcPath, srcData));
+    CHECK_TRUE(SS.LoadFromFile(srcPath));
+    CHECK_EQ_STR(SK.GetGroup(*SK.groupOrder.Last())->name, "translatX");
+
+    RemoveFile(srcPath);
+    RemoveFile(cachePath);
+    RemoveFile(refPath);
+}
+
+TEST_CASE(normal_undo_redo) {
+    CHECK_LOAD("normal.slvs");
+
+    Platform::Path outPath = helper->GetAssetPath(__FILE__, "normal.slvs", "out");
+    auto saved = [&]() {
+        std::string data;
+        SS.SaveToFile(outPath);
+        ReadFile(outPath, &data);
+        return data;
+    };
+
+    // Make more edits than are remembered, adding, changing and removing
+    // elements, so that the oldest states get evicted along the way.
+    const int edits = SolveSpaceUI::MAX_UNDO + 5;
+    Group *g = SK.GetGroup(*SK.groupOrder.Last());
+    hGroup hg = g->h;
+    hRequest hr = {};
+    std::vector<std::string> states = { saved() };
+    for(int i = 0; i < edits; i++) {
+        SS.UndoRemember();
+        switch(i % 3) {
+            case 0:
+                SK.GetParam(SK.GetGroup(hg)->h.param(0))->val += 1.0;
+                break;
+            case 1:
+                hr = SS.GW.AddRequest(Request::Type::DATUM_POINT, /*rememberForUndo=*/false);
+                break;
+            case 2:
+                SK.request.FindById(hr)->tag = 1;
+                SK.request.RemoveTagged();
+                break;
+        }
+        SS.MarkGroupDirty(hg);
+        SS.GenerateAll();
+        states.push_back(saved());
+    }
+    CHECK_TRUE(SS.undo.cnt == SolveSpaceUI::MAX_UNDO);
+
+    // Undo all the way back to the oldest state still remembered.
+    for(int i = edits - 1; i >= edits - SolveSpaceUI::MAX_UNDO; i--) {
+        SS.UndoUndo();
+        CHECK_TRUE(saved() == states[i]);
+    }
+    CHECK_TRUE(SS.undo.cnt == 0);
+    SS.UndoUndo();
+    CHECK_TRUE(saved() == states[edits - SolveSpaceUI::MAX_UNDO]);
+
+    // And redo all the way forward again.
+    for(int i = edits - SolveSpaceUI::MAX_UNDO + 1; i <= edits; i++) {
+        SS.UndoRedo();
+        CHECK_TRUE(saved() == states[i]);
+    }
+    CHECK_TRUE(SS.redo.cnt == 0);
+
+    // Undoing after a redo and a new edit goes back to before the edit.
+    SS.UndoRemember();
+    SK.GetParam(SK.GetGroup(hg)->h.param(0))->val += 1.0;
+    SS.MarkGroupDirty(hg);
+    SS.GenerateAll();
+    CHECK_TRUE(saved() != states[edits]);
+    SS.UndoUndo();
+    CHECK_TRUE(saved() == states[edits]);
+
+    RemoveFile(outPath);
+}
+
+// The same as the Sketch menu would add after the last group, without a window.
+static hGroup AddGroupAfterLast(Group::Type type, const Platform::Path &linkFile = {}) {
+    Group g = {};
+    g.visible  = true;
+    g.color    = RGBi(100, 100, 100);
+    g.scale    = 1;
+    g.type     = type;
+    g.linkFile = linkFile;
+    g.name     = type == Group::Type::LINKED ? linkFile.FileStem() : "sketch-in-3d";
+    if(type == Group::Type::LINKED) g.meshCombine = Group::CombineAs::ASSEMBLE;
+    g.order    = SK.GetGroup(*SK.groupOrder.Last())->order + 1;
+    SK.group.AddAndAssignId(&g);
+
+    if(type == Group::Type::LINKED) SS.ReloadAllLinked(SS.saveFile);
+    SS.GW.activeGroup = g.h;
+    SS.GenerateAll();
+    return g.h;
+}
+
+TEST_CASE(normal_linked_instances) {
+    CHECK_LOAD("normal.slvs");
+
+    Platform::Path partPath = helper->GetAssetPath(__FILE__, "normal.slvs", "part");
+    CHECK_TRUE(SS.SaveToFile(partPath));
+
+    // Assemble the part three times over, and sketch in 3d after that, so
+    // that the solid is drawn dimmed.
+    SS.NewFile();
+    SS.AfterNewFile();
+    for(int i = 0; i < 3; i++) {
+        hGroup hg = AddGroupAfterLast(Group::Type::LINKED, partPath);
+        SK.GetParam(hg.param(0))->val = 50.0 * i;
+    }
+    AddGroupAfterLast(Group::Type::DRAWING_3D);
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    RemoveFile(partPath);
+
+    Group *g = SK.GetGroup(SS.GW.activeGroup);
+    CHECK_TRUE(g->runningInstances.size() == 3);
+    for(int i = 0; i < 3; i++) {
+        CHECK_EQ_EPS(g->runningInstances[i].offset.x, 50.0 * i);
+    }
+
+    // Drawn as instances, each copy of the part is where its triangles are in
+    // the whole solid, and filled the same way.
+    Camera camera = {};
+    camera.pixelRatio = 1;
+    camera.width      = 600;
+    camera.height     = 600;
+    camera.projRight  = Vector::From(1, 0, 0);
+    camera.projUp     = Vector::From(0, 1, 0);
+    camera.scale      = 1.0;
+    // All of the solid is instanced.
+    CHECK_TRUE(g->displayMesh.IsEmpty());
+    SMesh *flat = g->GetDisplayMesh();
+    CHECK_TRUE(flat->l.n > 0);
+    int perPart = flat->l.n / 3;
+    for(bool dim : { true, false }) {
+        SS.GW.dimSolidModel = dim;
+        RasterRenderer canvas;
+        canvas.SetLighting(SS.GW.GetLighting());
+        canvas.SetCamera(camera);
+        g->DrawMesh(Group::DrawMeshAs::DEFAULT, &canvas);
+
+        CHECK_TRUE(canvas.mesh.l.n == flat->l.n);
+        bool samePlace = true, sameFill = true;
+        for(int i = 0; i < flat->l.n; i++) {
+            const STriangle &drawn = canvas.mesh.l[i], &tr = flat->l[i];
+            if(!drawn.a.Equals(tr.a) || !drawn.b.Equals(tr.b) || !drawn.c.Equals(tr.c)) {
+                samePlace = false;
+            }
+            // The copies are only moved, not turned, so each is shaded the
+            // same as the first one.
+            RgbaColor color = dim ? Style::Color(Style::DIM_SOLID)
+                                  : canvas.mesh.l[i % perPart].meta.color;
+            if(!drawn.meta.color.Equals(color)) sameFill = false;
+        }
+        CHECK_TRUE(samePlace);
+        CHECK_TRUE(sameFill);
+        canvas.Clear();
+    }
+}
@@ -15,3 +15,82 @@ TEST_CASE(normal_migrate_from_v22) {
     CHECK_LOAD("normal_v22.slvs");
     CHECK_SAVE("normal.slvs");
 }
+
+// The edges of the text, split one curve at a time, the way every other
+// entity's edges are made.
+static void SplitEachCurve(const std::string &str, SEdgeList *el, int auxA,
+                           Vector origin, Vector u, Vector v) {
+    SBezierList sbl = {};
+    SS.fonts.PlotString("Gentium-R.ttf", str, &sbl, origin, u, v);
+    for(int i = 0; i < sbl.l.n; i++) {
+        List<Vector> lv = {};
+        sbl.l[i].MakePwlInto(&lv);
+        for(int j = 1; j < lv.n; j++) {
+            el->AddEdge(lv[j-1], lv[j], auxA, i);
+        }
+        lv.Clear();
+    }
+    sbl.Clear();
+}
+
+static bool SameEdges(const SEdgeList &a, const SEdgeList &b) {
+    if(a.l.n != b.l.n) return false;
+    for(int i = 0; i < a.l.n; i++) {
+        if(!a.l[i].a.EqualsExactly(b.l[i].a) || !a.l[i].b.EqualsExactly(b.l[i].b) ||
+           a.l[i].auxA != b.l[i].auxA || a.l[i].auxB != b.l[i].auxB) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE(normal_edges_cached) {
+    CHECK_LOAD("normal.slvs");
+
+    Entity *e = NULL;
+    for(Entity &te : SK.entity) {
+        if(te.type == Entity::Type::TTF_TEXT) e = &te;
+    }
+    CHECK_TRUE(e != NULL);
+
+    // The entity's own edges, made once to fill the cache and once from it,
+    // are the same as if each curve was split on its own.
+    Vector topLeft = SK.GetEntity(e->point[0])->PointGetNum(),
+           botLeft = SK.GetEntity(e->point[1])->PointGetNum();
+    Vector n = e->Normal()->NormalN();
+    Vector v = topLeft.Minus(botLeft),
+           u = v.Cross(n).WithMagnitude(v.Magnitude());
+    int auxA = Style::ForEntity(e->h).v;
+    SEdgeList split = {}, first = {}, again = {};
+    SplitEachCurve(e->str, &split, auxA, botLeft, u, v);
+    e->GenerateEdges(&first);
+    e->GenerateEdges(&again);
+    CHECK_TRUE(split.l.n > 0);
+    CHECK_TRUE(SameEdges(first, split));
+    CHECK_TRUE(SameEdges(again, split));
+    split.Clear();
+    first.Clear();
+    again.Clear();
+
+    // And so are those of other strings, sizes and orientations, including
+    // stretched text, which isn't cached. Small text is split only as finely
+    // as every curve is, so the bigger sizes are what check the tolerance.
+    struct Placement { const char *str; Vector origin, u, v; };
+    Placement placements[] = {
+        { "Text",       Vector::From(0, 0, 0),  Vector::From(1, 0, 0),    Vector::From(0, 1, 0) },
+        { "Text",       Vector::From(5, -3, 0), Vector::From(400, 0, 0),  Vector::From(0, 400, 0) },
+        { "tx, Tê!",    Vector::From(1, 2, 3),  Vector::From(0, 70, 0),   Vector::From(-70, 0, 0) },
+        { "tx, Tê!",    Vector::From(1, 2, 3),  Vector::From(0, 0, 3000), Vector::From(3000, 0, 0) },
+        { "Stretched",  Vector::From(0, 0, 0),  Vector::From(200, 0, 0),  Vector::From(0, 50, 0) },
+    };
+    for(const Placement &p : placements) {
+        for(int pass = 0; pass < 2; pass++) {
+            SEdgeList cached = {};
+            SS.fonts.PlotEdges("Gentium-R.ttf", p.str, &cached, 0, p.origin, p.u, p.v);
+            SplitEachCurve(p.str, &split, 0, p.origin, p.u, p.v);
+            CHECK_TRUE(SameEdges(cached, split));
+            cached.Clear();
+            split.Clear();
+        }
+    }
+}